@@ -0,0 +1,214 @@
+#include "Batch.h"
+#include "CommandProcessing.h"
+#include "GameEngine.h"
+#include "QuietConsole.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+
+Batch::Batch(const Options& options)
+    : options(options)
+    , scripts(find(options.scripts))
+    , seconds(0) {
+    if (this->scripts.empty()) {
+        throw std::invalid_argument("No script matches " + options.scripts);
+    }
+    if (this->options.workers == 0) {
+        this->options.workers = ThreadPool::defaultSize();
+    }
+}
+
+std::vector<std::string> Batch::find(const std::string& pattern) {
+    namespace fs = std::filesystem;
+    std::vector<std::string> found;
+    std::error_code error;
+    fs::path path(pattern);
+    if (fs::is_directory(path, error)) {
+        for (const auto& entry : fs::directory_iterator(path, error)) {
+            if (entry.is_regular_file(error)) {
+                found.push_back(entry.path().string());
+            }
+        }
+    } else {
+        std::string name = path.filename().string();
+        fs::path directory = path.has_parent_path() ? path.parent_path() : fs::path(".");
+        if (name.find_first_of("*?") == std::string::npos) {
+            if (fs::is_regular_file(path, error)) {
+                found.push_back(pattern);
+            }
+        } else if (fs::is_directory(directory, error)) {
+            for (const auto& entry : fs::directory_iterator(directory, error)) {
+                if (entry.is_regular_file(error) && matches(name, entry.path().filename().string())) {
+                    found.push_back((path.has_parent_path() ? entry.path() : entry.path().filename()).string());
+                }
+            }
+        }
+    }
+    std::sort(found.begin(), found.end());
+    return found;
+}
+
+bool Batch::matches(const std::string& pattern, const std::string& name) {
+    // Greedy match that backtracks to the last star, linear in practice
+    std::size_t p = 0;
+    std::size_t n = 0;
+    std::size_t star = std::string::npos;
+    std::size_t resume = 0;
+    while (n < name.size()) {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n])) {
+            p++;
+            n++;
+        } else if (p < pattern.size() && pattern[p] == '*') {
+            star = p++;
+            resume = n;
+        } else if (star != std::string::npos) {
+            p = star + 1;
+            n = ++resume;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*') {
+        p++;
+    }
+    return p == pattern.size();
+}
+
+Batch::Result Batch::runScript(const std::string& path, std::size_t turns) {
+    auto start = std::chrono::steady_clock::now();
+    Result result;
+    result.script = path;
+    Game* game = nullptr;
+    FileCommandProcessorAdapter* commands = nullptr;
+    try {
+        // Owned here until the game is built, the game owns it from then on
+        auto owned = std::make_unique<FileCommandProcessorAdapter>(path);
+        commands = owned.get();
+        game = new Game(commands);
+        owned.release();
+        game->startupPhase();
+        if (game->getState() == Game::GameState::Tournament) {
+            result.ok = true;
+            result.result = "tournament:";
+            for (const std::string& winner : game->getTournamentWinners()) {
+                result.result += " " + winner + ";";
+            }
+            result.result.pop_back();
+        } else if (game->hasHumans()) {
+            result.result = "Human players cannot play in a batch";
+        } else {
+            Player* winner = game->mainGameLoop(turns);
+            result.ok = true;
+            if (winner) {
+                result.result = winner->getName() + " wins";
+            } else if (game->getEndReason() == Game::EndReason::None) {
+                result.result = "unfinished";
+            } else {
+                result.result = "draw by " + Game::endReasonString(game->getEndReason());
+            }
+        }
+    } catch (std::exception& e) {
+        result.ok = false;
+        result.result = e.what();
+    }
+    if (game) {
+        // The game owns the command processor
+        result.turns = game->getTurn();
+        result.commands = commands->getProcessed();
+        delete game;
+    }
+    result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+const std::vector<Batch::Result>& Batch::run() {
+    auto start = std::chrono::steady_clock::now();
+
+    // The scripts share the process, so the tournaments they run must not fork, journal or rate
+    std::size_t processes = Tournament::defaultProcesses;
+    std::string journal = Tournament::defaultJournal;
+    std::string ratings = Tournament::defaultRatings;
+    Tournament::defaultProcesses = 0;
+    Tournament::defaultJournal.clear();
+    Tournament::defaultRatings.clear();
+    std::vector<std::future<Result>> running;
+    running.reserve(this->scripts.size());
+    {
+        // Scripts print as they play, and many play at once
+        QuietConsole quiet;
+        ThreadPool pool(std::min(this->options.workers, this->scripts.size()));
+        std::size_t turns = this->options.turns;
+        for (const std::string& script : this->scripts) {
+            running.push_back(pool.submit([script, turns]() { return runScript(script, turns); }));
+        }
+        this->results.clear();
+        for (auto& result : running) {
+            this->results.push_back(result.get());
+        }
+    }
+
+    Tournament::defaultProcesses = processes;
+    Tournament::defaultJournal = journal;
+    Tournament::defaultRatings = ratings;
+    this->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (!this->options.summary.empty()) {
+        std::ofstream out(this->options.summary, std::ios::trunc);
+        if (!out.is_open()) {
+            throw std::runtime_error("Cannot open " + this->options.summary + " for writing");
+        }
+        writeSummary(out);
+    }
+    return this->results;
+}
+
+// Quote a CSV field, doubling the quotes in it
+static std::string quoted(const std::string& field) {
+    std::string out = "\"";
+    for (char c : field) {
+        out += c;
+        if (c == '"') {
+            out += '"';
+        }
+    }
+    return out + "\"";
+}
+
+void Batch::writeSummary(std::ostream& out) const {
+    out << "script,status,result,turns,commands,ms\n";
+    for (const Result& result : this->results) {
+        out << quoted(result.script) << ',' << (result.ok ? "ok" : "failed") << ',' << quoted(result.result) << ','
+            << result.turns << ',' << result.commands << ',' << std::fixed << std::setprecision(3) << result.milliseconds
+            << std::defaultfloat << '\n';
+    }
+}
+
+const std::vector<std::string>& Batch::getScripts() const {
+    return this->scripts;
+}
+
+const std::vector<Batch::Result>& Batch::getResults() const {
+    return this->results;
+}
+
+std::size_t Batch::getFailures() const {
+    return static_cast<std::size_t>(std::count_if(this->results.begin(), this->results.end(), [](const Result& result) { return !result.ok; }));
+}
+
+std::ostream& operator<<(std::ostream& out, const Batch& batch) {
+    out << "This Batch ran " << batch.getResults().size() << " of " << batch.getScripts().size() << " scripts on "
+        << batch.options.workers << " workers in " << static_cast<long>(batch.seconds * 1000) << " ms, "
+        << batch.getFailures() << " failed";
+    if (!batch.options.summary.empty()) {
+        out << ", summary in " << batch.options.summary;
+    }
+    return out << ".";
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @class Batch
+ *
+ * @brief Runs many command scripts, like `-file` does one, to regression-test scripted scenarios.
+ *
+ * Each script plays its own game, or its tournament, on a bounded pool of worker threads, and every
+ * game loads its maps from the same MapCache, so a map shared by thousands of scripts is parsed once.
+ * The games print nothing, each script is summed up in a CSV summary with its result and timing.
+ *
+ * Tournaments in a batch play in the worker that runs their script, without journal or ratings,
+ * which the concurrent scripts would otherwise overwrite.
+ */
+class Batch {
+public:
+    /**
+     * @brief Options of a batch run.
+     */
+    struct Options {
+        /** @brief Directory of scripts, or a path whose file name may hold `*` and `?` wildcards. */
+        std::string scripts;
+        /** @brief CSV file written with the result of every script. */
+        std::string summary = "batch-summary.csv";
+        /** @brief Scripts run at the same time, one per core if 0. */
+        std::size_t workers = 0;
+        /** @brief Turn limit of each game. */
+        std::size_t turns = 1000;
+    };
+
+    /**
+     * @brief What a script did.
+     */
+    struct Result {
+        std::string script;
+        /** @brief Whether the script ran to the end of its game or tournament. */
+        bool ok = false;
+        /** @brief The winner, the draw, the tournament results, or why the script failed. */
+        std::string result;
+        std::size_t turns = 0;
+        std::uint64_t commands = 0;
+        double milliseconds = 0;
+    };
+
+    /**
+     * @brief Find the scripts.
+     *
+     * @throws std::invalid_argument if no script matches.
+     */
+    Batch(const Options& options);
+
+    /**
+     * @brief Scripts in a directory, or the files matching a wildcard pattern, sorted by path.
+     */
+    static std::vector<std::string> find(const std::string& pattern);
+    /**
+     * @brief Whether name matches a pattern where `*` is any run of characters and `?` any one character.
+     */
+    static bool matches(const std::string& pattern, const std::string& name);
+    /**
+     * @brief Play one script to the end of its game, at most turns turns, or of its tournament.
+     */
+    static Result runScript(const std::string& path, std::size_t turns);
+
+    /**
+     * @brief Run every script and write the summary.
+     *
+     * @return The result of each script, in the order of the scripts.
+     */
+    const std::vector<Result>& run();
+    /**
+     * @brief Write the results as CSV: script, status, result, turns, commands and milliseconds.
+     */
+    void writeSummary(std::ostream& out) const;
+
+    const std::vector<std::string>& getScripts() const;
+    const std::vector<Result>& getResults() const;
+    std::size_t getFailures() const;
+
+    friend std::ostream& operator<<(std::ostream& out, const Batch& batch);
+
+private:
+    Options options;
+    std::vector<std::string> scripts;
+    std::vector<Result> results;
+    double seconds;
+};
@@ -0,0 +1,140 @@
+#include "BattleOdds.h"
+
+#include <algorithm>
+#include <cmath>
+
+static constexpr std::size_t ROW = BattleOdds::EXACT_LIMIT + 1;
+
+// Pascal's rule on the probabilities, row n from row n - 1
+BattleOdds::Binomial::Binomial(double p)
+    : p(p)
+    , cdf(ROW * ROW, 0.0)
+    , moment(ROW * ROW, 0.0) {
+    std::vector<double> previous(ROW, 0.0);
+    std::vector<double> pmf(ROW, 0.0);
+    previous[0] = 1.0;
+    for (std::size_t n = 0; n < ROW; n++) {
+        if (n > 0) {
+            pmf[0] = previous[0] * (1 - p);
+            for (std::size_t k = 1; k <= n; k++) {
+                pmf[k] = previous[k] * (1 - p) + previous[k - 1] * p;
+            }
+        } else {
+            pmf[0] = 1.0;
+        }
+        double cumulative = 0.0;
+        double partial = 0.0;
+        for (std::size_t k = 0; k < ROW; k++) {
+            if (k <= n) {
+                cumulative += pmf[k];
+                partial += k * pmf[k];
+            }
+            this->cdf[n * ROW + k] = std::min(cumulative, 1.0);
+            this->moment[n * ROW + k] = partial;
+        }
+        previous = pmf;
+    }
+}
+
+static double normalCdf(double z) {
+    return 0.5 * std::erfc(-z / std::sqrt(2.0));
+}
+
+static double normalPdf(double z) {
+    constexpr double PI = 3.14159265358979323846;
+    return std::exp(-0.5 * z * z) / std::sqrt(2.0 * PI);
+}
+
+double BattleOdds::Binomial::atMost(int n, int k) const {
+    if (k < 0) {
+        return 0.0;
+    }
+    if (k >= n) {
+        return 1.0;
+    }
+    if (n <= EXACT_LIMIT) {
+        return this->cdf[n * ROW + k];
+    }
+    // Normal approximation with continuity correction
+    double mean = n * this->p;
+    double deviation = std::sqrt(n * this->p * (1 - this->p));
+    return normalCdf((k + 0.5 - mean) / deviation);
+}
+
+double BattleOdds::Binomial::momentAtMost(int n, int k) const {
+    if (k < 0) {
+        return 0.0;
+    }
+    if (k >= n) {
+        return n * this->p;
+    }
+    if (n <= EXACT_LIMIT) {
+        return this->moment[n * ROW + k];
+    }
+    // E[X; X <= k] of the normal approximation: mean * P(Z <= z) - deviation * pdf(z)
+    double mean = n * this->p;
+    double deviation = std::sqrt(n * this->p * (1 - this->p));
+    double z = (k + 0.5 - mean) / deviation;
+    return std::max(mean * normalCdf(z) - deviation * normalPdf(z), 0.0);
+}
+
+BattleOdds::BattleOdds()
+    : attack(ATTACK_KILL)
+    , defend(DEFEND_KILL) {
+}
+
+const BattleOdds& BattleOdds::instance() {
+    static const BattleOdds odds;
+    return odds;
+}
+
+// The attackers win when they kill every defender and the defenders kill fewer than all of them
+double BattleOdds::conquest(int attackers, int defenders) const {
+    if (attackers <= 0) {
+        return 0.0;
+    }
+    defenders = std::max(defenders, 0);
+    double allDefendersKilled = 1.0 - this->attack.atMost(attackers, defenders - 1);
+    double attackerSurvives = this->defend.atMost(defenders, attackers - 1);
+    return allDefendersKilled * attackerSurvives;
+}
+
+// The two sides are independent, so the survivors given a conquest only depend on the defenders' kills
+double BattleOdds::expectedSurvivors(int attackers, int defenders) const {
+    if (attackers <= 0) {
+        return 0.0;
+    }
+    defenders = std::max(defenders, 0);
+    double survives = this->defend.atMost(defenders, attackers - 1);
+    if (survives <= 0.0 || conquest(attackers, defenders) <= 0.0) {
+        return 0.0;
+    }
+    return attackers - this->defend.momentAtMost(defenders, attackers - 1) / survives;
+}
+
+// The odds only grow with the attackers, so the smallest count is found by bisection
+int BattleOdds::attackersFor(int defenders, double probability, int maxAttackers) const {
+    if (maxAttackers <= 0 || conquest(maxAttackers, defenders) < probability) {
+        return 0;
+    }
+    int low = 1;
+    int high = maxAttackers;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (conquest(middle, defenders) >= probability) {
+            high = middle;
+        } else {
+            low = middle + 1;
+        }
+    }
+    return low;
+}
+
+std::ostream& operator<<(std::ostream& out, const BattleOdds& odds) {
+    out << "This BattleOdds has exact tables up to " << BattleOdds::EXACT_LIMIT << " armies:";
+    for (int defenders : { 1, 5, 10, 50, 200 }) {
+        int attackers = odds.attackersFor(defenders, 0.9, 100000);
+        out << "\n  " << defenders << " defenders fall to " << attackers << " attackers 90% of the time";
+    }
+    return out;
+}
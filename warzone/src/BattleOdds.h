@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+/**
+ * @class BattleOdds
+ *
+ * @brief Odds of the battles of AdvanceOrder::simulateAttack, looked up in O(1).
+ *
+ * Every attacking army kills a defender with probability ATTACK_KILL and every defending army
+ * kills an attacker with probability DEFEND_KILL, all independently, so the kills on each side
+ * are binomial and the territory falls when every defender dies and an attacker survives.
+ * The binomial distributions are tabulated exactly up to EXACT_LIMIT armies, larger battles use
+ * their normal approximation.
+ *
+ * The tables only depend on the rules, so they are built once on first use and shared.
+ */
+class BattleOdds {
+public:
+    /** @brief simulateAttack rolls 0 to 100 and keeps the roll modulo 100 plus one, so 61 of the 101 rolls are at most 60. */
+    static constexpr double ATTACK_KILL = 61.0 / 101.0;
+    /** @brief Likewise 71 of the 101 rolls are at most 70. */
+    static constexpr double DEFEND_KILL = 71.0 / 101.0;
+    /** @brief Largest army count with exact tables. */
+    static constexpr int EXACT_LIMIT = 128;
+
+    static const BattleOdds& instance();
+
+    /**
+     * @brief Probability that the attackers conquer the territory.
+     */
+    double conquest(int attackers, int defenders) const;
+
+    /**
+     * @brief Expected number of attackers moving into the territory when they conquer it, 0 if they cannot.
+     */
+    double expectedSurvivors(int attackers, int defenders) const;
+
+    /**
+     * @brief Fewest attackers that conquer with at least the given probability.
+     *
+     * @return The number of attackers, or 0 if even `maxAttackers` are not enough.
+     */
+    int attackersFor(int defenders, double probability, int maxAttackers) const;
+
+    friend std::ostream& operator<<(std::ostream& out, const BattleOdds& odds);
+
+private:
+    /**
+     * @brief Cumulative distribution and partial first moment of Binomial(n, p) for n up to EXACT_LIMIT.
+     */
+    struct Binomial {
+        double p;
+        /** @brief cdf[n * (EXACT_LIMIT + 1) + k] = P(X <= k) */
+        std::vector<double> cdf;
+        /** @brief moment[n * (EXACT_LIMIT + 1) + k] = E[X; X <= k] */
+        std::vector<double> moment;
+
+        Binomial(double p);
+        double atMost(int n, int k) const;
+        double momentAtMost(int n, int k) const;
+    };
+
+    Binomial attack;
+    Binomial defend;
+
+    BattleOdds();
+};
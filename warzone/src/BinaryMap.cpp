@@ -0,0 +1,204 @@
+#include "BinaryMap.h"
+#include "Map.h"
+
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+MapCompiler::MapCompiler(const Map& map)
+    : map(map) { }
+
+template <class T>
+static void writeRaw(std::ostream& out, const T* data, std::size_t count) {
+    out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(sizeof(T) * count));
+}
+
+bool MapCompiler::write(std::ostream& out) {
+    const auto& territories = this->map.territories;
+    const auto& continents = this->map.continents;
+    if (territories.size() > std::numeric_limits<std::uint32_t>::max() || continents.size() > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::runtime_error("Map is too large to be compiled");
+    }
+    bool valid = this->map.validate();
+
+    std::string strings;
+    auto addString = [&strings](const std::string& s, std::uint32_t& offset, std::uint32_t& length) {
+        offset = static_cast<std::uint32_t>(strings.size());
+        length = static_cast<std::uint32_t>(s.size());
+        strings += s;
+    };
+
+    std::unordered_map<std::uint32_t, std::uint32_t> continentIndex;
+    std::vector<wzmap::ContinentRecord> continentRecords(continents.size());
+    for (std::size_t i = 0; i < continents.size(); i++) {
+        continentIndex.emplace(continents[i]->nameId, static_cast<std::uint32_t>(i));
+        addString(continents[i]->getName(), continentRecords[i].nameOffset, continentRecords[i].nameLength);
+        continentRecords[i].armies = continents[i]->armies;
+    }
+
+    std::vector<wzmap::TerritoryRecord> territoryRecords(territories.size());
+    std::vector<std::uint32_t> offsets(territories.size() + 1, 0);
+    std::vector<std::uint32_t> adjacency;
+    for (std::size_t i = 0; i < territories.size(); i++) {
+        const Territory* territory = territories[i];
+        addString(territory->getName(), territoryRecords[i].nameOffset, territoryRecords[i].nameLength);
+
+        auto continent = continentIndex.find(territory->continentId);
+        if (continent == continentIndex.end()) {
+            throw std::runtime_error("Territory " + territory->getName() + " is on unknown continent " + territory->getContinent());
+        }
+        territoryRecords[i].continent = continent->second;
+
+        for (const Territory* adjacent : territory->adjacent) {
+            if (adjacent->index >= territories.size() || territories[adjacent->index] != adjacent) {
+                throw std::runtime_error("Territory " + territory->getName() + " is adjacent to a territory outside the map");
+            }
+            adjacency.push_back(static_cast<std::uint32_t>(adjacent->index));
+        }
+        offsets[i + 1] = static_cast<std::uint32_t>(adjacency.size());
+    }
+    if (strings.size() > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::runtime_error("Map is too large to be compiled");
+    }
+    // Keep the file size a multiple of 4 bytes
+    strings.resize((strings.size() + 3) & ~std::size_t(3), '\0');
+
+    wzmap::Header header;
+    std::memcpy(header.magic, wzmap::MAGIC, sizeof(header.magic));
+    header.byteOrder = wzmap::ENDIAN_MARK;
+    header.version = wzmap::VERSION;
+    header.flags = valid ? wzmap::FLAG_VALIDATED : 0;
+    header.territories = static_cast<std::uint32_t>(territories.size());
+    header.continents = static_cast<std::uint32_t>(continents.size());
+    header.adjacencies = static_cast<std::uint32_t>(adjacency.size());
+    header.stringBytes = static_cast<std::uint32_t>(strings.size());
+
+    writeRaw(out, &header, 1);
+    writeRaw(out, continentRecords.data(), continentRecords.size());
+    writeRaw(out, territoryRecords.data(), territoryRecords.size());
+    writeRaw(out, offsets.data(), offsets.size());
+    writeRaw(out, adjacency.data(), adjacency.size());
+    out.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+    out.flush();
+    return valid;
+}
+
+std::ostream& operator<<(std::ostream& out, const MapCompiler& compiler) {
+    return out << "This MapCompiler compiles a map where " << compiler.map;
+}
+
+BinaryMapLoader::BinaryMapLoader(const std::string& path)
+    : file(path) { }
+
+bool BinaryMapLoader::isBinary(const std::string& path) {
+    std::ifstream stream(path, std::ios::binary);
+    char magic[sizeof(wzmap::MAGIC)];
+    if (!stream.read(magic, sizeof(magic))) {
+        return false;
+    }
+    return std::memcmp(magic, wzmap::MAGIC, sizeof(magic)) == 0;
+}
+
+Map* BinaryMapLoader::parse() {
+    auto fail = [this](std::string message) {
+        throw std::runtime_error(message + " in " + this->file.getPath());
+    };
+
+    const char* data = this->file.data();
+    std::size_t size = this->file.size();
+    if (size < sizeof(wzmap::Header)) {
+        fail("Truncated header");
+    }
+    const auto* header = reinterpret_cast<const wzmap::Header*>(data);
+    if (std::memcmp(header->magic, wzmap::MAGIC, sizeof(header->magic)) != 0) {
+        fail("Not a compiled map");
+    }
+    if (header->byteOrder != wzmap::ENDIAN_MARK) {
+        fail("Compiled for another byte order");
+    }
+    if (header->version != wzmap::VERSION) {
+        fail("Unsupported version " + std::to_string(header->version));
+    }
+
+    std::size_t nbTerritories = header->territories;
+    std::size_t nbContinents = header->continents;
+    std::size_t expected = sizeof(wzmap::Header)
+        + nbContinents * sizeof(wzmap::ContinentRecord)
+        + nbTerritories * sizeof(wzmap::TerritoryRecord)
+        + (nbTerritories + 1) * sizeof(std::uint32_t)
+        + std::size_t(header->adjacencies) * sizeof(std::uint32_t)
+        + header->stringBytes;
+    if (size != expected) {
+        fail("Unexpected file size");
+    }
+
+    const auto* continentRecords = reinterpret_cast<const wzmap::ContinentRecord*>(data + sizeof(wzmap::Header));
+    const auto* territoryRecords = reinterpret_cast<const wzmap::TerritoryRecord*>(continentRecords + nbContinents);
+    const auto* offsets = reinterpret_cast<const std::uint32_t*>(territoryRecords + nbTerritories);
+    const auto* adjacency = offsets + nbTerritories + 1;
+    const char* strings = reinterpret_cast<const char*>(adjacency + header->adjacencies);
+
+    auto name = [&](std::uint32_t offset, std::uint32_t length) {
+        if (std::size_t(offset) + length > header->stringBytes) {
+            fail("Name outside of the string table");
+        }
+        return std::string_view(strings + offset, length);
+    };
+
+    Map* map = new Map();
+    try {
+        // Every territory is on one continent, so the arena holds one link per territory besides the adjacency
+        map->reserve(nbTerritories, nbContinents, std::size_t(header->adjacencies) + nbTerritories);
+        std::vector<std::size_t> sizes(nbContinents, 0);
+        for (std::size_t i = 0; i < nbTerritories; i++) {
+            if (territoryRecords[i].continent >= nbContinents) {
+                fail("Territory on an unknown continent");
+            }
+            sizes[territoryRecords[i].continent]++;
+        }
+        for (std::size_t i = 0; i < nbContinents; i++) {
+            const auto& record = continentRecords[i];
+            map->makeContinent(map->names->intern(name(record.nameOffset, record.nameLength)), record.armies)->territories.reserve(sizes[i]);
+        }
+
+        for (std::size_t i = 0; i < nbTerritories; i++) {
+            const auto& record = territoryRecords[i];
+            Continent* continent = map->continents[record.continent];
+            Territory* territory = map->makeTerritory(map->names->intern(name(record.nameOffset, record.nameLength)), continent->nameId);
+            map->insertTerritory(territory);
+            continent->territories.push_back(territory);
+        }
+
+        for (std::size_t i = 0; i < nbTerritories; i++) {
+            std::uint32_t begin = offsets[i];
+            std::uint32_t end = offsets[i + 1];
+            if (begin > end || end > header->adjacencies) {
+                fail("Malformed adjacency offsets");
+            }
+            auto& adjacent = map->territories[i]->adjacent;
+            adjacent.reserve(end - begin);
+            for (std::uint32_t j = begin; j < end; j++) {
+                if (adjacency[j] >= nbTerritories) {
+                    fail("Adjacency to an unknown territory");
+                }
+                adjacent.push_back(map->territories[adjacency[j]]);
+            }
+        }
+    } catch (...) {
+        delete map;
+        throw;
+    }
+
+    map->validated = (header->flags & wzmap::FLAG_VALIDATED) != 0;
+    return map;
+}
+
+std::ostream& operator<<(std::ostream& out, const BinaryMapLoader& loader) {
+    return out << "This BinaryMapLoader loads a compiled map. " << loader.file;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "Map.h"
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+/**
+ * @brief Layout of a compiled `.wzmap` file.
+ *
+ * All integers are 32 bits in native byte order, every table is 4-byte aligned:
+ * header, continent table, territory table, adjacency offsets (territories + 1),
+ * adjacency indices, then the string table holding every name back to back.
+ */
+namespace wzmap {
+/** @brief Magic bytes at the start of every compiled map. */
+constexpr char MAGIC[4] = { 'W', 'Z', 'M', 'P' };
+/** @brief Written as-is so files from another byte order are rejected. */
+constexpr std::uint32_t ENDIAN_MARK = 0x01020304;
+constexpr std::uint32_t VERSION = 1;
+/** @brief The map passed Map::validate when it was compiled. */
+constexpr std::uint32_t FLAG_VALIDATED = 1;
+
+struct Header {
+    char magic[4];
+    std::uint32_t byteOrder;
+    std::uint32_t version;
+    std::uint32_t flags;
+    std::uint32_t territories;
+    std::uint32_t continents;
+    std::uint32_t adjacencies;
+    std::uint32_t stringBytes;
+};
+
+struct ContinentRecord {
+    std::uint32_t nameOffset;
+    std::uint32_t nameLength;
+    std::int32_t armies;
+};
+
+struct TerritoryRecord {
+    std::uint32_t nameOffset;
+    std::uint32_t nameLength;
+    std::uint32_t continent;
+};
+}
+
+/**
+ * @class MapCompiler
+ *
+ * @brief Utility class for writing a parsed map as a compiled `.wzmap` file.
+ */
+class MapCompiler {
+public:
+    /**
+     * @brief Construct with the given map, which must stay alive while writing.
+     */
+    MapCompiler(const Map& map);
+
+    /**
+     * @brief Validate the map and write it in the binary format.
+     *
+     * @return Whether the map was valid, which is recorded in the file.
+     */
+    bool write(std::ostream& out);
+
+    friend std::ostream& operator<<(std::ostream& out, const MapCompiler& compiler);
+
+private:
+    const Map& map;
+};
+
+/**
+ * @class BinaryMapLoader
+ *
+ * @brief Utility class for loading compiled `.wzmap` files.
+ *
+ * The file is memory-mapped and the map is built straight from its tables,
+ * without any text parsing or name lookup.
+ */
+class BinaryMapLoader {
+public:
+    /**
+     * @brief Map the file at the given path.
+     *
+     * @throws std::runtime_error if the file cannot be opened.
+     */
+    BinaryMapLoader(const std::string& path);
+
+    /**
+     * @brief Build the map from the compiled tables.
+     *
+     * @throws std::runtime_error if the file is not a well-formed compiled map.
+     */
+    Map* parse();
+
+    /**
+     * @brief Check the magic bytes of the file at the given path.
+     */
+    static bool isBinary(const std::string& path);
+
+    friend std::ostream& operator<<(std::ostream& out, const BinaryMapLoader& loader);
+
+private:
+    MappedFile file;
+};
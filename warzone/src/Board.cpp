@@ -0,0 +1,193 @@
+#include "Board.h"
+#include "Map.h"
+#include "Player.h"
+
+#include <algorithm>
+
+Board::Board()
+    : players(1, nullptr)
+    , layout(std::make_shared<Layout>()) {
+}
+
+void Board::Layout::build(const Map& map) {
+    std::size_t n = map.territories.size();
+    std::int32_t none = static_cast<std::int32_t>(map.continents.size());
+    auto belongs = [&map](const Territory* t) {
+        return t->index < map.territories.size() && map.territories[t->index] == t;
+    };
+
+    // A territory listed by several continents is on the first one
+    this->continents.assign(n, none);
+    this->continentSizes.assign(map.continents.size() + 1, 0);
+    this->continentArmies.assign(map.continents.size() + 1, 0);
+    for (std::size_t c = 0; c < map.continents.size(); c++) {
+        this->continentArmies[c] = map.continents[c]->armies;
+        for (auto t : map.continents[c]->territories) {
+            if (belongs(t) && this->continents[t->index] == none) {
+                this->continents[t->index] = static_cast<std::int32_t>(c);
+                this->continentSizes[c]++;
+            }
+        }
+    }
+
+    this->offsets.reserve(n + 1);
+    this->offsets.push_back(0);
+    for (auto t : map.territories) {
+        for (auto a : t->adjacent) {
+            if (belongs(a)) {
+                this->adjacent.push_back(static_cast<std::uint32_t>(a->index));
+            }
+        }
+        this->offsets.push_back(static_cast<std::uint32_t>(this->adjacent.size()));
+    }
+}
+
+std::size_t Board::size() const {
+    return this->armies.size();
+}
+
+int Board::getArmies(std::size_t territory) const {
+    return this->armies[territory];
+}
+
+Player* Board::getOwner(std::size_t territory) const {
+    return this->players[this->owners[territory]];
+}
+
+std::vector<std::int32_t> Board::position() const {
+    std::vector<std::int32_t> position(this->owners);
+    position.insert(position.end(), this->armies.begin(), this->armies.end());
+    return position;
+}
+
+std::size_t Board::getContinent(std::size_t territory) const {
+    return static_cast<std::size_t>(this->layout->continents[territory]);
+}
+
+std::int32_t Board::slotOf(const Player* player) const {
+    if (!player) {
+        return NO_ONE;
+    }
+    auto it = std::find(this->players.begin() + 1, this->players.end(), player);
+    return it == this->players.end() ? -1 : static_cast<std::int32_t>(it - this->players.begin());
+}
+
+std::int32_t Board::claim(Player* player) {
+    std::int32_t slot = slotOf(player);
+    if (slot < 0) {
+        slot = static_cast<std::int32_t>(this->players.size());
+        this->players.push_back(player);
+    }
+    return slot;
+}
+
+void Board::add(int armies, Player* owner) {
+    this->armies.push_back(armies);
+    this->owners.push_back(claim(owner));
+}
+
+void Board::reserve(std::size_t territories) {
+    this->armies.reserve(territories);
+    this->owners.reserve(territories);
+}
+
+void Board::setArmies(std::size_t territory, int armies) {
+    this->armies[territory] = armies;
+}
+
+void Board::setOwner(std::size_t territory, Player* owner) {
+    this->owners[territory] = claim(owner);
+}
+
+void Board::relayout() {
+    this->layout = std::make_shared<Layout>();
+}
+
+// The kernels below select with comparisons rather than branch, so each loop vectorizes
+
+std::int64_t Board::armiesOf(const Player* player) const {
+    const std::int32_t slot = slotOf(player);
+    const std::int32_t* owners = this->owners.data();
+    const std::int32_t* armies = this->armies.data();
+    std::int64_t total = 0;
+    for (std::size_t i = 0, n = this->owners.size(); i < n; i++) {
+        total += owners[i] == slot ? armies[i] : 0;
+    }
+    return total;
+}
+
+std::size_t Board::territoriesOf(const Player* player) const {
+    const std::int32_t slot = slotOf(player);
+    const std::int32_t* owners = this->owners.data();
+    std::size_t count = 0;
+    for (std::size_t i = 0, n = this->owners.size(); i < n; i++) {
+        count += owners[i] == slot;
+    }
+    return count;
+}
+
+Player* Board::soleOwner() const {
+    if (this->owners.empty()) {
+        return nullptr;
+    }
+    const std::int32_t first = this->owners[0];
+    const std::int32_t* owners = this->owners.data();
+    std::int32_t differ = 0;
+    for (std::size_t i = 0, n = this->owners.size(); i < n; i++) {
+        differ |= owners[i] ^ first;
+    }
+    return differ == 0 ? this->players[first] : nullptr;
+}
+
+int Board::continentRewards(const Player* player) const {
+    const std::int32_t slot = slotOf(player);
+    const Layout& layout = *this->layout;
+    std::vector<std::int32_t> owned(layout.continentSizes.size(), 0);
+    for (std::size_t i = 0, n = this->owners.size(); i < n; i++) {
+        owned[layout.continents[i]] += this->owners[i] == slot;
+    }
+    // Like before the board, a continent without territories is held by everyone
+    int rewards = 0;
+    for (std::size_t c = 0; c + 1 < owned.size(); c++) {
+        rewards += owned[c] == layout.continentSizes[c] ? layout.continentArmies[c] : 0;
+    }
+    return rewards;
+}
+
+std::vector<std::int64_t> Board::threats(const Player* player) const {
+    const std::int32_t slot = slotOf(player);
+    const Layout& layout = *this->layout;
+    std::size_t n = this->owners.size();
+
+    // Armies that can attack the player, from the territories of the other players
+    std::vector<std::int64_t> hostile(n);
+    for (std::size_t i = 0; i < n; i++) {
+        hostile[i] = (this->owners[i] != slot) & (this->owners[i] != NO_ONE) ? this->armies[i] : 0;
+    }
+    std::vector<std::int64_t> threats(n, 0);
+    for (std::size_t i = 0; i < n; i++) {
+        if (this->owners[i] != slot) {
+            continue;
+        }
+        std::int64_t sum = 0;
+        for (std::uint32_t j = layout.offsets[i]; j < layout.offsets[i + 1]; j++) {
+            sum += hostile[layout.adjacent[j]];
+        }
+        threats[i] = sum;
+    }
+    return threats;
+}
+
+std::int64_t Board::threatenedArmies(const Player* player) const {
+    std::int64_t total = 0;
+    for (std::int64_t threat : threats(player)) {
+        total += threat;
+    }
+    return total;
+}
+
+std::ostream& operator<<(std::ostream& out, const Board& board) {
+    return out << "This Board holds " << board.size() << " territories owned by " << board.players.size() - 1
+               << " players so far, laid out on " << board.layout->continentSizes.size() - (board.layout->continentSizes.empty() ? 0 : 1)
+               << " continents.";
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "Player.fwd.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+class Map;
+
+/**
+ * @class Board
+ *
+ * @brief The owners and armies of the territories of a map, in contiguous arrays indexed by Territory::getIndex.
+ *
+ * The territories write their armies and owner here as they change, so the board always agrees with
+ * them. Owners are stored as small slots, 0 for no one, so that the evaluations of the whole board
+ * (armies and territories of a player, continents held, armies threatening a frontier) are plain
+ * loops over arrays of integers, which the compiler vectorizes, rather than a walk through the
+ * territories on the heap.
+ *
+ * Which continent each territory is on and who is adjacent to whom only depend on the structure of
+ * the map, so like the DistanceTable they are laid out once, on first use, and shared by every copy.
+ */
+class Board {
+    friend class Map;
+    friend class Territory;
+
+public:
+    /** @brief Slot of the territories owned by no one. */
+    static constexpr std::int32_t NO_ONE = 0;
+
+    std::size_t size() const;
+    int getArmies(std::size_t territory) const;
+    Player* getOwner(std::size_t territory) const;
+    /** @brief Continent the territory is on, by its position in the map, or the number of continents if none. */
+    std::size_t getContinent(std::size_t territory) const;
+
+    /** @brief Armies on the territories of the player. */
+    std::int64_t armiesOf(const Player* player) const;
+    /** @brief Number of territories of the player. */
+    std::size_t territoriesOf(const Player* player) const;
+    /** @brief The player owning every territory, nullptr if there is none. */
+    Player* soleOwner() const;
+    /** @brief Armies awarded by the continents the player owns entirely. */
+    int continentRewards(const Player* player) const;
+    /**
+     * @brief Armies of other players next to each territory of the player, 0 for the territories of others.
+     *
+     * Unowned territories threaten no one.
+     */
+    std::vector<std::int64_t> threats(const Player* player) const;
+    /** @brief Sum of the threats along the player's frontier. */
+    std::int64_t threatenedArmies(const Player* player) const;
+    /** @brief The owner slot and the exact armies of every territory, equal only for the same owners and armies. */
+    std::vector<std::int32_t> position() const;
+
+    friend std::ostream& operator<<(std::ostream& out, const Board& board);
+
+private:
+    /**
+     * @brief The structure of the map, by territory index.
+     */
+    struct Layout {
+        std::once_flag once;
+        /** @brief Continent of each territory, the number of continents for the territories in none. */
+        std::vector<std::int32_t> continents;
+        /** @brief Territories and armies awarded by each continent, with a last empty one for the territories in none. */
+        std::vector<std::int32_t> continentSizes;
+        std::vector<std::int32_t> continentArmies;
+        /** @brief Compressed adjacency, the neighbours of `i` are `adjacent[offsets[i]..offsets[i + 1]]`. */
+        std::vector<std::uint32_t> offsets;
+        std::vector<std::uint32_t> adjacent;
+
+        void build(const Map& map);
+    };
+
+    std::vector<std::int32_t> armies;
+    std::vector<std::int32_t> owners;
+    /** @brief Player of each slot, slot 0 being no one. */
+    std::vector<Player*> players;
+    std::shared_ptr<Layout> layout;
+
+    Board();
+
+    /** @brief Slot of the player, -1 if it never owned a territory of this board. */
+    std::int32_t slotOf(const Player* player) const;
+    /** @brief Slot of the player, given one if it has none yet. */
+    std::int32_t claim(Player* player);
+    void add(int armies, Player* owner);
+    /** @brief Make room for that many territories. */
+    void reserve(std::size_t territories);
+    void setArmies(std::size_t territory, int armies);
+    void setOwner(std::size_t territory, Player* owner);
+    /** @brief Forget the layout after the structure of the map changed. */
+    void relayout();
+};
@@ -1,4 +1,6 @@
 #include "Cards.h"
+#include "Profiler.h"
+#include "Zobrist.h"
 
 Card::Card(CardType type)
     : type(type) {
@@ -66,89 +68,135 @@ CardType Card::getType() const {
     return this->type;
 }
 
-Deck::Deck() {
-    // Push an artbitrary collection of five cards(one for each type) on the deck
-    cards.push_back(new Card(CardType::BOMB));
-    cards.push_back(new Card(CardType::REINFORCEMENT));
-    cards.push_back(new Card(CardType::BLOCKADE));
-    cards.push_back(new Card(CardType::AIRLIFT));
-    cards.push_back(new Card(CardType::DIPLOMACY));
+static std::size_t slot(CardType type) {
+    return static_cast<std::size_t>(type);
 }
 
-Deck::Deck(const Deck& other) {
-    for (const auto& card : other.cards)
-        cards.push_back(new Card(*card));
+Deck::Deck()
+    : total(CARD_TYPES) {
+    // An artbitrary collection of five cards, one for each type
+    counts.fill(1);
+}
+
+Deck::Deck(const Deck& other)
+    : counts(other.counts)
+    , total(other.total)
+    , random(other.random) {
 }
 
 Deck& Deck::operator=(const Deck& other) {
     if (this != &other) {
-        for (const auto& card : other.cards)
-            cards.push_back(new Card(*card));
+        counts = other.counts;
+        total = other.total;
+        random = other.random;
     }
     return *this;
 }
 
 Deck::~Deck() {
-    for (auto card : cards)
-        delete card;
 }
 
-Card* Deck::draw() {
-    if (this->cards.size() == 0) {
-        return nullptr;
+std::optional<Card> Deck::draw() {
+    if (this->total == 0) {
+        return std::nullopt;
     }
 
-    // Radomize the card draw from the deck - to add(return) in the hand of the player calling it
-    size_t index = std::rand() % cards.size();
-    Card* drawnCard = cards[index];
-    // Delete the specific card drawn from the deck
-    cards.erase(cards.begin() + index);
-    return drawnCard;
+    // Radomize the card draw from the deck - every card is equally likely, so pick the type by its count
+    std::size_t index = std::uniform_int_distribution<std::size_t>(0, this->total - 1)(this->random);
+    Profiler::count(Profiler::Counter::RandomDraws);
+    std::size_t type = 0;
+    while (index >= this->counts[type]) {
+        index -= this->counts[type];
+        type++;
+    }
+    this->counts[type]--;
+    this->total--;
+    return Card(static_cast<CardType>(type));
+}
+
+void Deck::seed(std::uint32_t seed) {
+    this->random.seed(seed);
 }
 
 void Deck::addCard(const Card& card) {
-    cards.push_back(new Card(card));
+    this->counts[slot(card.getType())]++;
+    this->total++;
 }
 
 bool Deck::deckSize() const {
-    return cards.size();
+    return this->total;
+}
+
+std::size_t Deck::size() const {
+    return this->total;
+}
+
+std::size_t Deck::count(CardType type) const {
+    return this->counts[slot(type)];
 }
 
-Hand::Hand() { }
+Hand::Hand()
+    : zobrist(0) {
+    counts.fill(0);
+}
 
-Hand::Hand(const Hand& other) {
-    for (const auto& card : other.cards)
-        cards.push_back(new Card(*card));
+Hand::Hand(const Hand& other)
+    : counts(other.counts)
+    , order(other.order)
+    , zobrist(other.zobrist) {
 }
 
 Hand& Hand::operator=(const Hand& other) {
     if (this != &other) {
-        for (const auto& card : other.cards)
-            cards.push_back(new Card(*card));
+        counts = other.counts;
+        order = other.order;
+        zobrist = other.zobrist;
     }
     return *this;
 }
 
 Hand::~Hand() {
-    for (auto card : cards)
-        delete card;
 }
 
-Card* Hand::draw() {
-    if (this->cards.size() == 0) {
-        return nullptr;
+std::optional<Card> Hand::draw() {
+    if (this->order.empty()) {
+        return std::nullopt;
     }
-    // Draw the last added card to the deck
-    size_t index = cards.size() - 1;
-    Card* drawnCard = cards[index];
-    cards.pop_back();
-    return drawnCard;
+    // Draw the last added card to the hand
+    CardType type = this->order.back();
+    this->order.pop_back();
+    adjust(type, -1);
+    return Card(type);
+}
+
+void Hand::addCard(const Card& card) {
+    this->order.push_back(card.getType());
+    adjust(card.getType(), 1);
 }
 
-void Hand::addCard(Card* card) {
-    cards.push_back(card);
+// An empty slot has no key, so an empty hand hashes to 0
+void Hand::adjust(CardType type, std::int32_t change) {
+    auto key = [type](std::uint32_t count) {
+        return count ? Zobrist::key(Zobrist::Feature::Card, slot(type), count) : 0;
+    };
+    std::uint32_t& count = this->counts[slot(type)];
+    this->zobrist ^= key(count);
+    count += change;
+    this->zobrist ^= key(count);
 }
 
 bool Hand::handSize() const {
-    return cards.size();
+    return !this->order.empty();
+}
+
+std::size_t Hand::size() const {
+    return this->order.size();
+}
+
+std::size_t Hand::count(CardType type) const {
+    return this->counts[slot(type)];
+}
+
+std::uint64_t Hand::hash() const {
+    return this->zobrist;
 }
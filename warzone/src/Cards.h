@@ -3,7 +3,12 @@
 #include "Cards.fwd.h"
 #include "Orders.h"
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <optional>
+#include <random>
 #include <vector>
 
 /**
@@ -62,6 +67,9 @@ public:
     CardType getType() const;
 };
 
+/** @brief Number of card types, the size of the per-type counters. */
+constexpr std::size_t CARD_TYPES = 5;
+
 /**
  * @class Deck
  * @brief Represents a deck of Warzone cards.
@@ -69,11 +77,17 @@ public:
  * The Deck class manages a finite collection of cards,
  * allowing for drawing cards from it, and adding cards,
  * as well as checking the current size of the deck.
+ * Cards of a type are interchangeable, so the deck only
+ * counts them: drawing and adding never allocate.
  */
 class Deck {
 private:
-    /** @brief Vector of pointers to cards in the deck. */
-    std::vector<Card*> cards;
+    /** @brief Number of cards of each type in the deck. */
+    std::array<std::uint32_t, CARD_TYPES> counts;
+    /** @brief Total number of cards in the deck. */
+    std::size_t total;
+    /** @brief Random generator for the draws, seeded by the game. */
+    std::mt19937 random;
 
 public:
     /**
@@ -100,10 +114,16 @@ public:
     ~Deck();
 
     /**
-     * @brief Draws a card from the deck.
-     * @return The drawn Card object.
+     * @brief Draws a random card from the deck.
+     * @return The drawn card, or nothing if the deck is empty.
+     */
+    std::optional<Card> draw();
+
+    /**
+     * @brief Seeds the random generator used for the draws.
+     * @param seed The seed, the same seed gives the same draws.
      */
-    Card* draw();
+    void seed(std::uint32_t seed);
 
     /**
      * @brief Adds a card back into the deck.
@@ -116,6 +136,16 @@ public:
      * @return True if there are cards in the deck, false otherwise.
      */
     bool deckSize() const;
+
+    /**
+     * @brief Number of cards in the deck.
+     */
+    std::size_t size() const;
+
+    /**
+     * @brief Number of cards of the given type in the deck.
+     */
+    std::size_t count(CardType type) const;
 };
 
 /**
@@ -125,11 +155,19 @@ public:
  * The Hand class manages a finite collection of Warzone cards,
  * allows to drawing cards from the hand and, adding new cards
  * to it, as well as checking the current size of the hand.
+ * The last card added is the first drawn, so the hand keeps the
+ * order of its cards as one byte each beside the per-type counts.
  */
 class Hand {
 private:
-    /** @brief Vector of pointers to cards in the hand. */
-    std::vector<Card*> cards;
+    /** @brief Number of cards of each type in the hand. */
+    std::array<std::uint32_t, CARD_TYPES> counts;
+    /** @brief Types of the cards in the order they were added. */
+    std::vector<CardType> order;
+    /** @brief Zobrist hash of the counts, kept up to date by addCard and draw. */
+    std::uint64_t zobrist;
+
+    void adjust(CardType type, std::int32_t change);
 
 public:
     /**
@@ -156,20 +194,35 @@ public:
     ~Hand();
 
     /**
-     * @brief Draws a card from the hand.
-     * @return The drawn Card object.
+     * @brief Draws the last card added to the hand.
+     * @return The drawn card, or nothing if the hand is empty.
      */
-    Card* draw();
+    std::optional<Card> draw();
 
     /**
      * @brief Adds a card to the hand.
-     * @param card Pointer to the Card object to add.
+     * @param card The Card object to add.
      */
-    void addCard(Card* card);
+    void addCard(const Card& card);
 
     /**
      * @brief Checks the size of the hand.
      * @return True if there are cards in the hand, false otherwise.
      */
     bool handSize() const;
+
+    /**
+     * @brief Number of cards in the hand.
+     */
+    std::size_t size() const;
+
+    /**
+     * @brief Number of cards of the given type in the hand.
+     */
+    std::size_t count(CardType type) const;
+
+    /**
+     * @brief Zobrist hash of the number of cards of each type, the order of the cards is not part of it.
+     */
+    std::uint64_t hash() const;
 };
@@ -16,14 +16,12 @@ void testCards() {
     for (size_t i = 0; i < 10; ++i) {
         // Check if there are cards left in the deck
         if (deck->deckSize()) {
-            // Pointer to Card object that was in deck
-            Card* drawnCard = deck->draw();
+            // Card that was in deck
+            std::optional<Card> drawnCard = deck->draw();
 
-            // Add the pointer in hand
-            hand->addCard(new Card(*drawnCard));
+            // Add the card in hand
+            hand->addCard(*drawnCard);
             std::cout << "Drew card: " << *drawnCard << std::endl;
-
-            delete drawnCard;
         } else {
             std::cout << "\n*No more cards in the Warzone deck."
                       << std::endl;
@@ -37,22 +35,26 @@ void testCards() {
     OrdersList* orders = new OrdersList();
     // Play all cards in hand
     while (hand->handSize()) {
-        // Pointer to Card object that was in hand
-        Card* card = hand->draw();
+        // Card that was in hand
+        std::optional<Card> card = hand->draw();
 
         // Hold the action performed by the card drawn from hand
         card->play(orders);
-        // Add the pointer in hand
+        // Return the card to the deck
         deck->addCard(*card);
 
         std::cout << "Played card: " << *card << std::endl;
         std::cout << "Orders after playing:\n"
                   << *orders << std::endl;
-
-        delete card;
     }
     std::cout << "*All cards have been played and returned to the deck" << std::endl;
 
+    // The deck only counts its cards, so it should hold one of each type again
+    bool restored = deck->size() == CARD_TYPES && hand->size() == 0;
+    for (size_t i = 0; i < CARD_TYPES; ++i)
+        restored = restored && deck->count(static_cast<CardType>(i)) == 1;
+    std::cout << "Deck holds one card of each type again: " << restored << std::endl;
+
     delete orders;
     delete deck;
     delete hand;
@@ -3,13 +3,13 @@
 #include "LoggingObserver.h"
 #include "Map.h"
 
+#include <algorithm>
+#include <cctype>
 #include <cstddef>
 #include <iostream>
 #include <optional>
 #include <ostream>
-#include <sstream>
 #include <string>
-#include <unordered_map>
 
 Command::Command(std::string command, std::string argument)
     : Subject()
@@ -30,7 +30,21 @@ Command::Command(const Command& other)
 Command::~Command() { }
 void Command::saveEffect(std::string effect) {
     this->effect = effect;
-    notify(this);
+    notify(Event::Kind::EffectSaved, this);
+}
+
+void Command::assign(std::string_view command, std::optional<std::string_view> argument) {
+    this->command.assign(command);
+    if (argument) {
+        // Assigning into the engaged string keeps its buffer
+        if (!this->argument) {
+            this->argument.emplace();
+        }
+        this->argument->assign(*argument);
+    } else {
+        this->argument.reset();
+    }
+    this->effect.reset();
 }
 
 const std::string& Command::getCommand() const {
@@ -78,14 +92,66 @@ const char* CommandException::what() const noexcept {
     return this->message.c_str();
 }
 
-CommandProcessor::CommandProcessor(const CommandProcessor& other)
+using S = Game::GameState;
+
+static constexpr std::uint32_t bit(S state) {
+    return 1u << static_cast<int>(state);
+}
+
+// Every command, whether it takes an argument, and the states it is valid in, one bit per state
+struct Rule {
+    std::string_view command;
+    bool argument;
+    std::uint32_t states;
+};
+static constexpr Rule RULES[] = {
+    { "loadmap", true, bit(S::Start) | bit(S::MapLoaded) },
+    { "validatemap", false, bit(S::MapLoaded) },
+    { "addplayer", true, bit(S::MapValidated) | bit(S::PlayersAdded) },
+    { "gamestart", false, bit(S::PlayersAdded) },
+    { "replay", false, bit(S::Win) },
+    { "quit", false, bit(S::Win) },
+    { "tournament", true, bit(S::Start) },
+    { "play", true, bit(S::FirstReinforcements) | bit(S::AssignReinforcements) | bit(S::ExecuteOrders) },
+};
+
+static const Rule* findRule(std::string_view command) {
+    for (const Rule& rule : RULES) {
+        if (rule.command == command) {
+            return &rule;
+        }
+    }
+    return nullptr;
+}
+
+static std::string_view trim(std::string_view text) {
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.front()))) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back()))) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+CommandProcessor::CommandProcessor(std::size_t history)
     : Subject()
     , ILoggable()
+    , history(std::max<std::size_t>(1, history))
+    , next(0)
+    , last(nullptr)
+    , processed(0) {
+    this->commands.reserve(this->history);
+}
 
-{
-    for (size_t i = 0; i < other.commands.size(); i++) {
-        this->commands.push_back(new Command(*other.commands[i]));
-    }
+CommandProcessor::CommandProcessor(const CommandProcessor& other)
+    : Subject()
+    , ILoggable()
+    , history(other.history)
+    , next(0)
+    , last(nullptr)
+    , processed(other.processed) {
+    copyHistory(other);
 }
 
 CommandProcessor::~CommandProcessor() {
@@ -94,42 +160,68 @@ CommandProcessor::~CommandProcessor() {
     }
 }
 
+void CommandProcessor::copyHistory(const CommandProcessor& other) {
+    this->commands.reserve(this->history);
+    for (const Command* command : other.ordered()) {
+        this->commands.push_back(new Command(*command));
+        this->last = this->commands.back();
+    }
+}
+
+std::vector<const Command*> CommandProcessor::ordered() const {
+    std::vector<const Command*> ordered;
+    ordered.reserve(this->commands.size());
+    for (size_t i = 0; i < this->commands.size(); i++) {
+        ordered.push_back(this->commands[(this->next + i) % this->commands.size()]);
+    }
+    return ordered;
+}
+
 const Command* CommandProcessor::getCommand() {
-    this->saveCommand(readCommand());
-    return this->commands.back();
+    Command* command = readCommand();
+    this->saveCommand(command);
+    return command;
+}
+
+const Command* CommandProcessor::getCommand(const std::string& line) {
+    Command* command = parseCommand(line);
+    this->saveCommand(command);
+    return command;
 }
 
-Command* CommandProcessor::parseCommand(std::string line) {
-    line = std::regex_replace(line, TRIM_WHITESPACE, "");
-    std::istringstream lineStream(line);
-    std::string word;
-    if (!(lineStream >> word)) {
+Command* CommandProcessor::parseCommand(std::string_view line) {
+    line = trim(line);
+    if (line.empty()) {
         throw CommandException("No command received");
     }
-
-    std::string command = word;
-    if (
-        command == "validatemap"
-        || command == "gamestart"
-        || command == "replay"
-        || command == "quit") {
-        return new Command(command);
+    size_t space = 0;
+    while (space < line.size() && !std::isspace(static_cast<unsigned char>(line[space]))) {
+        space++;
     }
-    if (
-        command == "loadmap"
-        || command == "addplayer"
-        || command == "tournament") {
-        word = "";
-        std::getline(lineStream, word);
-        word = std::regex_replace(word, TRIM_WHITESPACE, "");
-
-        if (word == "") {
+    std::string_view command = line.substr(0, space);
+    const Rule* rule = findRule(command);
+    if (!rule) {
+        throw CommandException("Unknown command");
+    }
+    std::optional<std::string_view> argument;
+    if (rule->argument) {
+        argument = trim(line.substr(space));
+        if (argument->empty()) {
             throw CommandException("Command requires an argument");
         }
+    }
 
-        return new Command(command, word);
+    // The oldest command makes room for the new one once the history is full
+    Command* slot;
+    if (this->commands.size() < this->history) {
+        slot = new Command("");
+        this->commands.push_back(slot);
+    } else {
+        slot = this->commands[this->next];
+        this->next = (this->next + 1) % this->history;
     }
-    throw CommandException("Unknown command");
+    slot->assign(command, argument);
+    return slot;
 }
 
 Command* CommandProcessor::readCommand() {
@@ -137,39 +229,29 @@ Command* CommandProcessor::readCommand() {
     std::flush(std::cout);
     std::cin.clear();
     std::cin.sync();
-    std::string line = "";
-    while (line == "") {
-        std::getline(std::cin, line);
+    this->line.clear();
+    while (this->line == "") {
+        std::getline(std::cin, this->line);
     }
-    return this->parseCommand(line);
+    return this->parseCommand(this->line);
 }
 
 void CommandProcessor::saveCommand(Command* command) {
-    this->commands.push_back(command);
-    notify(this);
+    this->last = command;
+    this->processed++;
+    notify(Event::Kind::CommandSaved, this);
 }
 
-bool CommandProcessor::validate(Game::GameState state) {
-    Command* command = this->commands.back();
-
-    using S = Game::GameState;
-    static const std::unordered_map<std::string, std::vector<S>> valid {
-        { "loadmap", { S::Start, S::MapLoaded } },
-        { "validatemap", { S::MapLoaded } },
-        { "addplayer", { S::MapValidated, S::PlayersAdded } },
-        { "gamestart", { S::PlayersAdded } },
-        { "replay", { S::Win } },
-        { "quit", { S::Win } },
-        { "tournament", { S::Start } }
-    };
-
-    // Valid states for this command
-    auto validStates = valid.at(command->getCommand());
+bool CommandProcessor::isValid(std::string_view command, Game::GameState state) {
+    const Rule* rule = findRule(command);
+    return rule && (rule->states & bit(state));
+}
 
+bool CommandProcessor::validate(Game::GameState state) {
+    Command* command = this->last;
     std::string argument = command->getArgument().value_or("");
 
-    // Ugly C++ syntax to check if `state` is in `validStates`
-    if (std::find(validStates.begin(), validStates.end(), state) != validStates.end()) {
+    if (isValid(command->getCommand(), state)) {
         command->saveEffect("Command valid: " + command->getCommand() + " " + argument);
         return true;
     }
@@ -178,43 +260,66 @@ bool CommandProcessor::validate(Game::GameState state) {
     return false;
 }
 
+std::uint64_t CommandProcessor::getProcessed() const {
+    return this->processed;
+}
+
+std::size_t CommandProcessor::getRemembered() const {
+    return this->commands.size();
+}
+
+bool CommandProcessor::exhausted() const {
+    return false;
+}
+
 CommandProcessor& CommandProcessor::operator=(const CommandProcessor& other) {
+    if (this == &other) {
+        return *this;
+    }
     for (size_t i = 0; i < this->commands.size(); i++) {
         delete this->commands[i];
     }
 
     this->commands = {};
-    for (size_t i = 0; i < other.commands.size(); i++) {
-        this->commands.push_back(new Command(*other.commands[i]));
-    }
+    this->history = other.history;
+    this->next = 0;
+    this->last = nullptr;
+    this->processed = other.processed;
+    copyHistory(other);
 
     return *this;
 }
 
 std::string CommandProcessor::stringToLog() const {
-    std::cout << "log commandprocessor" << std::endl;
-    Command* command = this->commands.back();
-    std::string output = "CommandProcessor has processed : " + command->stringToLog();
+    std::string output = "CommandProcessor has processed : " + this->last->stringToLog();
     return output;
 }
 
 std::ostream& operator<<(std::ostream& out, const CommandProcessor& commandProcessor) {
     out << "Command processor holding commands : [";
-    for (size_t i = 0; i < commandProcessor.commands.size(); i++) {
-        out << *commandProcessor.commands[i] << ", ";
+    for (const Command* command : commandProcessor.ordered()) {
+        out << *command << ", ";
     }
     return out << "]";
 }
 
 FileCommandProcessorAdapter::FileCommandProcessorAdapter(std::istream* stream)
-    : stream(stream) { }
+    : stream(stream)
+    , position(0) { }
+
+FileCommandProcessorAdapter::FileCommandProcessorAdapter(const std::string& path)
+    : stream(nullptr)
+    , script(std::make_unique<MappedFile>(path))
+    , position(0) { }
 
 FileCommandProcessorAdapter::~FileCommandProcessorAdapter() {
     delete this->stream;
 }
 
 FileCommandProcessorAdapter& FileCommandProcessorAdapter::operator=(const FileCommandProcessorAdapter& other) {
-    this->stream->rdbuf(other.stream->rdbuf());
+    if (this->stream && other.stream) {
+        this->stream->rdbuf(other.stream->rdbuf());
+    }
     return *this;
 }
 
@@ -222,8 +327,20 @@ std::ostream& operator<<(std::ostream& out, const FileCommandProcessorAdapter& c
     return out << "FILE" << static_cast<const CommandProcessor&>(commandProcessor);
 }
 
+bool FileCommandProcessorAdapter::exhausted() const {
+    return this->script ? this->position >= this->script->size() : !*this->stream;
+}
+
 Command* FileCommandProcessorAdapter::readCommand() {
-    std::string line;
-    std::getline(*this->stream, line);
+    if (!this->script) {
+        this->line.clear();
+        std::getline(*this->stream, this->line);
+        return this->parseCommand(this->line);
+    }
+    // The line is parsed where it is mapped, only the command and its argument are copied
+    std::string_view rest(this->script->data() + this->position, this->script->size() - this->position);
+    size_t end = rest.find('\n');
+    std::string_view line = rest.substr(0, end);
+    this->position += end == std::string_view::npos ? rest.size() : end + 1;
     return this->parseCommand(line);
 }
@@ -1,15 +1,20 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <exception>
 #include <istream>
+#include <memory>
 #include <optional>
 #include <ostream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "CommandProcessing.fwd.h"
 #include "GameEngine.h"
 #include "LoggingObserver.h"
+#include "MappedFile.h"
 
 class Command : public Subject, public ILoggable {
 public:
@@ -19,6 +24,10 @@ public:
     ~Command();
 
     void saveEffect(std::string effect);
+    /**
+     * @brief Make this command another one, reusing its storage, with no effect yet.
+     */
+    void assign(std::string_view command, std::optional<std::string_view> argument);
 
     const std::string& getCommand() const;
     const std::optional<std::string>& getArgument() const;
@@ -45,14 +54,47 @@ private:
     std::string message;
 };
 
+/**
+ * @class CommandProcessor
+ *
+ * @brief Reads commands and checks them against the state of the game.
+ *
+ * Only the last commands are kept, in a ring whose commands are reused as new ones come,
+ * so a script of any length runs in constant memory.
+ */
 class CommandProcessor : public Subject, public ILoggable {
 public:
-    CommandProcessor() = default;
+    /** @brief Commands remembered by new processors. */
+    inline static std::size_t defaultHistory = 64;
+
+    /**
+     * @brief Remember the last history commands, at least one.
+     */
+    CommandProcessor(std::size_t history = defaultHistory);
     CommandProcessor(const CommandProcessor& other);
     virtual ~CommandProcessor();
 
     const Command* getCommand();
+    /**
+     * @brief Parse and save a command line that was read some other way, like from a socket.
+     *
+     * @throws CommandException if the line is not a command.
+     */
+    const Command* getCommand(const std::string& line);
     bool validate(Game::GameState state);
+    /**
+     * @brief Whether a command is valid in a state, one lookup in the state table.
+     */
+    static bool isValid(std::string_view command, Game::GameState state);
+
+    /** @brief Commands read since the start, remembered or not. */
+    std::uint64_t getProcessed() const;
+    /** @brief Commands remembered, the last ones read. */
+    std::size_t getRemembered() const;
+    /**
+     * @brief Whether no command is left to read, never for the console.
+     */
+    virtual bool exhausted() const;
 
     CommandProcessor& operator=(const CommandProcessor& other);
 
@@ -61,19 +103,48 @@ public:
     friend std::ostream& operator<<(std::ostream& out, const CommandProcessor& commandProcessor);
 
 protected:
-    Command* parseCommand(std::string line);
+    /**
+     * @brief Parse a line into the next command of the history, without copying it but for the fields.
+     *
+     * @throws CommandException if the line is not a command, the history is left as it was.
+     */
+    Command* parseCommand(std::string_view line);
     virtual Command* readCommand();
     void saveCommand(Command* command);
 
 private:
+    /** @brief Ring of the last commands, oldest at next once it is full. */
     std::vector<Command*> commands;
+    std::size_t history;
+    std::size_t next;
+    Command* last;
+    std::uint64_t processed;
+    /** @brief Line read from the console, reused. */
+    std::string line;
+
+    /** @brief The remembered commands from oldest to newest. */
+    std::vector<const Command*> ordered() const;
+    void copyHistory(const CommandProcessor& other);
 };
 
+/**
+ * @class FileCommandProcessorAdapter
+ *
+ * @brief Reads the commands from a stream, or from a script file mapped in memory one line at a time.
+ */
 class FileCommandProcessorAdapter : public CommandProcessor {
 public:
     FileCommandProcessorAdapter(std::istream* stream);
+    /**
+     * @brief Read the commands of the script at path, whose lines are parsed where they are mapped.
+     *
+     * @throws std::runtime_error if the file cannot be opened.
+     */
+    FileCommandProcessorAdapter(const std::string& path);
     ~FileCommandProcessorAdapter();
 
+    bool exhausted() const override;
+
     FileCommandProcessorAdapter& operator=(const FileCommandProcessorAdapter& other);
     friend std::ostream& operator<<(std::ostream& out, const FileCommandProcessorAdapter& commandProcessor);
 
@@ -82,4 +153,8 @@ protected:
 
 private:
     std::istream* stream;
+    std::unique_ptr<MappedFile> script;
+    /** @brief Offset of the next line in the script. */
+    std::size_t position;
+    std::string line;
 };
@@ -1,7 +1,10 @@
 #include "CommandProcessingDriver.h"
 #include "CommandProcessing.h"
 #include "GameEngine.h"
+#include "Profiler.h"
 
+#include <cstdio>
+#include <fstream>
 #include <iostream>
 #include <sstream>
 
@@ -60,6 +63,41 @@ void testCommandProcessing() {
         std::cout << e.what() << std::endl;
     }
 
+    // A long script streams from the mapped file through a small history
+    const std::string path = "commands.tmp";
+    const size_t lines = 200000;
+    {
+        std::ofstream script(path);
+        for (size_t i = 0; i < lines / 4; i++) {
+            script << "loadmap res/map/lp.map\n  validatemap  \naddplayer   Ann  aggressive \ngamestart\n";
+        }
+    }
+    FileCommandProcessorAdapter streamed(path);
+    Game::GameState states[] = { Game::GameState::Start, Game::GameState::MapLoaded, Game::GameState::MapValidated, Game::GameState::PlayersAdded };
+    size_t valid = 0;
+    Profiler& profiler = Profiler::instance();
+    for (size_t i = 0; i < lines; i++) {
+        if (i == lines / 2) {
+            // The history is full and its commands are reused from here on
+            profiler.enable("commands", false);
+        }
+        const Command* command = streamed.getCommand();
+        valid += CommandProcessor::isValid(command->getCommand(), states[i % 4]);
+    }
+    std::uint64_t allocations = profiler.get(Profiler::Counter::Allocations);
+    profiler.disable();
+    profiler.reset();
+    std::remove(path.c_str());
+    std::cout << "Streamed " << streamed.getProcessed() << " commands, every one valid in its state: " << (valid == lines) << std::endl
+              << "Only the last " << streamed.getRemembered() << " are remembered: " << (streamed.getRemembered() == CommandProcessor::defaultHistory) << std::endl
+              << "Reading the second half allocated nothing: " << (allocations == 0) << std::endl;
+    try {
+        std::cout << "Past the end of the script, got ";
+        streamed.getCommand();
+    } catch (const CommandException& e) {
+        std::cout << e.what() << std::endl;
+    }
+
     CommandProcessor cp;
     while (true) {
         try {
@@ -0,0 +1,355 @@
+#include "DistanceTable.h"
+#include "Map.h"
+
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+
+DistanceTable::DistanceTable(const Map& map, std::size_t matrixLimit, std::size_t threads)
+    : territories(map.territories.size())
+    , symmetric(true) {
+    // Adjacency by index, leaving out anything that is not a territory of this map
+    auto belongs = [&map](const Territory* t) {
+        return t->index < map.territories.size() && map.territories[t->index] == t;
+    };
+    this->offsets.reserve(this->territories + 1);
+    this->offsets.push_back(0);
+    for (auto t : map.territories) {
+        for (auto a : t->adjacent) {
+            if (belongs(a)) {
+                this->adjacent.push_back(static_cast<std::uint32_t>(a->index));
+            }
+        }
+        this->offsets.push_back(static_cast<std::uint32_t>(this->adjacent.size()));
+    }
+    for (std::size_t i = 0; i < this->territories && this->symmetric; i++) {
+        for (std::size_t j = this->offsets[i]; j < this->offsets[i + 1]; j++) {
+            auto begin = this->adjacent.begin() + this->offsets[this->adjacent[j]];
+            auto end = this->adjacent.begin() + this->offsets[this->adjacent[j] + 1];
+            if (std::find(begin, end, static_cast<std::uint32_t>(i)) == end) {
+                this->symmetric = false;
+                break;
+            }
+        }
+    }
+
+    if (this->territories <= matrixLimit) {
+        buildMatrix(threads);
+    } else {
+        buildLandmarks();
+    }
+}
+
+void DistanceTable::search(std::size_t from, std::vector<std::uint32_t>& distances, std::vector<std::uint32_t>& queue) const {
+    queue.clear();
+    queue.push_back(static_cast<std::uint32_t>(from));
+    distances[from] = 0;
+    for (std::size_t head = 0; head < queue.size(); head++) {
+        std::uint32_t current = queue[head];
+        std::uint32_t next = distances[current] + 1;
+        for (std::size_t j = this->offsets[current]; j < this->offsets[current + 1]; j++) {
+            std::uint32_t a = this->adjacent[j];
+            if (distances[a] == UNREACHABLE) {
+                distances[a] = next;
+                queue.push_back(a);
+            }
+        }
+    }
+}
+
+// Every row is an independent search, so the rows are split in chunks over the pool
+void DistanceTable::buildMatrix(std::size_t threads) {
+    std::size_t n = this->territories;
+    this->wide.assign(n * n, 0xFFFF);
+
+    auto rows = [this, n](std::size_t begin, std::size_t end) {
+        std::vector<std::uint32_t> distances;
+        std::vector<std::uint32_t> queue;
+        queue.reserve(n);
+        std::uint16_t farthest = 0;
+        for (std::size_t i = begin; i < end; i++) {
+            distances.assign(n, UNREACHABLE);
+            search(i, distances, queue);
+            std::uint16_t* row = &this->wide[i * n];
+            for (auto t : queue) {
+                row[t] = static_cast<std::uint16_t>(distances[t]);
+                farthest = std::max(farthest, row[t]);
+            }
+        }
+        return farthest;
+    };
+
+    std::uint16_t diameter = 0;
+    if (threads <= 1 || n < 256) {
+        diameter = rows(0, n);
+    } else {
+        ThreadPool pool(threads);
+        std::size_t chunks = threads * 4;
+        std::vector<std::future<std::uint16_t>> results;
+        results.reserve(chunks);
+        for (std::size_t c = 0; c < chunks; c++) {
+            std::size_t begin = c * n / chunks;
+            std::size_t end = (c + 1) * n / chunks;
+            results.push_back(pool.submit([&rows, begin, end]() { return rows(begin, end); }));
+        }
+        for (auto& result : results) {
+            diameter = std::max(diameter, result.get());
+        }
+    }
+
+    // Most maps are small-world enough for a byte per pair
+    if (diameter < 0xFF) {
+        this->narrow.resize(n * n);
+        std::transform(this->wide.begin(), this->wide.end(), this->narrow.begin(), [](std::uint16_t d) {
+            return d == 0xFFFF ? std::uint8_t(0xFF) : static_cast<std::uint8_t>(d);
+        });
+        this->wide.clear();
+        this->wide.shrink_to_fit();
+    }
+}
+
+// Landmarks are picked one after the other as far as possible from the previous ones,
+// a territory that none of them reach being the farthest of all
+void DistanceTable::buildLandmarks() {
+    std::size_t n = this->territories;
+    std::size_t count = std::min(LANDMARKS, n);
+    this->landmarkDistances.assign(count * n, UNREACHABLE);
+
+    std::vector<std::uint32_t> closest(n, UNREACHABLE);
+    std::vector<std::uint32_t> queue;
+    queue.reserve(n);
+    std::size_t next = 0;
+    for (std::size_t l = 0; l < count; l++) {
+        this->landmarks.push_back(static_cast<std::uint32_t>(next));
+        std::vector<std::uint32_t> distances(n, UNREACHABLE);
+        search(next, distances, queue);
+        std::copy(distances.begin(), distances.end(), this->landmarkDistances.begin() + l * n);
+
+        for (std::size_t i = 0; i < n; i++) {
+            closest[i] = std::min(closest[i], distances[i]);
+            if (closest[i] > closest[next]) {
+                next = i;
+            }
+        }
+        if (closest[next] == 0) {
+            break;
+        }
+    }
+}
+
+std::uint32_t DistanceTable::estimate(std::size_t from, std::size_t to) const {
+    std::size_t n = this->territories;
+    std::uint32_t bound = 0;
+    for (std::size_t l = 0; l < this->landmarks.size(); l++) {
+        std::uint32_t toLandmark = this->landmarkDistances[l * n + to];
+        std::uint32_t fromLandmark = this->landmarkDistances[l * n + from];
+        if (fromLandmark == UNREACHABLE) {
+            continue;
+        }
+        if (toLandmark == UNREACHABLE) {
+            // The landmark reaches from but not to, so from cannot reach to either
+            return UNREACHABLE;
+        }
+        if (toLandmark > fromLandmark) {
+            bound = std::max(bound, toLandmark - fromLandmark);
+        } else if (this->symmetric) {
+            bound = std::max(bound, fromLandmark - toLandmark);
+        }
+    }
+    return bound;
+}
+
+std::vector<std::size_t> DistanceTable::search(std::size_t from, std::size_t to) const {
+    if (estimate(from, to) == UNREACHABLE) {
+        return {};
+    }
+
+    // The landmark bounds are consistent, so a territory never needs to be expanded twice
+    using Entry = std::pair<std::uint32_t, std::uint32_t>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+    std::unordered_map<std::uint32_t, std::uint32_t> cost;
+    std::unordered_map<std::uint32_t, std::uint32_t> parent;
+    std::unordered_set<std::uint32_t> closed;
+    cost[from] = 0;
+    open.emplace(estimate(from, to), static_cast<std::uint32_t>(from));
+
+    while (!open.empty()) {
+        std::uint32_t current = open.top().second;
+        open.pop();
+        if (!closed.insert(current).second) {
+            continue;
+        }
+        if (current == to) {
+            std::vector<std::size_t> path { to };
+            while (path.back() != from) {
+                path.push_back(parent.at(static_cast<std::uint32_t>(path.back())));
+            }
+            std::reverse(path.begin(), path.end());
+            return path;
+        }
+        std::uint32_t next = cost[current] + 1;
+        for (std::size_t j = this->offsets[current]; j < this->offsets[current + 1]; j++) {
+            std::uint32_t a = this->adjacent[j];
+            auto known = cost.find(a);
+            if (known != cost.end() && known->second <= next) {
+                continue;
+            }
+            std::uint32_t bound = estimate(a, to);
+            if (bound == UNREACHABLE) {
+                continue;
+            }
+            cost[a] = next;
+            parent[a] = current;
+            open.emplace(next + bound, a);
+        }
+    }
+    return {};
+}
+
+std::size_t DistanceTable::size() const {
+    return this->territories;
+}
+
+bool DistanceTable::isMatrix() const {
+    return this->landmarks.empty();
+}
+
+std::size_t DistanceTable::memory() const {
+    return this->narrow.size() * sizeof(std::uint8_t)
+        + this->wide.size() * sizeof(std::uint16_t)
+        + this->landmarkDistances.size() * sizeof(std::uint32_t);
+}
+
+std::uint32_t DistanceTable::distance(std::size_t from, std::size_t to) const {
+    std::size_t n = this->territories;
+    if (!this->narrow.empty()) {
+        std::uint8_t d = this->narrow[from * n + to];
+        return d == 0xFF ? UNREACHABLE : d;
+    }
+    if (!this->wide.empty()) {
+        std::uint16_t d = this->wide[from * n + to];
+        return d == 0xFFFF ? UNREACHABLE : d;
+    }
+    if (from == to) {
+        return 0;
+    }
+    std::vector<std::size_t> found = search(from, to);
+    return found.empty() ? UNREACHABLE : static_cast<std::uint32_t>(found.size() - 1);
+}
+
+std::uint32_t DistanceTable::distance(const Territory* from, const Territory* to) const {
+    return distance(from->index, to->index);
+}
+
+std::size_t DistanceTable::nextHop(std::size_t from, std::size_t to) const {
+    if (from == to) {
+        return from;
+    }
+    if (!isMatrix()) {
+        std::vector<std::size_t> found = search(from, to);
+        return found.size() > 1 ? found[1] : from;
+    }
+    std::uint32_t remaining = distance(from, to);
+    if (remaining == UNREACHABLE) {
+        return from;
+    }
+    for (std::size_t j = this->offsets[from]; j < this->offsets[from + 1]; j++) {
+        if (distance(this->adjacent[j], to) == remaining - 1) {
+            return this->adjacent[j];
+        }
+    }
+    return from;
+}
+
+// The neighbour is looked up in the territory's own adjacency, so it belongs to the same copy of the map
+static Territory* adjacentWithIndex(const Territory* from, std::size_t index) {
+    for (auto a : from->getAdjacent()) {
+        if (a->getIndex() == index) {
+            return a;
+        }
+    }
+    return nullptr;
+}
+
+Territory* DistanceTable::nextHop(const Territory* from, const Territory* to) const {
+    std::size_t next = nextHop(from->index, to->index);
+    return next == from->index ? nullptr : adjacentWithIndex(from, next);
+}
+
+std::vector<std::size_t> DistanceTable::path(std::size_t from, std::size_t to) const {
+    if (!isMatrix()) {
+        return from == to ? std::vector<std::size_t> { from } : search(from, to);
+    }
+    if (distance(from, to) == UNREACHABLE) {
+        return {};
+    }
+    std::vector<std::size_t> path { from };
+    while (path.back() != to) {
+        path.push_back(nextHop(path.back(), to));
+    }
+    return path;
+}
+
+std::size_t DistanceTable::stepTowards(std::size_t from, const std::vector<std::size_t>& targets) const {
+    if (isMatrix()) {
+        std::size_t closest = from;
+        std::uint32_t best = UNREACHABLE;
+        for (auto t : targets) {
+            std::uint32_t d = distance(from, t);
+            if (d < best) {
+                best = d;
+                closest = t;
+            }
+        }
+        return nextHop(from, closest);
+    }
+
+    // Without the matrix, a single search from the territory finds the closest target first
+    std::unordered_set<std::size_t> wanted(targets.begin(), targets.end());
+    if (wanted.count(from)) {
+        return from;
+    }
+    std::unordered_map<std::uint32_t, std::uint32_t> parent;
+    std::vector<std::uint32_t> queue { static_cast<std::uint32_t>(from) };
+    parent[static_cast<std::uint32_t>(from)] = static_cast<std::uint32_t>(from);
+    for (std::size_t head = 0; head < queue.size(); head++) {
+        std::uint32_t current = queue[head];
+        for (std::size_t j = this->offsets[current]; j < this->offsets[current + 1]; j++) {
+            std::uint32_t a = this->adjacent[j];
+            if (!parent.emplace(a, current).second) {
+                continue;
+            }
+            if (wanted.count(a)) {
+                while (parent[a] != from) {
+                    a = parent[a];
+                }
+                return a;
+            }
+            queue.push_back(a);
+        }
+    }
+    return from;
+}
+
+Territory* DistanceTable::stepTowards(const Territory* from, const std::vector<Territory*>& targets) const {
+    std::vector<std::size_t> indices;
+    indices.reserve(targets.size());
+    for (auto t : targets) {
+        indices.push_back(t->index);
+    }
+    std::size_t next = stepTowards(from->index, indices);
+    return next == from->index ? nullptr : adjacentWithIndex(from, next);
+}
+
+std::ostream& operator<<(std::ostream& out, const DistanceTable& table) {
+    out << "This DistanceTable covers " << table.territories << " territories";
+    if (table.isMatrix()) {
+        out << " with a matrix of " << (table.narrow.empty() ? 2 : 1) << " byte per pair";
+    } else {
+        out << " with " << table.landmarks.size() << " landmarks";
+    }
+    return out << " (" << table.memory() << " bytes).";
+}
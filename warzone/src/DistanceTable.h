@@ -0,0 +1,111 @@
+#pragma once
+
+#include "ThreadPool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <vector>
+
+class Map;
+class Territory;
+
+/**
+ * @class DistanceTable
+ *
+ * @brief Precomputed hop distances between the territories of a map.
+ *
+ * Maps of up to `MATRIX_LIMIT` territories keep the full all-pairs matrix, built with one
+ * breadth-first search per territory spread over a thread pool, and stored with one byte per
+ * pair when the map's diameter allows it. Larger maps only keep the distances from a few
+ * far-apart landmarks, which give the lower bounds for an A* search on each query.
+ *
+ * The table only depends on the structure of the map, so every copy of a map can share it.
+ * Territories are identified by their index in the map (Territory::getIndex).
+ */
+class DistanceTable {
+public:
+    /** @brief Distance between territories that are not connected. */
+    static constexpr std::uint32_t UNREACHABLE = std::numeric_limits<std::uint32_t>::max();
+    /** @brief Largest map that gets the full matrix. */
+    static constexpr std::size_t MATRIX_LIMIT = 4096;
+    /** @brief Number of landmarks for the maps over the limit. */
+    static constexpr std::size_t LANDMARKS = 16;
+
+    /**
+     * @brief Compute the distances of the given map.
+     *
+     * @param matrixLimit Largest number of territories for which the full matrix is stored.
+     * @param threads Number of threads used for the matrix.
+     */
+    DistanceTable(const Map& map, std::size_t matrixLimit = MATRIX_LIMIT, std::size_t threads = ThreadPool::defaultSize());
+
+    std::size_t size() const;
+    /**
+     * @brief Whether every distance is stored, rather than searched for using landmarks.
+     */
+    bool isMatrix() const;
+    /**
+     * @brief Bytes used by the distances.
+     */
+    std::size_t memory() const;
+
+    /**
+     * @brief Smallest number of moves from one territory to another, or UNREACHABLE.
+     */
+    std::uint32_t distance(std::size_t from, std::size_t to) const;
+    std::uint32_t distance(const Territory* from, const Territory* to) const;
+
+    /**
+     * @brief Territories on a shortest path, both ends included, or nothing if unreachable.
+     */
+    std::vector<std::size_t> path(std::size_t from, std::size_t to) const;
+
+    /**
+     * @brief First territory to move to on a shortest path, or `from` if there is none.
+     */
+    std::size_t nextHop(std::size_t from, std::size_t to) const;
+    Territory* nextHop(const Territory* from, const Territory* to) const;
+
+    /**
+     * @brief First territory to move to on the way to the closest of the targets.
+     *
+     * @return Index of the adjacent territory to move to, or `from` if no target is reachable or `from` is one of them.
+     */
+    std::size_t stepTowards(std::size_t from, const std::vector<std::size_t>& targets) const;
+    /**
+     * @return Adjacent territory to move to, or nullptr if no target is reachable or `from` is one of them.
+     */
+    Territory* stepTowards(const Territory* from, const std::vector<Territory*>& targets) const;
+
+    friend std::ostream& operator<<(std::ostream& out, const DistanceTable& table);
+
+private:
+    std::size_t territories;
+    /** @brief Compressed adjacency, the neighbours of `i` are `adjacent[offsets[i]..offsets[i + 1]]`. */
+    std::vector<std::uint32_t> offsets;
+    std::vector<std::uint32_t> adjacent;
+    /** @brief Whether every adjacency goes both ways, which tightens the landmark bounds. */
+    bool symmetric;
+
+    /** @brief Row-major matrix when every distance fits in a byte, 0xFF is unreachable. */
+    std::vector<std::uint8_t> narrow;
+    /** @brief Row-major matrix otherwise, 0xFFFF is unreachable. */
+    std::vector<std::uint16_t> wide;
+
+    /** @brief Landmarks, with the distances from each of them in `landmarkDistances[l * territories + i]`. */
+    std::vector<std::uint32_t> landmarks;
+    std::vector<std::uint32_t> landmarkDistances;
+
+    /**
+     * @brief Breadth-first search from one territory, `distances` must hold UNREACHABLE everywhere.
+     */
+    void search(std::size_t from, std::vector<std::uint32_t>& distances, std::vector<std::uint32_t>& queue) const;
+    void buildMatrix(std::size_t threads);
+    void buildLandmarks();
+    /** @brief Lower bound on the distance given by the landmarks. */
+    std::uint32_t estimate(std::size_t from, std::size_t to) const;
+    /** @brief A* search guided by the landmarks. */
+    std::vector<std::size_t> search(std::size_t from, std::size_t to) const;
+};
@@ -1,6 +1,8 @@
 #include "GameEngine.h"
+#include "Profiler.h"
 
 #include <algorithm>
+#include <filesystem>
 #include <iostream>
 #include <limits>
 #include <optional>
@@ -12,10 +14,15 @@
 
 #include "CommandProcessing.h"
 #include "Map.h"
+#include "MapCache.h"
+#include "MapIndex.h"
 #include "Orders.h"
 #include "Player.fwd.h"
 #include "Player.h"
 #include "PlayerStrategies.h"
+#include "ProcessRunner.h"
+#include "ThreadPool.h"
+#include "Zobrist.h"
 
 using GameState = Game::GameState;
 
@@ -25,7 +32,18 @@ Game::Game(CommandProcessor* cp)
     , map(new Map)
     , state(GameState::Start)
     , deck(new Deck)
-    , cp(cp) {
+    , cp(cp)
+    , seed(defaultSeed.value_or(std::random_device {}()))
+    , parallelOrders(defaultParallelOrders)
+    , turn(0)
+    , endReason(EndReason::None)
+    , leader(nullptr)
+    , ownerChanges(0)
+    , turnsWithoutConquest(0)
+    , turnsLeft(0)
+    , midTurn(false)
+    , issuing(0)
+    , asking(false) {
 }
 
 Game::Game()
@@ -38,7 +56,18 @@ Game::Game(Map* map)
     , map(map)
     , state(GameState::Start)
     , deck(new Deck)
-    , cp(new CommandProcessor) {
+    , cp(new CommandProcessor)
+    , seed(defaultSeed.value_or(std::random_device {}()))
+    , parallelOrders(defaultParallelOrders)
+    , turn(0)
+    , endReason(EndReason::None)
+    , leader(nullptr)
+    , ownerChanges(0)
+    , turnsWithoutConquest(0)
+    , turnsLeft(0)
+    , midTurn(false)
+    , issuing(0)
+    , asking(false) {
 }
 
 Game::~Game() {
@@ -60,11 +89,23 @@ Game::Game(const Game& other)
     deck = new Deck(*other.deck);
     state = other.state;
     cp = other.cp;
+    seed = other.seed;
+    parallelOrders = other.parallelOrders;
+    turn = other.turn;
+    endReason = other.endReason;
+    leader = copyOf(other, other.leader);
+    positions = other.positions;
+    ownerChanges = other.ownerChanges;
+    turnsWithoutConquest = other.turnsWithoutConquest;
+    turnsLeft = other.turnsLeft;
+    midTurn = other.midTurn;
+    issuing = other.issuing;
+    asking = other.asking;
 }
 
 void Game::transition(GameState state) {
     this->state = state;
-    notify(this);
+    notify(Event::Kind::StateChanged, this);
 }
 
 void Game::observe(Observer* observer) {
@@ -77,13 +118,21 @@ void Game::observerPlayers(Observer* observer) {
 }
 
 void Game::loadmap(std::ifstream file) {
+    delete this->map;
     this->map = MapLoader(file).parse();
 }
 
+void Game::loadmap(const std::string& path) {
+    delete this->map;
+    this->map = nullptr;
+    this->map = MapCache::instance().load(path);
+}
+
 bool Game::validatemap() {
     if (!this->map->validate()) {
         std::cout << "The loaded map is invalid. Please choose a valid map." << std::endl;
         delete this->map;
+        this->map = new Map();
         return false;
     }
     std::cout << "Map validated." << std::endl;
@@ -91,6 +140,8 @@ bool Game::validatemap() {
 }
 
 void Game::addplayer(Player* p) {
+    // Players are identified by seat, so the same game hashes the same way in every run
+    p->setZobristKey(Zobrist::key(Zobrist::Feature::Player, this->players.size()));
     this->players.push_back(p);
     p->initStrategy(this->map, this->deck, &this->players);
 }
@@ -99,6 +150,17 @@ void Game::gamestart() {
     std::default_random_engine gen(1);
     // shuffle player list
     std::shuffle(this->players.begin(), this->players.end(), gen);
+    // every player and the deck get their own stream, so they draw the same numbers whatever the others do
+    std::seed_seq deckSeed { this->seed, 0u };
+    std::uint32_t deckState;
+    deckSeed.generate(&deckState, &deckState + 1);
+    this->deck->seed(deckState);
+    for (size_t i = 0; i < this->players.size(); i++) {
+        std::seed_seq playerSeed { this->seed, static_cast<std::uint32_t>(i + 1) };
+        std::uint32_t playerState;
+        playerSeed.generate(&playerState, &playerState + 1);
+        this->players[i]->seed(playerState);
+    }
     std::cout << "The player order is:" << std::endl;
     // print the player order and add reinforcement pool
     for (size_t i = 0; i < this->players.size(); i++) {
@@ -116,8 +178,7 @@ void Game::gamestart() {
     // Have each player draw 2 cards
     for (size_t i = 0; i < this->players.size(); i++) {
         for (size_t j = 0; j < 2; j++) {
-            Card* card = this->deck->draw();
-            this->players[i]->addCardToHand(card);
+            this->players[i]->addCardToHand(this->deck->draw());
         }
     }
     std::cout << "Players have been awarded 2 cards each" << std::endl;
@@ -125,11 +186,14 @@ void Game::gamestart() {
 }
 
 void Game::startupPhase() {
-    while (this->state != GameState::FirstReinforcements) {
+    while (this->state != GameState::FirstReinforcements && this->state != GameState::Tournament) {
         const Command* command;
         try {
             command = cp->getCommand();
         } catch (CommandException& e) {
+            if (cp->exhausted()) {
+                throw std::runtime_error("The commands ended before the game started");
+            }
             std::cout << "Please enter a valid command. " << e.what() << std::endl;
             continue;
         }
@@ -137,34 +201,133 @@ void Game::startupPhase() {
             std::cout << "Please enter a valid command. " << command->getEffect().value_or("") << std::endl;
             continue;
         }
-        if (command->getCommand() == "tournament") {
-            tournament(command->getArgument().value());
-        }
+        runCommand(*command);
+        command = nullptr;
+    }
+}
 
-        if ((command->getCommand() == "loadmap")) {
+std::string Game::runCommand(const Command& command) {
+    const std::string& name = command.getCommand();
+    std::string argument = command.getArgument().value_or("");
+    if (name == "tournament") {
+        tournament(argument);
+    }
+    if (name == "loadmap") {
+        std::string effect = "Map " + argument + " loaded.";
+        try {
+            loadmap(argument);
+        } catch (std::exception& e) {
+            effect = std::string("Could not load the map. ") + e.what();
+            std::cout << effect << std::endl;
+            this->map = new Map();
+        }
+        transition(GameState::MapLoaded);
+        return effect;
+    }
+    if (name == "validatemap") {
+        if (!this->validatemap()) {
+            std::string effect = "The loaded map is not valid. Please load another map.";
+            std::cout << effect << std::endl;
+            transition(GameState::Start);
+            return effect;
+        }
+        transition(GameState::MapValidated);
+        return "Map validated.";
+    }
+    if (name == "addplayer") {
+        // addplayer <name> [<strategy>], a player given no strategy is human
+        std::string player = argument;
+        Strategy strategy = HumanPlayer();
+        std::size_t space = argument.find_last_of(' ');
+        if (space != std::string::npos) {
+            if (std::optional<Strategy> named = strategyFromName(argument.substr(space + 1))) {
+                strategy = *named;
+                player = argument.substr(0, argument.find_last_not_of(' ', space) + 1);
+            }
+        }
+        addplayer(new Player(player, strategy));
+        transition(GameState::PlayersAdded);
+        return "Player " + player + " added, playing " + strategyName(strategy) + ".";
+    }
+    if (name == "gamestart") {
+        this->gamestart();
+        transition(GameState::FirstReinforcements);
+        return "Game started.";
+    }
+    if (name == "play") {
+        this->turnsLeft = std::stoul(argument);
+        return resumeTurns();
+    }
+    return "";
+}
 
-            loadmap(std::ifstream(command->getArgument().value()));
-            transition(GameState::MapLoaded);
+std::string Game::resumeTurns() {
+    while (this->midTurn || (this->turnsLeft > 0 && !gameEnded() && this->endReason == EndReason::None)) {
+        if (!this->midTurn) {
+            beginTurn();
+            std::cout << "\n=== Issue Orders Phase ===" << std::endl;
+            this->midTurn = true;
+            this->issuing = 0;
         }
-        if (command->getCommand() == "validatemap") {
-            if (!this->validatemap()) {
-                std::cout << "The loaded map is not valid. Please load another map." << std::endl;
-                transition(GameState::Start);
+        // Each player issues in turn, the turn stops at a human until its questions are answered
+        while (this->issuing < this->players.size()) {
+            Player* player = this->players[this->issuing];
+            if (!this->asking) {
+                player->beginOrders();
+                this->asking = true;
+            }
+            if (std::optional<std::string> question = player->prompt()) {
+                return *question;
             }
-            transition(GameState::MapValidated);
+            this->asking = false;
+            this->issuing++;
         }
-        if (command->getCommand() == "addplayer") {
-            std::string name = command->getArgument().value();
-            this->players.push_back(new Player(name, map, deck, this->players));
-            transition(GameState::PlayersAdded);
+        this->midTurn = false;
+        endTurn();
+        this->turnsLeft--;
+    }
+
+    Player* winner = outcome();
+    if (!winner && this->endReason == EndReason::None) {
+        return "Played to turn " + std::to_string(this->turn) + ".";
+    }
+    transition(GameState::Win);
+    if (winner) {
+        return "Game over after " + std::to_string(this->turn) + " turns, " + winner->getName() + " wins.";
+    }
+    return "Game over after " + std::to_string(this->turn) + " turns, draw by " + endReasonString(this->endReason) + ".";
+}
+
+std::string Game::applyCommand(const std::string& line) {
+    if (this->asking) {
+        // A human waits for an answer, the line is that answer rather than a command
+        Player* player = this->players[this->issuing];
+        std::string error = player->answer(line);
+        if (!error.empty()) {
+            return error + "\n" + player->prompt().value_or("");
         }
-        if (command->getCommand() == "gamestart") {
-            this->gamestart();
-            transition(GameState::FirstReinforcements);
-            command = nullptr;
-            return;
+        try {
+            return resumeTurns();
+        } catch (std::exception& e) {
+            return std::string("Command failed. ") + e.what();
         }
-        command = nullptr;
+    }
+    const Command* command;
+    try {
+        command = this->cp->getCommand(line);
+    } catch (CommandException& e) {
+        return std::string("Please enter a valid command. ") + e.what();
+    }
+    if (!this->cp->validate(this->state)) {
+        return "Please enter a valid command. " + command->getEffect().value_or("");
+    }
+    if (command->getCommand() == "tournament") {
+        return "Tournaments only run from the console or a file.";
+    }
+    try {
+        return runCommand(*command);
+    } catch (std::exception& e) {
+        return std::string("Command failed. ") + e.what();
     }
 }
 
@@ -174,43 +337,129 @@ void Game::mainGameLoop() {
 
 Player* Game::mainGameLoop(size_t turns) {
     // allow all turns to execute or game to end
-    while (!gameEnded() && turns > 0) {
-        for (auto& p : players) {
-            p->clearFriends();
-        }
-        removeDefeatedPlayers();
-        if (state != GameState::AssignReinforcements && state != GameState::FirstReinforcements)
-            transition(GameState::AssignReinforcements);
-        reinforcementPhase();
-        transition(GameState::IssueOrders);
+    while (!gameEnded() && this->endReason == EndReason::None && turns > 0) {
+        PROFILE_SCOPE("turn");
+        beginTurn();
         issueOrdersPhase();
-        transition(GameState::ExecuteOrders);
-        executeOrdersPhase();
+        endTurn();
         turns--;
     }
+    return outcome();
+}
+
+void Game::beginTurn() {
+    for (auto& p : players) {
+        p->clearFriends();
+    }
+    removeDefeatedPlayers();
+    if (state != GameState::AssignReinforcements && state != GameState::FirstReinforcements)
+        transition(GameState::AssignReinforcements);
+    reinforcementPhase();
+    transition(GameState::IssueOrders);
+}
+
+void Game::endTurn() {
+    transition(GameState::ExecuteOrders);
+    executeOrdersPhase();
+    turn++;
+    detectEarlyEnd();
+}
+
+Player* Game::copyOf(const Game& other, const Player* player) const {
+    auto it = std::find(other.players.begin(), other.players.end(), player);
+    return it == other.players.end() ? nullptr : this->players[it - other.players.begin()];
+}
+
+Player* Game::outcome() {
+    if (this->endReason == EndReason::None && gameEnded()) {
+        this->endReason = EndReason::Conquest;
+    }
+    if (this->endReason == EndReason::Decided) {
+        std::cout << "Game Over! Player " << this->leader->getName() << " wins, the game is decided." << std::endl;
+        return this->leader;
+    }
+    if (this->endReason != EndReason::None && this->endReason != EndReason::Conquest) {
+        std::cout << "Game Over! Draw by " << endReasonString(this->endReason) << "." << std::endl;
+        return nullptr;
+    }
 
     if (!players.empty()) {
-        // if a player has won
-        if (players.size() == 1) {
-            std::cout << "Game Over! Player " << players[0]->getName() << " wins!" << std::endl;
+        // The last player standing, or the one who took every territory before the others were removed
+        Player* winner = players.size() == 1 ? players[0] : map->getBoard().soleOwner();
+        if (winner) {
+            std::cout << "Game Over! Player " << winner->getName() << " wins!" << std::endl;
         }
         // if 2 or more players are still in the game when it ends
-        else {
-            return nullptr;
-        }
+        return winner;
     }
     return players[0];
 }
 
+void Game::detectEarlyEnd() {
+    if (gameEnded() || hasHumans()) {
+        return;
+    }
+
+    std::vector<std::int32_t> position = this->map->getBoard().position();
+    for (Player* player : this->players) {
+        position.push_back(player->getPool());
+    }
+    if (++this->positions[std::move(position)] >= REPETITIONS) {
+        this->endReason = EndReason::Repetition;
+        return;
+    }
+
+    if (this->map->getOwnerChanges() != this->ownerChanges) {
+        this->ownerChanges = this->map->getOwnerChanges();
+        this->turnsWithoutConquest = 0;
+    } else if (++this->turnsWithoutConquest >= STALEMATE_TURNS) {
+        this->endReason = EndReason::Stalemate;
+        return;
+    }
+
+    if (std::all_of(this->players.begin(), this->players.end(), [](Player* player) { return isPassive(player->getStrategy()); })) {
+        this->endReason = EndReason::Passive;
+        return;
+    }
+
+    // Armies on the board and in the pool, the leader must be able to attack to finish the game
+    const Board& board = this->map->getBoard();
+    Player* strongest = nullptr;
+    long strongestArmies = 0;
+    long totalArmies = 0;
+    for (Player* player : this->players) {
+        long armies = player->getPool() + static_cast<long>(board.armiesOf(player));
+        totalArmies += armies;
+        if (!strongest || armies > strongestArmies) {
+            strongest = player;
+            strongestArmies = armies;
+        }
+    }
+    if (isPassive(strongest->getStrategy()) || strongestArmies < DECIDED_RATIO * (totalArmies - strongestArmies)) {
+        return;
+    }
+    // Nor may any of the leader's territories be outnumbered by the enemy stacks next to it
+    std::vector<std::int64_t> threats = board.threats(strongest);
+    for (size_t i = 0; i < threats.size(); i++) {
+        if (threats[i] > board.getArmies(i)) {
+            return;
+        }
+    }
+    this->endReason = EndReason::Decided;
+    this->leader = strongest;
+}
+
 int Game::calculateReinforcements(Player* player) {
-    int reinforcements = player->getTerritories() / 3;
-    reinforcements += map->continentRewards(player);
+    const Board& board = map->getBoard();
+    int reinforcements = static_cast<int>(board.territoriesOf(player) / 3);
+    reinforcements += board.continentRewards(player);
     if (reinforcements < 3)
         reinforcements = 3;
     return reinforcements;
 }
 
 void Game::reinforcementPhase() {
+    PROFILE_SCOPE("reinforcementPhase");
     std::cout << "\n=== Reinforcement Phase ===" << std::endl;
 
     for (Player* player : players) {
@@ -224,19 +473,37 @@ void Game::reinforcementPhase() {
 }
 
 void Game::issueOrdersPhase() {
+    PROFILE_SCOPE("issueOrdersPhase");
     std::cout << "\n=== Issue Orders Phase ===" << std::endl;
 
-    for (Player* player : players) {
-        player->issueOrder();
-
-        Order* order = nullptr;
-        while ((order = player->getNextOrder()) != nullptr) {
-            order->execute();
+    // The orders are only executed in the next phase, so the players all see the board as it was at the start
+    bool concurrent = this->parallelOrders && this->players.size() > 1
+        && std::all_of(this->players.begin(), this->players.end(), [](Player* player) { return player->issuesConcurrently(); });
+    if (!concurrent) {
+        for (Player* player : players) {
+            player->issueOrder();
         }
+        return;
+    }
+
+    // Each player only touches its own orders, hand and generator, and the orders are
+    // then executed in player order, so the result is the same as issuing serially
+    static ThreadPool pool;
+    std::vector<std::future<void>> issued;
+    issued.reserve(this->players.size());
+    for (Player* player : players) {
+        issued.push_back(pool.submit([player]() { player->issueOrder(); }));
+    }
+    for (auto& f : issued) {
+        f.wait();
+    }
+    for (auto& f : issued) {
+        f.get();
     }
 }
 
 void Game::executeOrdersPhase() {
+    PROFILE_SCOPE("executeOrdersPhase");
     std::cout << "\n=== Execute Orders Phase ===" << std::endl;
 
     // Execute all deploy orders first
@@ -246,6 +513,7 @@ void Game::executeOrdersPhase() {
         for (Player* player : players) {
             Order* order = player->getNextOrder();
             if (order && dynamic_cast<DeployOrder*>(order)) {
+                PROFILE_SCOPE("execute " + order->getName());
                 order->execute();
                 delete order;
                 deployOrdersRemaining = true;
@@ -260,6 +528,7 @@ void Game::executeOrdersPhase() {
         for (Player* player : players) {
             Order* order = player->getNextOrder();
             if (order) {
+                PROFILE_SCOPE("execute " + order->getName());
                 order->execute();
                 delete order;
                 ordersRemaining = true;
@@ -272,16 +541,12 @@ bool Game::gameEnded() {
     if (players.size() <= 1)
         return true;
 
-    for (Player* player : players) {
-        if (player->getTerritories() == map->getNumberTerritories()) {
-            return true;
-        }
-    }
-    return false;
+    return map->getBoard().soleOwner() != nullptr;
 }
 
 void Game::removeDefeatedPlayers() {
-    auto it = std::remove_if(players.begin(), players.end(), [](Player* player) { return player->getTerritories() == 0; });
+    // partition keeps the defeated players at the end, remove_if would leave copies of the survivors there
+    auto it = std::stable_partition(players.begin(), players.end(), [](Player* player) { return player->getTerritories() != 0; });
 
     for (auto toDelete = it; toDelete != players.end(); ++toDelete) {
         std::cout << "Player " << (*toDelete)->getName()
@@ -294,8 +559,70 @@ void Game::removeDefeatedPlayers() {
 void Game::tournament(std::string argument) {
     Tournament* tournament = new Tournament(argument);
     tournament->executeTournament();
+    this->tournamentWinners = tournament->getWinners();
     delete tournament;
-    exit(0);
+    transition(GameState::Tournament);
+}
+
+const std::vector<std::string>& Game::getTournamentWinners() const {
+    return this->tournamentWinners;
+}
+
+void Game::setSeed(std::uint32_t seed) {
+    this->seed = seed;
+}
+
+std::uint32_t Game::getSeed() const {
+    return this->seed;
+}
+
+std::uint64_t Game::hash() const {
+    std::uint64_t hash = this->map->getHash();
+    for (Player* p : this->players) {
+        hash ^= p->hash();
+    }
+    if (this->turn % 2) {
+        hash ^= Zobrist::key(Zobrist::Feature::Turn, 1);
+    }
+    return hash;
+}
+
+size_t Game::getTurn() const {
+    return this->turn;
+}
+
+Game::GameState Game::getState() const {
+    return this->state;
+}
+
+bool Game::hasHumans() const {
+    return std::any_of(this->players.begin(), this->players.end(), [](Player* player) { return std::holds_alternative<HumanPlayer>(player->getStrategy()); });
+}
+
+Game::EndReason Game::getEndReason() const {
+    return this->endReason;
+}
+
+std::string Game::endReasonString(EndReason reason) {
+    switch (reason) {
+    case EndReason::None:
+        return "turn limit";
+    case EndReason::Conquest:
+        return "conquest";
+    case EndReason::Stalemate:
+        return "stalemate";
+    case EndReason::Repetition:
+        return "repetition";
+    case EndReason::Passive:
+        return "passive players";
+    case EndReason::Decided:
+        return "decided";
+    }
+    return "";
+}
+
+void Game::setParallelOrders(bool parallel) {
+    this->parallelOrders = parallel;
 }
 
 Game& Game::operator=(const Game& other) {
@@ -315,6 +642,18 @@ Game& Game::operator=(const Game& other) {
         delete deck;
         deck = new Deck(*other.deck);
         state = other.state;
+        seed = other.seed;
+        parallelOrders = other.parallelOrders;
+        turn = other.turn;
+        endReason = other.endReason;
+        leader = copyOf(other, other.leader);
+        positions = other.positions;
+        ownerChanges = other.ownerChanges;
+        turnsWithoutConquest = other.turnsWithoutConquest;
+        turnsLeft = other.turnsLeft;
+        midTurn = other.midTurn;
+        issuing = other.issuing;
+        asking = other.asking;
     }
     return *this;
 }
@@ -367,7 +706,9 @@ static std::vector<std::string> splitString(std::string input, char delimiter) {
 
 Tournament::Tournament(std::string argument)
     : Subject()
-    , ILoggable() {
+    , ILoggable()
+    , argument(argument)
+    , seed(Game::defaultSeed.value_or(std::random_device {}())) {
     // get all parts from the argument in vector of strings
     std::vector<std::string> strings = splitString(argument, ' ');
     if (strings.size() != 8) {
@@ -378,14 +719,24 @@ Tournament::Tournament(std::string argument)
         switch (i) {
             // process maps
         case 1: {
-            std::vector<std::string> mapString = splitString(strings[i], ',');
+            // A directory stands for the valid maps its index lists
+            std::vector<std::string> mapString;
+            for (const std::string& name : splitString(strings[i], ',')) {
+                if (std::filesystem::is_directory(name)) {
+                    std::vector<std::string> valid = MapIndex::build(name).validPaths();
+                    mapString.insert(mapString.end(), valid.begin(), valid.end());
+                } else {
+                    mapString.push_back(name);
+                }
+            }
             std::cout << strings[i] << std::endl;
             if (mapString.size() > 5 || mapString.size() < 1) {
                 throw std::invalid_argument("Invalid number of maps");
             }
+            MapCache::instance().preload(mapString);
             for (size_t j = 0; j < mapString.size(); j++) {
-                std::ifstream file = std::ifstream(mapString[j]);
-                maps.push_back(MapLoader(file).parse());
+                maps.push_back(MapCache::instance().get(mapString[j]));
+                mapNames.push_back(Ratings::mapName(mapString[j]));
                 if (!maps[j]->validate())
                     throw std::invalid_argument("Invalid map loaded");
             }
@@ -398,22 +749,12 @@ Tournament::Tournament(std::string argument)
             }
             for (size_t j = 0; j < playerStrings.size(); j++) {
                 std::string playerString = playerStrings[j];
-                PlayerStrategy* strategy;
-                if (playerString == "human") {
-                    strategy = new HumanPlayer();
-                } else if (playerString == "aggressive") {
-                    strategy = new AggressivePlayer();
-                } else if (playerString == "benevolent") {
-                    strategy = new BenevolentPlayer();
-                } else if (playerString == "neutral") {
-                    strategy = new NeutralPlayer();
-                } else if (playerString == "cheater") {
-                    strategy = new CheaterPlayer();
-                } else {
+                std::optional<Strategy> strategy = strategyFromName(playerString);
+                if (!strategy) {
                     throw std::runtime_error((std::stringstream {} << "Invalid strategy " << playerString).str());
                 }
 
-                players.push_back(new Player(playerString, strategy));
+                players.push_back(new Player(playerString, *strategy));
             }
         } break;
         // process number of games
@@ -441,11 +782,11 @@ Tournament::Tournament(const Tournament& other)
     this->players = other.players;
     this->nbGames = other.nbGames;
     this->nbTurns = other.nbTurns;
+    this->argument = other.argument;
+    this->seed = other.seed;
+    this->mapNames = other.mapNames;
 }
 Tournament::~Tournament() {
-    for (auto m : maps) {
-        delete m;
-    }
     maps.clear();
     for (auto p : players) {
         delete p;
@@ -453,49 +794,103 @@ Tournament::~Tournament() {
     players.clear();
 }
 
+std::string Tournament::playGame(size_t map, size_t game) {
+    // create a copy of map so game doesn'T delete the main map
+    Game* g = new Game(new Map(*maps[map]));
+    g->setSeed(seed + static_cast<std::uint32_t>(map * nbGames + game));
+    g->transition(Game::GameState::MapLoaded);
+    g->transition(Game::GameState::MapValidated);
+    for (auto p : players) {
+        g->addplayer(new Player(*p));
+        g->transition(Game::GameState::PlayersAdded);
+    }
+    g->gamestart();
+    g->transition(Game::GameState::FirstReinforcements);
+    // get game winner
+    Player* winner = g->mainGameLoop(nbTurns);
+    std::string result = winner ? winner->getName() : "draw";
+    Game::EndReason reason = g->getEndReason();
+    if (reason != Game::EndReason::None && reason != Game::EndReason::Conquest) {
+        result += " (" + Game::endReasonString(reason) + ")";
+    }
+    delete g;
+    return result;
+}
+
+void Tournament::rate(Ratings& ratings, size_t index) const {
+    const std::string& result = winners[index];
+    if (result == ProcessRunner::CRASHED || result.rfind(ProcessRunner::FAILED, 0) == 0) {
+        return;
+    }
+    // Players are named after their strategy, the reason of an early end follows the winner
+    std::string winner = result.substr(0, result.find(" ("));
+    std::vector<std::string> strategies;
+    std::optional<size_t> seat;
+    for (size_t i = 0; i < players.size(); i++) {
+        strategies.push_back(players[i]->getName());
+        if (!seat && players[i]->getName() == winner) {
+            seat = i;
+        }
+    }
+    ratings.record(mapNames[index / nbGames], strategies, seat);
+}
+
 void Tournament::executeTournament() {
-    for (size_t i = 0; i < maps.size(); i++) {
-        for (size_t j = 0; j < nbGames; j++) {
-            // create a copy of map so game doesn'T delete the main map
-            Game* game = new Game(new Map(*maps[i]));
-            game->transition(Game::GameState::MapLoaded);
-            game->transition(Game::GameState::MapValidated);
-            for (auto p : players) {
-                game->addplayer(new Player(*p));
-                game->transition(Game::GameState::PlayersAdded);
+    winners.clear();
+    Ratings ratings;
+    if (!defaultRatings.empty()) {
+        // The games of this tournament are recorded on top of the file, so parallel tournaments continuing it merge
+        ratings.load(defaultRatings);
+        ratings.rebase();
+    }
+    if (defaultProcesses > 0) {
+        ProcessRunner runner(defaultProcesses, defaultJournal);
+        std::stringstream signature;
+        signature << "tournament " << argument << " seed " << seed;
+        winners = runner.run(signature.str(), maps.size() * nbGames, [this](size_t index) {
+            // A forked worker has no threads besides its own, so it issues orders serially
+            Game::defaultParallelOrders = false;
+            return playGame(index / nbGames, index % nbGames);
+        });
+        std::cout << runner << std::endl;
+        // Rated in game order rather than as the workers finish, so the ratings are the same as in one process
+        for (size_t i = 0; i < winners.size(); i++) {
+            rate(ratings, i);
+        }
+    } else {
+        for (size_t i = 0; i < maps.size(); i++) {
+            for (size_t j = 0; j < nbGames; j++) {
+                winners.push_back(playGame(i, j));
+                rate(ratings, winners.size() - 1);
             }
-            game->gamestart();
-            game->transition(Game::GameState::FirstReinforcements);
-            // get game winner
-            Player* winner = game->mainGameLoop(nbTurns);
-            if (winner == nullptr) {
-                winners.push_back("draw");
-            } else
-                winners.push_back(winner->getName());
-            delete game;
         }
     }
-    notify(this);
+    if (!defaultRatings.empty()) {
+        ratings.save(defaultRatings);
+        std::cout << ratings << std::endl;
+    }
+    notify(Event::Kind::TournamentOver, this);
+}
+
+const std::vector<std::string>& Tournament::getWinners() const {
+    return this->winners;
 }
 
 Tournament& Tournament::operator=(const Tournament& other) {
     if (this != &other) {
-        for (auto m : maps) {
-            delete m;
-        }
-        maps.clear();
         for (auto p : players) {
             delete p;
         }
         players.clear();
-        for (auto m : other.maps) {
-            this->maps.push_back(new Map(*m));
-        }
+        this->maps = other.maps;
         for (auto p : other.players) {
             this->players.push_back(new Player(*p));
         }
         nbGames = other.nbGames;
         nbTurns = other.nbTurns;
+        argument = other.argument;
+        seed = other.seed;
+        mapNames = other.mapNames;
     }
     return *this;
 }
@@ -516,7 +911,7 @@ std::string Tournament::stringToLog() const {
     for (size_t i = 1; i <= maps.size(); i++) {
         result << "Map " << i << "\t";
         for (size_t j = 0; j < nbGames; j++) {
-            result << winners[i * j] << "\t";
+            result << winners[(i - 1) * nbGames + j] << "\t";
         }
         result << "\n";
     }
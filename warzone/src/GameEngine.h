@@ -6,12 +6,18 @@
 #include "Orders.h"
 #include "Player.fwd.h"
 #include "Player.h"
+#include "Ratings.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
 #include <random>
 #include <string>
+#include <vector>
 
 class Game : public Subject, public ILoggable {
 public:
@@ -28,22 +34,124 @@ public:
         Tournament,
     };
 
+    /**
+     * @brief Why a game stopped before its turn limit.
+     */
+    enum class EndReason : char {
+        /** @brief Still playing, or stopped by the turn limit. */
+        None,
+        /** @brief One player holds every territory or is the last one standing. */
+        Conquest,
+        /** @brief No territory changed owner for STALEMATE_TURNS turns. */
+        Stalemate,
+        /** @brief The same position came back REPETITIONS times. */
+        Repetition,
+        /** @brief Every player left is passive, nothing can be conquered anymore. */
+        Passive,
+        /** @brief One player has DECIDED_RATIO times the armies of everyone else together, and no territory of theirs is outnumbered by its neighbors. */
+        Decided,
+    };
+    /** @brief Turns without a conquest before a game is a stalemate. */
+    static constexpr size_t STALEMATE_TURNS = 30;
+    /** @brief Occurrences of a position before a game is a stalemate. */
+    static constexpr int REPETITIONS = 3;
+    /** @brief Army ratio between the leader and all other players after which a game is decided. */
+    static constexpr int DECIDED_RATIO = 10;
+
 private:
     Map* map;
     GameState state;
     std::vector<Player*> players;
     Deck* deck;
     CommandProcessor* cp;
+    /** @brief Every random draw of the game derives from this seed. */
+    std::uint32_t seed;
+    /** @brief Whether the players that only read the board issue their orders concurrently. */
+    bool parallelOrders;
+    /** @brief Number of turns played by mainGameLoop. */
+    size_t turn;
+    EndReason endReason;
+    /** @brief Winner of a decided game, who has not conquered everything yet. */
+    Player* leader;
+    /**
+     * @brief Times each position was seen at the end of a turn: owners, exact armies and pools.
+     *
+     * Not keyed by hash, whose army buckets would take positions that still change for a repetition.
+     */
+    std::map<std::vector<std::int32_t>, int> positions;
+    /** @brief Value of Map::getOwnerChanges at the last conquest. */
+    std::uint64_t ownerChanges;
+    size_t turnsWithoutConquest;
+    /** @brief Turns applyCommand still has to play. */
+    size_t turnsLeft;
+    /** @brief Whether a turn played by applyCommand waits in its issue orders phase. */
+    bool midTurn;
+    /** @brief Next player to issue orders in that turn. */
+    size_t issuing;
+    /** @brief Whether that player started issuing and waits for answers. */
+    bool asking;
+    /** @brief Result of every game of the tournament the commands ran, if they ran one. */
+    std::vector<std::string> tournamentWinners;
     int calculateReinforcements(Player* player);
+    /**
+     * @brief Run a validated command and return its effect.
+     */
+    std::string runCommand(const Command& command);
+    /**
+     * @brief Look for stalemates and decided games at the end of a turn, only when every player is a computer
+     */
+    void detectEarlyEnd();
+    /**
+     * @brief Everything in a turn before the orders are issued.
+     */
+    void beginTurn();
+    /**
+     * @brief Everything in a turn after the orders are issued.
+     */
+    void endTurn();
+    /**
+     * @brief Winner of the game when the loop stopped, nothing for a draw or a game still going.
+     */
+    Player* outcome();
+    /**
+     * @brief The copy of a player of the other game, the player at the same position among this game's players.
+     */
+    Player* copyOf(const Game& other, const Player* player) const;
+    /**
+     * @brief Play the turns left until they are played or a human waits for an answer.
+     *
+     * @return The question of that human, or the outcome of the turns played.
+     */
+    std::string resumeTurns();
 
 public:
+    /** @brief Seed for new games, random if not set. */
+    inline static std::optional<std::uint32_t> defaultSeed;
+    /** @brief Whether new games issue orders concurrently. */
+    inline static bool defaultParallelOrders = false;
+
     Game();
     Game(CommandProcessor* cp);
     Game(Map* map);
     ~Game();
     Game(const Game& other);
 
+    /**
+     * @brief Read commands until the game starts or a tournament is over.
+     *
+     * @throws std::runtime_error if the commands run out before that.
+     */
     void startupPhase();
+    /**
+     * @brief Apply one command line to the game, as if it was typed in the console, without reading anything.
+     *
+     * Besides the startup commands, `play <turns>` plays turns of the game. When a human has to
+     * issue orders, its question is returned instead and the next lines answer it, the turns then
+     * go on where they stopped. Tournaments are refused since they end the process.
+     *
+     * @return The effect of the command, or why it was refused.
+     */
+    std::string applyCommand(const std::string& line);
     void mainGameLoop();
     Player* mainGameLoop(size_t turns);
 
@@ -54,6 +162,10 @@ public:
     void observe(Observer* observer);
     void observerPlayers(Observer* observer);
     void loadmap(std::ifstream file);
+    /**
+     * @brief Load a text or compiled map file
+     */
+    void loadmap(const std::string& path);
     bool validatemap();
     void addplayer(Player* p);
     void gamestart();
@@ -62,30 +174,92 @@ public:
     void executeOrdersPhase();
     bool gameEnded();
     void removeDefeatedPlayers();
+    /**
+     * @brief Play a tournament, then move to the Tournament state, which no command leaves.
+     */
     void tournament(std::string argument);
+    const std::vector<std::string>& getTournamentWinners() const;
     Game& operator=(const Game& other);
 
+    /**
+     * @brief Set the seed of the game, before gamestart.
+     */
+    void setSeed(std::uint32_t seed);
+    std::uint32_t getSeed() const;
+    /**
+     * @brief Issue the orders of the players that only read the board on a thread pool.
+     *
+     * The orders are the same as in a serial run with the same seed,
+     * humans or cheaters in the game make every player issue serially.
+     */
+    void setParallelOrders(bool parallel);
+
+    /**
+     * @brief Zobrist hash of the position: owners and armies of the territories, pools and hands, turn parity.
+     *
+     * Equal positions have equal hashes, whatever moves led to them, so it can key transposition
+     * tables. Large stacks are bucketed, so repetitions are detected on exact positions instead.
+     * O(players), the board part is kept up to date by the map.
+     */
+    std::uint64_t hash() const;
+    size_t getTurn() const;
+    GameState getState() const;
+    /** @brief Whether a player waits on input to issue its orders. */
+    bool hasHumans() const;
+    EndReason getEndReason() const;
+    static std::string endReasonString(EndReason reason);
+
     std::string stateString() const;
 
     std::string stringToLog() const override;
 
     friend std::ostream& operator<<(std::ostream& out, const Game& game);
     friend void testMainGameLoop();
+    friend void testEarlyEnd();
+    friend std::vector<std::pair<std::string, int>> playSeededGame(bool parallel);
+    friend std::vector<std::uint64_t> playHashedGame(bool& consistent);
 };
 
 class Tournament : public Subject, public ILoggable {
 private:
-    std::vector<Map*> maps;
+    /** @brief Maps shared with the map cache, each game plays on its own copy. */
+    std::vector<std::shared_ptr<const Map>> maps;
     std::vector<Player*> players;
     size_t nbGames;
     size_t nbTurns;
     std::vector<std::string> winners;
+    /** @brief The tournament command, which identifies the tournament in a journal. */
+    std::string argument;
+    /** @brief Game j on map i is seeded with seed + i * nbGames + j. */
+    std::uint32_t seed;
+    /** @brief Name of each map in the ratings. */
+    std::vector<std::string> mapNames;
+
+    /**
+     * @brief Play one game on its own copy of the map and return the winner, or why it is a draw.
+     */
+    std::string playGame(size_t map, size_t game);
+    /**
+     * @brief Update the ratings with the result of a game, games whose worker crashed are not rated.
+     */
+    void rate(Ratings& ratings, size_t index) const;
 
 public:
+    /** @brief Play the games in that many worker processes, in this process if 0. */
+    inline static size_t defaultProcesses = 0;
+    /** @brief Journal of the games played by worker processes, to resume an interrupted tournament. */
+    inline static std::string defaultJournal;
+    /** @brief Rating file updated with the games of every tournament, none if empty. */
+    inline static std::string defaultRatings;
+
     Tournament(std::string argument);
     Tournament(const Tournament& other);
     ~Tournament();
     void executeTournament();
+    /**
+     * @brief Result of every game, map by map.
+     */
+    const std::vector<std::string>& getWinners() const;
 
     Tournament& operator=(const Tournament& other);
 
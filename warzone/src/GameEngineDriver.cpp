@@ -1,7 +1,33 @@
 #include "GameEngineDriver.h"
+#include "Batch.h"
 #include "GameEngine.h"
+#include "MapCache.h"
+#include "ProcessRunner.h"
+#include "Profiler.h"
+#include "QuietConsole.h"
+#include "Ratings.h"
+#include "Server.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <unordered_set>
 #include <stdexcept>
+#include <thread>
+
+#if defined(__linux__)
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 void testGameStates() {
     Game* game = new Game();
@@ -82,3 +108,556 @@ void testTournament() {
     tournament->executeTournament();
     delete tournament;
 }
+
+void testProfiler() {
+    Profiler& profiler = Profiler::instance();
+    profiler.enable("profile", true);
+
+    Tournament* tournament = new Tournament("-M res/map/lp.map,res/map/Cobra.map -P neutral,aggressive -G 2 -D 30");
+    tournament->executeTournament();
+    delete tournament;
+
+    profiler.disable();
+    std::cout << profiler << std::endl
+              << "Phases timed: " << (profiler.timers().count("issueOrdersPhase") == 1) << std::endl
+              << "Nothing counted once disabled: ";
+    std::uint64_t allocations = profiler.get(Profiler::Counter::Allocations);
+    std::vector<int>* unused = new std::vector<int>(10);
+    delete unused;
+    std::cout << (profiler.get(Profiler::Counter::Allocations) == allocations) << std::endl;
+    profiler.writeCsv(std::cout);
+    profiler.reset();
+}
+
+// Owner and armies of every territory once the game is over
+std::vector<std::pair<std::string, int>> playSeededGame(bool parallel) {
+    Game* game = new Game(MapCache::instance().load("res/map/King of the Hills.map"));
+    game->setSeed(42);
+    game->setParallelOrders(parallel);
+    game->transition(Game::GameState::MapValidated);
+    game->addplayer(new Player("Ann", AggressivePlayer()));
+    game->addplayer(new Player("Bob", AggressivePlayer()));
+    game->addplayer(new Player("Cid", BenevolentPlayer()));
+    game->addplayer(new Player("Dee", NeutralPlayer()));
+    game->transition(Game::GameState::PlayersAdded);
+    game->gamestart();
+    game->transition(Game::GameState::FirstReinforcements);
+    game->mainGameLoop(20);
+
+    std::vector<std::pair<std::string, int>> board;
+    for (size_t i = 0; i < game->map->getNumberTerritories(); i++) {
+        Territory* t = game->map->findTerritoryByIndex(i);
+        board.emplace_back(t->getOwner() ? t->getOwner()->getName() : "", t->getArmies());
+    }
+    delete game;
+    return board;
+}
+
+void testParallelOrders() {
+    auto serial = playSeededGame(false);
+    auto again = playSeededGame(false);
+    auto parallel = playSeededGame(true);
+    std::cout << "Same seed replays the same game: " << (serial == again) << std::endl
+              << "Parallel orders give the same game: " << (serial == parallel) << std::endl;
+}
+
+// Hash after every turn of a seeded game, checking the map's hash against one computed from scratch
+std::vector<std::uint64_t> playHashedGame(bool& consistent) {
+    Game* game = new Game(MapCache::instance().load("res/map/King of the Hills.map"));
+    game->setSeed(42);
+    game->transition(Game::GameState::MapValidated);
+    game->addplayer(new Player("Ann", AggressivePlayer()));
+    game->addplayer(new Player("Bob", BenevolentPlayer()));
+    game->addplayer(new Player("Cid", AggressivePlayer()));
+    game->transition(Game::GameState::PlayersAdded);
+    game->gamestart();
+    game->transition(Game::GameState::FirstReinforcements);
+
+    std::vector<std::uint64_t> hashes { game->hash() };
+    while (!game->gameEnded() && game->getEndReason() == Game::EndReason::None && game->getTurn() < 20) {
+        game->mainGameLoop(1);
+        consistent = consistent && game->map->getHash() == game->map->computeHash();
+        hashes.push_back(game->hash());
+    }
+    delete game;
+    return hashes;
+}
+
+void testZobrist() {
+    bool consistent = true;
+    std::vector<std::uint64_t> first = playHashedGame(consistent);
+    std::vector<std::uint64_t> second = playHashedGame(consistent);
+    std::unordered_set<std::uint64_t> distinct(first.begin(), first.end());
+    std::cout << "Incremental hash matches a full recomputation: " << consistent << std::endl
+              << "Same seed gives the same hashes: " << (first == second) << std::endl
+              << "Distinct positions over " << first.size() << " turns: " << distinct.size() << std::endl;
+
+    Hand hand;
+    std::uint64_t empty = hand.hash();
+    hand.addCard(Card(CardType::BOMB));
+    hand.addCard(Card(CardType::AIRLIFT));
+    std::uint64_t two = hand.hash();
+    hand.draw();
+    hand.draw();
+    hand.addCard(Card(CardType::AIRLIFT));
+    hand.addCard(Card(CardType::BOMB));
+    std::cout << "Hands hash their cards whatever the order: " << (hand.hash() == two && two != empty) << std::endl;
+}
+
+// Play a seeded game between the given strategies until it ends, the output of the game is silenced
+static Game::EndReason playUntilEnd(const std::string& description, const std::vector<Strategy>& strategies, size_t turns) {
+    Game* game = new Game(MapCache::instance().load("res/map/lp.map"));
+    game->setSeed(7);
+    game->transition(Game::GameState::MapValidated);
+    for (size_t i = 0; i < strategies.size(); i++) {
+        game->addplayer(new Player("P" + std::to_string(i + 1), strategies[i]));
+    }
+    game->transition(Game::GameState::PlayersAdded);
+
+    Player* winner = nullptr;
+    {
+        QuietConsole quiet;
+        game->gamestart();
+        game->transition(Game::GameState::FirstReinforcements);
+        winner = game->mainGameLoop(turns);
+    }
+
+    Game::EndReason reason = game->getEndReason();
+    std::cout << description << ": " << (winner ? winner->getName() : "draw")
+              << " after " << game->getTurn() << " of " << turns << " turns, by " << Game::endReasonString(reason) << std::endl;
+    delete game;
+    return reason;
+}
+
+void testEarlyEnd() {
+    Game::EndReason passive = playUntilEnd("Benevolent against benevolent", { BenevolentPlayer(), BenevolentPlayer() }, 500);
+    Game::EndReason stalled = playUntilEnd("Aggressive against neutral", { AggressivePlayer(), NeutralPlayer() }, 500);
+    Game::EndReason contested = playUntilEnd("Aggressive against benevolent", { AggressivePlayer(), BenevolentPlayer(), BenevolentPlayer() }, 500);
+    std::cout << "Passive players stop after one turn: " << (passive == Game::EndReason::Passive) << std::endl
+              << "Other games stop before the turn limit: " << (stalled != Game::EndReason::None && contested != Game::EndReason::None) << std::endl;
+
+    // A stack that keeps growing is no repetition, though its armies stay in the same bucket of the hash
+    Game* game = new Game(MapCache::instance().load("res/map/lp.map"));
+    {
+        QuietConsole quiet;
+        game->transition(Game::GameState::MapValidated);
+        game->addplayer(new Player("Ann", AggressivePlayer()));
+        game->addplayer(new Player("Bob", NeutralPlayer()));
+        game->transition(Game::GameState::PlayersAdded);
+        game->gamestart();
+    }
+    Territory* stack = game->map->findTerritoryByIndex(0);
+    std::uint64_t bucketed = 0;
+    bool sameHash = true;
+    for (int armies = 20; armies < 20 + 2 * Game::REPETITIONS; armies++) {
+        stack->setArmies(armies);
+        sameHash = sameHash && (armies == 20 || game->hash() == bucketed);
+        bucketed = game->hash();
+        game->detectEarlyEnd();
+    }
+    bool growing = game->getEndReason() == Game::EndReason::None;
+    for (int i = 0; i < Game::REPETITIONS; i++) {
+        game->detectEarlyEnd();
+    }
+    std::cout << "Growing stacks of the same hash are not repeated: " << (sameHash && growing) << std::endl
+              << "The same exact position is: " << (game->getEndReason() == Game::EndReason::Repetition) << std::endl;
+    delete game;
+
+    // An overwhelming leader has not decided the game while an enemy stack outnumbers one of its territories
+    game = new Game(MapCache::instance().load("res/map/lp.map"));
+    {
+        QuietConsole quiet;
+        game->transition(Game::GameState::MapValidated);
+        game->addplayer(new Player("Ann", AggressivePlayer()));
+        game->addplayer(new Player("Bob", NeutralPlayer()));
+        game->transition(Game::GameState::PlayersAdded);
+        game->gamestart();
+    }
+    // The game start shuffles the players
+    Player* ann = game->players[0]->getName() == "Ann" ? game->players[0] : game->players[1];
+    Player* bob = ann == game->players[0] ? game->players[1] : game->players[0];
+    Territory* enemy = game->map->findTerritoryByIndex(0)->getAdjacent()[0];
+    for (size_t i = 0; i < game->map->getNumberTerritories(); i++) {
+        Territory* t = game->map->findTerritoryByIndex(i);
+        Player* owner = t == enemy ? bob : ann;
+        if (t->getOwner() != owner) {
+            if (t->getOwner()) {
+                t->getOwner()->removeTerritory(t);
+            }
+            owner->addTerritory(t);
+        }
+        t->setArmies(t == enemy ? 5 : 1);
+    }
+    ann->addReinforcementToPool(1000);
+    game->detectEarlyEnd();
+    bool threatened = game->getEndReason() == Game::EndReason::None;
+    enemy->setArmies(1);
+    game->detectEarlyEnd();
+    std::cout << "A threatened leader plays on: " << threatened << std::endl
+              << "An unthreatened one has decided the game: " << (game->getEndReason() == Game::EndReason::Decided && game->leader == ann) << std::endl;
+    delete game;
+}
+
+void testProcessRunner() {
+    // Job 5 crashes the first time, job 7 every time, job 9 throws, job 3 answers on two lines
+    const std::string marker = "runner-crash.tmp";
+    const std::string journal = "runner-journal.tmp";
+    std::remove(marker.c_str());
+    std::remove(journal.c_str());
+    auto job = [&marker](size_t i) {
+        if (i == 7 || (i == 5 && !std::ifstream(marker))) {
+            std::ofstream(marker) << "crashed";
+            std::abort();
+        }
+        if (i == 9) {
+            throw std::runtime_error("no square");
+        }
+        if (i == 3) {
+            return std::string("3\t3\n9");
+        }
+        return std::to_string(i * i);
+    };
+
+    // A child of the process that is not a worker keeps its exit status for whoever started it
+#if defined(__linux__)
+    std::cout.flush();
+    pid_t other = fork();
+    if (other == 0) {
+        _exit(7);
+    }
+#endif
+    ProcessRunner runner(3, journal);
+    std::vector<std::string> results = runner.run("squares", 12, job);
+    bool untouched = true;
+#if defined(__linux__)
+    int status = 0;
+    untouched = waitpid(other, &status, 0) == other && WIFEXITED(status) && WEXITSTATUS(status) == 7;
+#endif
+    std::cout << runner << std::endl;
+    bool expected = results.size() == 12;
+    for (size_t i = 0; i < results.size(); i++) {
+        std::string square = i == 9 ? ProcessRunner::FAILED + std::string("no square") : i == 3 ? "3\t3\n9" : std::to_string(i * i);
+        expected = expected && results[i] == (i == 7 ? ProcessRunner::CRASHED : square);
+    }
+    std::cout << "Every job has its result, the crashing one is given up and the throwing one failed: " << expected << std::endl
+              << "Crashed workers were replaced: " << (runner.getRespawns() >= ProcessRunner::MAX_ATTEMPTS) << std::endl
+              << "Other children are not waited on: " << untouched << std::endl;
+
+    // Everything is in the journal, so nothing runs again
+    std::vector<std::string> resumed = runner.run("squares", 12, [](size_t) -> std::string { std::abort(); });
+    std::cout << "A finished run resumes from its journal: " << (resumed == results && runner.getResumed() == 12) << std::endl;
+    std::remove(marker.c_str());
+    std::remove(journal.c_str());
+
+    // Worker processes play the same games as this process
+    auto quiet = std::make_unique<QuietConsole>();
+    Game::defaultSeed = 11;
+    Tournament serial("-M res/map/lp.map,res/map/Cobra.map -P aggressive,benevolent,neutral -G 3 -D 30");
+    serial.executeTournament();
+    Tournament::defaultProcesses = 2;
+    Tournament forked("-M res/map/lp.map,res/map/Cobra.map -P aggressive,benevolent,neutral -G 3 -D 30");
+    forked.executeTournament();
+    Tournament::defaultProcesses = 0;
+    Game::defaultSeed.reset();
+    quiet.reset();
+    std::cout << "Forked tournament has the same results: " << (serial.getWinners() == forked.getWinners()) << std::endl;
+    for (const auto& winner : forked.getWinners()) {
+        std::cout << winner << "\t";
+    }
+    std::cout << std::endl;
+}
+
+void testRatings() {
+    Ratings ratings;
+    ratings.record("lp.map", { "aggressive", "benevolent" }, 0);
+    std::cout << "Beating an equal player moves both ratings by K / 2: "
+              << (ratings.get("aggressive", "lp.map").rating() == Ratings::INITIAL_RATING + Ratings::K / 2
+                     && ratings.get("benevolent", "lp.map").rating() == Ratings::INITIAL_RATING - Ratings::K / 2)
+              << std::endl;
+    Ratings twice;
+    twice.record("lp.map", { "aggressive", "aggressive", "benevolent" }, 1);
+    Ratings::Entry doubled = twice.get("aggressive", "lp.map");
+    std::cout << "A strategy seated twice plays once and wins: "
+              << (doubled.wins == 1 && doubled.games() == 1 && doubled.rating() == Ratings::INITIAL_RATING + Ratings::K / 2) << std::endl;
+
+    // A stream of games between strategies of different strengths, on a few maps
+    const std::vector<std::string> strategies = { "aggressive", "benevolent", "neutral", "cheater" };
+    const std::vector<std::string> maps = { "lp.map", "Cobra.map", "Colorado.map" };
+    const size_t games = 1000000;
+    std::mt19937 random(3);
+    auto play = [&](Ratings& into, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            size_t a = random() % strategies.size();
+            size_t b = (a + 1 + random() % (strategies.size() - 1)) % strategies.size();
+            std::optional<size_t> winner;
+            size_t roll = random() % 10;
+            if (roll < 6) {
+                winner = a > b ? 0 : 1;
+            } else if (roll < 8) {
+                winner = a > b ? 1 : 0;
+            }
+            into.record(maps[random() % maps.size()], { strategies[a], strategies[b] }, winner);
+        }
+    };
+    Ratings ladder;
+    auto start = std::chrono::steady_clock::now();
+    play(ladder, games);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    // Cheater beats neutral beats benevolent beats aggressive most of the time
+    auto ranked = [&](const Ratings& ratings) {
+        bool ordered = true;
+        for (const auto& map : maps) {
+            for (size_t i = 1; i < strategies.size(); i++) {
+                ordered = ordered && ratings.get(strategies[i], map).rating() > ratings.get(strategies[i - 1], map).rating();
+            }
+        }
+        return ordered;
+    };
+    std::cout << "Rated " << ladder.getGames() << " games at " << static_cast<long>(games / elapsed.count()) << " games per second" << std::endl
+              << "The ratings rank the strategies by strength on every map: " << ranked(ladder) << std::endl;
+
+    std::stringstream file;
+    ladder.write(file);
+    Ratings read;
+    read.read(file);
+    bool same = read.size() == ladder.size() && read.getGames() == ladder.getGames();
+    for (const auto& strategy : strategies) {
+        for (const auto& map : maps) {
+            same = same && read.get(strategy, map).delta == ladder.get(strategy, map).delta
+                && read.get(strategy, map).games() == ladder.get(strategy, map).games();
+        }
+    }
+    std::cout << "The file holds " << file.str().size() << " bytes and reads back the same ratings: " << same << std::endl;
+
+    // Two runs played in parallel merge into the same ladder as one run of both
+    random.seed(5);
+    Ratings first, second;
+    play(first, 20000);
+    play(second, 20000);
+    first.merge(second);
+    std::cout << "Merged runs count every game: " << (first.getGames() == 40000) << std::endl
+              << "and rank the strategies by strength on every map: " << ranked(first) << std::endl;
+
+    // Runs that continue the same file merge without counting its games twice
+    Ratings left = first;
+    left.rebase();
+    Ratings right = left;
+    play(left, 5000);
+    play(right, 5000);
+    std::stringstream leftFile, rightFile;
+    left.write(leftFile);
+    right.write(rightFile);
+    Ratings merged;
+    merged.read(leftFile);
+    merged.read(rightFile);
+    std::uint64_t entryGames = 0;
+    for (const auto& strategy : strategies) {
+        for (const auto& map : maps) {
+            entryGames += merged.get(strategy, map).games();
+        }
+    }
+    bool refused = false;
+    try {
+        Ratings other = second;
+        other.rebase();
+        merged.merge(other);
+    } catch (std::runtime_error&) {
+        refused = true;
+    }
+    std::cout << "Runs of the same base count its games once: " << (merged.getGames() == 50000 && entryGames == 2 * 50000) << std::endl
+              << "Runs of different bases are not merged: " << refused << std::endl;
+
+    // A tournament adds its games to the rating file of the previous one
+    const std::string path = "ratings.tmp";
+    std::remove(path.c_str());
+    {
+        QuietConsole quiet;
+        Game::defaultSeed = 13;
+        Tournament::defaultRatings = path;
+        for (int run = 0; run < 2; run++) {
+            Tournament tournament("-M res/map/lp.map,res/map/Cobra.map -P aggressive,benevolent,neutral -G 3 -D 30");
+            tournament.executeTournament();
+        }
+        Tournament::defaultRatings.clear();
+        Game::defaultSeed.reset();
+    }
+    Ratings saved;
+    saved.load(path);
+    std::cout << "Two tournaments of 6 games left 12 games in the file: " << (saved.getGames() == 12) << std::endl
+              << saved << std::endl;
+    std::remove(path.c_str());
+}
+
+#if defined(__linux__)
+// Stands in for the clients: connects every game first, sends each its whole script, waits, then reads the answers
+static std::vector<std::vector<std::string>> playScripts(const std::string& path, const std::vector<std::string>& scripts, std::chrono::milliseconds wait = std::chrono::milliseconds(0)) {
+    std::vector<int> sockets;
+    for (size_t i = 0; i < scripts.size(); i++) {
+        sockaddr_un address {};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            ::close(fd);
+            fd = -1;
+        }
+        sockets.push_back(fd);
+    }
+    for (size_t i = 0; i < scripts.size(); i++) {
+        if (sockets[i] >= 0) {
+            [[maybe_unused]] ssize_t written = ::write(sockets[i], scripts[i].data(), scripts[i].size());
+            ::shutdown(sockets[i], SHUT_WR);
+        }
+    }
+    std::this_thread::sleep_for(wait);
+    std::vector<std::vector<std::string>> answers(scripts.size());
+    for (size_t i = 0; i < scripts.size(); i++) {
+        std::string received;
+        char buffer[4096];
+        ssize_t count;
+        while (sockets[i] >= 0 && (count = ::read(sockets[i], buffer, sizeof(buffer))) > 0) {
+            received.append(buffer, static_cast<size_t>(count));
+        }
+        std::istringstream lines(received);
+        std::string line;
+        while (std::getline(lines, line)) {
+            answers[i].push_back(line);
+        }
+        if (sockets[i] >= 0) {
+            ::close(sockets[i]);
+        }
+    }
+    return answers;
+}
+#endif
+
+void testServer() {
+#if defined(__linux__)
+    const std::string path = "warzone-test.sock";
+    const size_t games = 200;
+    std::vector<std::string> scripts(games, "loadmap res/map/lp.map\nvalidatemap\naddplayer Ann aggressive\naddplayer Bob benevolent\ngamestart\nplay 20\nstats\n");
+    // One client skips the setup
+    scripts[0] = "gamestart\nstats\n";
+    // One human plays two turns: defends its first territory with nothing, after a negative count is refused, attacks nowhere and keeps its cards
+    const std::string turn = "0\n0\n\nno\n";
+    scripts[games - 1] = "loadmap res/map/lp.map\nvalidatemap\naddplayer alice\naddplayer Bob aggressive\ngamestart\nplay 2\nx\n0\n-5\n0\n\nno\n" + turn + "stats\n";
+
+    // The human's two turns are only the same on every run from the same seed
+    Game::defaultSeed = 5;
+    Server server(path);
+    std::vector<std::vector<std::string>> answers;
+    std::thread clients([&]() {
+        answers = playScripts(path, scripts);
+        server.stop();
+    });
+    auto start = std::chrono::steady_clock::now();
+    server.run();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    clients.join();
+    Game::defaultSeed.reset();
+
+    bool answered = true;
+    for (size_t i = 1; i < games - 1; i++) {
+        answered = answered && answers[i].size() == 7 && answers[i][4] == "Game started."
+            && answers[i][6].rfind("6 commands", 0) == 0;
+    }
+    std::cout << "Every game answered each of its commands: " << answered << std::endl
+              << "A command out of order is refused: " << answers[0][0] << std::endl
+              << "First game: " << std::endl;
+    for (const auto& answer : answers[1]) {
+        std::cout << "  " << answer << std::endl;
+    }
+    const std::vector<std::string>& human = answers[games - 1];
+    std::cout << "Game with a human, answering over the socket:" << std::endl;
+    for (const auto& answer : human) {
+        std::cout << "  " << answer.substr(0, 100) << (answer.size() > 100 ? "..." : "") << std::endl;
+    }
+    std::cout << "The human answered every question of two turns: "
+              << (human.size() == 17 && human[6].rfind("Invalid number: x", 0) == 0 && human[8].rfind("Negative number: -5", 0) == 0
+                     && human[15] == "Played to turn 2.") << std::endl;
+    std::cout << "Hosted " << server.getGamesHosted() << " games in " << static_cast<long>(elapsed.count() * 1000) << " ms, "
+              << server.getGames() << " still open" << std::endl
+              << server << std::endl;
+
+    // A client that closed its side reads its answers, far more than the socket buffer holds, once they are all played
+    const size_t lengthy = 20000;
+    std::string script;
+    for (size_t i = 0; i < lengthy; i++) {
+        script += "stats\n";
+    }
+    Server late(path);
+    std::thread reader([&]() {
+        answers = playScripts(path, { script }, std::chrono::milliseconds(500));
+        late.stop();
+    });
+    late.run();
+    reader.join();
+    std::cout << "Answers left after the client closed its side are all written: " << (answers[0].size() == lengthy) << std::endl;
+#else
+    std::cout << "The server needs epoll, which this platform does not have" << std::endl;
+#endif
+}
+
+void testBatch() {
+    namespace fs = std::filesystem;
+    const fs::path directory = "batch-test";
+    fs::remove_all(directory);
+    fs::create_directory(directory);
+    auto write = [&](const std::string& name, const std::string& script) {
+        std::ofstream(directory / name) << script;
+    };
+    const std::string game = "loadmap res/map/lp.map\nvalidatemap\naddplayer Ann aggressive\naddplayer Bob benevolent\ngamestart\n";
+    for (int i = 0; i < 6; i++) {
+        write("game" + std::to_string(i) + ".txt", game);
+    }
+    write("tournament.txt", "tournament -M res/map/lp.map,res/map/Cobra.map -P neutral,aggressive -G 2 -D 30\n");
+    write("human.txt", "loadmap res/map/lp.map\nvalidatemap\naddplayer alice\naddplayer Bob aggressive\ngamestart\n");
+    write("truncated.txt", "loadmap res/map/lp.map\nvalidatemap\n");
+    write("notes.md", "Not a script\n");
+
+    std::cout << "Pattern matching: " << Batch::matches("game*.txt", "game12.txt") << Batch::matches("g?me*.txt", "game.txt")
+              << !Batch::matches("*.txt", "notes.md") << !Batch::matches("game?.txt", "game12.txt") << std::endl;
+
+    Game::defaultSeed = 21;
+    Batch::Options options;
+    options.scripts = (directory / "*.txt").string();
+    options.summary = (directory / "summary.csv").string();
+    options.workers = 3;
+    options.turns = 200;
+    Batch batch(options);
+    std::vector<Batch::Result> first = batch.run();
+    options.workers = 1;
+    options.summary.clear();
+    std::vector<Batch::Result> serial = Batch(options).run();
+    Game::defaultSeed.reset();
+
+    bool same = first.size() == serial.size();
+    for (size_t i = 0; same && i < first.size(); i++) {
+        same = first[i].result == serial[i].result && first[i].turns == serial[i].turns;
+    }
+    std::ifstream summary(directory / "summary.csv");
+    size_t rows = 0;
+    for (std::string line; std::getline(summary, line);) {
+        rows++;
+    }
+    std::cout << "Found the 9 scripts and not the notes: " << (batch.getScripts().size() == 9) << std::endl
+              << "The scripts played the same results concurrently and one at a time: " << same << std::endl
+              << "The summary has a header and a row per script: " << (rows == 10) << std::endl
+              << "Failed scripts are the human game and the truncated one: " << (batch.getFailures() == 2) << std::endl;
+    for (const Batch::Result& result : first) {
+        std::cout << "  " << result.script << ": " << (result.ok ? "ok" : "failed") << ", " << result.result << ", "
+                  << result.turns << " turns, " << result.commands << " commands" << std::endl;
+    }
+    std::cout << batch << std::endl;
+    fs::remove_all(directory);
+
+    // Consoles silenced on other threads, and released out of order, give the console back once
+    std::streambuf* console = std::cout.rdbuf();
+    auto outer = std::make_unique<QuietConsole>();
+    std::unique_ptr<QuietConsole> inner;
+    std::thread([&inner] { inner = std::make_unique<QuietConsole>(); }).join();
+    outer.reset();
+    bool silent = std::cout.rdbuf() == nullptr;
+    inner.reset();
+    std::cout << "Nested quiet consoles speak again after the last: " << (silent && std::cout.rdbuf() == console) << std::endl;
+}
@@ -10,3 +10,11 @@ void testGameStates();
 void testStartupPhase();
 void testMainGameLoop();
 void testTournament();
+void testProfiler();
+void testParallelOrders();
+void testZobrist();
+void testEarlyEnd();
+void testProcessRunner();
+void testRatings();
+void testServer();
+void testBatch();
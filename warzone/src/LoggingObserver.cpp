@@ -1,6 +1,9 @@
 #include "LoggingObserver.h"
+#include "Profiler.h"
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <mutex>
 
 ILoggable::ILoggable() {
 }
@@ -12,6 +15,20 @@ ILoggable::ILoggable(const ILoggable& other) {
 ILoggable& ILoggable::operator=(const ILoggable& other) {
     return *this;
 }
+Event::Event(Kind kind, const ILoggable& source)
+    : kind(kind)
+    , source(source) {
+}
+Event::Kind Event::getKind() const {
+    return this->kind;
+}
+const ILoggable& Event::getSource() const {
+    return this->source;
+}
+std::string Event::toString() const {
+    return this->source.stringToLog();
+}
+
 Observer::Observer() { }
 Observer::~Observer() { }
 Observer::Observer(const Observer& other) {
@@ -20,35 +37,32 @@ Observer& Observer::operator=(const Observer& other) {
     return *this;
 }
 
-Subject::Subject() {
-    _observers = new std::list<Observer*>;
-}
-Subject::~Subject() {
-    delete _observers;
-}
-Subject::Subject(const Subject& other) {
-    *this = other;
+Subject::Subject() { }
+Subject::~Subject() { }
+// copies are observed by the same observers
+Subject::Subject(const Subject& other)
+    : observers(other.observers) {
 }
 Subject& Subject::operator=(const Subject& other) {
     if (this != &other) {
-
-        for (size_t i = 0; i < this->_observers->size(); i++) {
-            _observers[i] = other._observers[i];
-        }
+        this->observers = other.observers;
     }
     return *this;
 }
 
 void Subject::attach(Observer* o) {
-    _observers->push_back(o);
+    observers.push_back(o);
 }
 void Subject::detach(Observer* o) {
-    _observers->remove(o);
+    observers.erase(std::remove(observers.begin(), observers.end(), o), observers.end());
+}
+bool Subject::hasObservers() const {
+    return !observers.empty();
 }
-void Subject::notify(ILoggable* loggable) {
-    std::list<Observer*>::iterator i = _observers->begin();
-    for (; i != _observers->end(); ++i)
-        (*i)->update(loggable);
+void Subject::deliver(const Event& event) {
+    Profiler::count(Profiler::Counter::Notifications);
+    for (Observer* o : observers)
+        o->update(event);
 }
 
 LogObserver::LogObserver() {
@@ -64,10 +78,13 @@ LogObserver& LogObserver::operator=(const LogObserver& other) {
         *this = other;
     return *this;
 }
-void LogObserver::update(ILoggable* loggable) {
+void LogObserver::update(const Event& event) {
+    // Players issuing orders concurrently all log to the same file
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
     std::cout << "UPDATING" << std::endl;
     std::ofstream file;
     file.open(logFile, std::ios_base::app);
-    file << loggable->stringToLog() << std::endl;
+    file << event.toString() << std::endl;
     file.close();
 }
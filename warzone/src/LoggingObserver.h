@@ -1,7 +1,7 @@
 #pragma once
 #include <fstream>
-#include <list>
 #include <string>
+#include <vector>
 
 const std::string logFile = "gamelog.txt";
 
@@ -16,10 +16,49 @@ protected:
     ILoggable(const ILoggable& other);
 };
 
+/**
+ * @class Event
+ *
+ * @brief What a subject tells its observers: what happened and to what, without any text.
+ *
+ * Only the observers that write the event format it, with toString, so a notification nobody
+ * writes costs no formatting.
+ */
+class Event {
+public:
+    enum class Kind : char {
+        /** @brief An order was added to an OrdersList. */
+        OrderAdded,
+        /** @brief An order was executed. */
+        OrderExecuted,
+        /** @brief A CommandProcessor saved the command it read. */
+        CommandSaved,
+        /** @brief A Command saved its effect. */
+        EffectSaved,
+        /** @brief A Game changed state. */
+        StateChanged,
+        /** @brief A Tournament played all of its games. */
+        TournamentOver,
+    };
+
+    Event(Kind kind, const ILoggable& source);
+
+    Kind getKind() const;
+    const ILoggable& getSource() const;
+    /**
+     * @brief The text logged for the event, formatted by the source on each call.
+     */
+    std::string toString() const;
+
+private:
+    Kind kind;
+    const ILoggable& source;
+};
+
 class Observer {
 public:
-    ~Observer();
-    virtual void update(ILoggable*) = 0;
+    virtual ~Observer();
+    virtual void update(const Event& event) = 0;
     Observer& operator=(const Observer& other);
 
 protected:
@@ -31,14 +70,25 @@ class Subject {
 public:
     virtual void attach(Observer* o);
     virtual void detach(Observer* o);
-    virtual void notify(ILoggable* loggable);
+    /**
+     * @brief Tell the observers what happened to source, nothing is built when there are none.
+     */
+    void notify(Event::Kind kind, const ILoggable* source) {
+        if (!this->observers.empty()) {
+            deliver(Event(kind, *source));
+        }
+    }
+    bool hasObservers() const;
     Subject();
-    ~Subject();
+    virtual ~Subject();
     Subject(const Subject& other);
     Subject& operator=(const Subject& other);
 
 private:
-    std::list<Observer*>* _observers;
+    /** @brief Empty for most subjects, so they allocate nothing for it. */
+    std::vector<Observer*> observers;
+
+    void deliver(const Event& event);
 };
 
 class LogObserver : public Observer {
@@ -47,5 +97,5 @@ public:
     ~LogObserver();
     LogObserver(const LogObserver& other);
     LogObserver& operator=(const LogObserver& other);
-    void update(ILoggable* loggable);
+    void update(const Event& event);
 };
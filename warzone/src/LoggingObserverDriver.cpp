@@ -4,9 +4,11 @@
 #include "GameEngineDriver.h"
 #include "LoggingObserver.h"
 #include "Orders.h"
+#include "Profiler.h"
 
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <sstream>
 #include <string>
 
@@ -51,3 +53,50 @@ void testLoggingObserver() {
     file.close();
     testMainGameLoop();
 }
+
+// Counts the events it gets by kind, without ever formatting them
+class CountingObserver : public Observer {
+public:
+    std::map<Event::Kind, int> counts;
+    void update(const Event& event) override {
+        this->counts[event.getKind()]++;
+    }
+};
+
+void testEvents() {
+    Profiler& profiler = Profiler::instance();
+    profiler.enable("events", false);
+
+    // Without observers an order costs its own allocation only, and adding it notifies no one
+    OrdersList* list = new OrdersList();
+    std::uint64_t allocations = profiler.get(Profiler::Counter::Allocations);
+    Order* order = new DeployOrder(nullptr, nullptr, 1);
+    std::cout << "An order allocates nothing for its observers: " << (profiler.get(Profiler::Counter::Allocations) - allocations == 1) << std::endl;
+    list->add(order);
+    for (int i = 0; i < 1000; i++) {
+        list->add(new DeployOrder(nullptr, nullptr, i));
+    }
+    std::cout << "Nothing is delivered without observers: " << (profiler.get(Profiler::Counter::Notifications) == 0) << std::endl;
+
+    // Observers get typed events and format them only if they want the text
+    CountingObserver counter;
+    list->attach(&counter);
+    list->add(new DeployOrder(nullptr, nullptr, 1));
+    Game* game = new Game();
+    game->attach(&counter);
+    game->transition(Game::GameState::MapLoaded);
+    game->transition(Game::GameState::MapValidated);
+    std::cout << "Events are typed: " << (counter.counts[Event::Kind::OrderAdded] == 1 && counter.counts[Event::Kind::StateChanged] == 2) << std::endl
+              << "Each delivery is counted: " << (profiler.get(Profiler::Counter::Notifications) == 3) << std::endl;
+    Event event(Event::Kind::StateChanged, *game);
+    std::cout << "Formatted on demand: " << event.toString() << std::endl;
+
+    list->detach(&counter);
+    list->add(new DeployOrder(nullptr, nullptr, 1));
+    std::cout << "Detached observers hear nothing: " << (counter.counts[Event::Kind::OrderAdded] == 1 && !list->hasObservers()) << std::endl;
+
+    profiler.disable();
+    profiler.reset();
+    delete game;
+    delete list;
+}
@@ -1 +1,2 @@
 void testLoggingObserver();
+void testEvents();
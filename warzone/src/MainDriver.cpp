@@ -6,13 +6,24 @@
 #include "OrdersDriver.h"
 #include "PlayerDriver.h"
 
+#include "Batch.h"
+#include "BinaryMap.h"
 #include "CommandProcessing.h"
+#include "MapCache.h"
+#include "MapGenerator.h"
+#include "MapIndex.h"
 #include "PlayerStrategiesDriver.h"
+#include "Profiler.h"
+#include "Ratings.h"
+#include "Server.h"
+#include "Tuner.h"
 
 #include <cstdlib>
 #include <ctime>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <sstream>
 #include <string>
 
 /**
@@ -43,12 +54,66 @@ int main(int argc, char* argv[]) {
         std::cerr << "No arguments provided. Usage:" << std::endl
                   << "-console          -- Play with console input" << std::endl
                   << "-file <filename>  -- Play with file input" << std::endl
-                  << "-test             -- Run the test suite" << std::endl;
+                  << "-test             -- Run the test suite" << std::endl
+                  << "-generate <filename> [-n territories] [-c continents] [-d degree] [-t grid|planar|smallworld] [-s seed]" << std::endl
+                  << "                  -- Generate a synthetic map file" << std::endl
+                  << "-compile <map> <wzmap> -- Compile a text map to the binary .wzmap format" << std::endl
+                  << "-serve <socket>   -- Host games for clients connecting to a Unix domain socket" << std::endl
+                  << "-batch <dir|glob> [-o summary] [-j workers] [-D turns]" << std::endl
+                  << "                  -- Run many command scripts concurrently and summarize their results" << std::endl
+                  << "-index <dir> [-o index] [-j workers]" << std::endl
+                  << "                  -- Load every map of a directory concurrently and write their counts, validity and hashes" << std::endl
+                  << "-merge <output> <ratings>... -- Merge rating files from parallel runs into one" << std::endl
+                  << "-tune <map>[,<map>...] [-g games] [-D turns] [-n generations] [-l offspring] [-s seed]" << std::endl
+                  << "                  -- Search for better aggressive strategy parameters by self-play" << std::endl
+                  << "Options:" << std::endl
+                  << "-preload <list|dir> -- Parse and validate every map listed in a file (like res/map/files.txt), or in a directory, before playing" << std::endl
+                  << "-profile <name>   -- Time the game phases and write <name>.json, <name>.csv and <name>.trace.json at the end" << std::endl
+                  << "-seed <n>         -- Seed every game, the same seed replays the same games" << std::endl
+                  << "-parallel         -- Issue the orders of computer players concurrently" << std::endl
+                  << "-processes <n>    -- Play the games of a tournament in n worker processes" << std::endl
+                  << "-journal <file>   -- Record the finished games of the workers, to resume an interrupted tournament" << std::endl
+                  << "-ratings <file>   -- Rate the strategies on each map with the games of every tournament" << std::endl
+                  << "-history <n>      -- Remember only the last n commands, 64 by default" << std::endl;
         return 1;
     }
 
     std::string mode = argv[1];
 
+    for (int i = 2; i < argc; i++) {
+        std::string option = argv[i];
+        if (option == "-profile" && i + 1 < argc) {
+            Profiler::instance().enable(argv[i + 1], true);
+        } else if (option == "-seed" && i + 1 < argc) {
+            Game::defaultSeed = static_cast<std::uint32_t>(std::stoul(argv[i + 1]));
+        } else if (option == "-parallel") {
+            Game::defaultParallelOrders = true;
+        } else if (option == "-processes" && i + 1 < argc) {
+            Tournament::defaultProcesses = std::stoul(argv[i + 1]);
+        } else if (option == "-journal" && i + 1 < argc) {
+            Tournament::defaultJournal = argv[i + 1];
+        } else if (option == "-ratings" && i + 1 < argc) {
+            Tournament::defaultRatings = argv[i + 1];
+        } else if (option == "-history" && i + 1 < argc) {
+            CommandProcessor::defaultHistory = std::stoul(argv[i + 1]);
+        }
+    }
+    for (int i = 2; i + 1 < argc; i++) {
+        if (std::string(argv[i]) == "-preload") {
+            try {
+                if (std::filesystem::is_directory(argv[i + 1])) {
+                    std::cout << "Preloaded a directory. " << MapIndex::build(argv[i + 1]) << " " << MapCache::instance() << std::endl;
+                } else {
+                    std::size_t loaded = MapCache::instance().preloadList(argv[i + 1]);
+                    std::cout << "Preloaded " << loaded << " maps. " << MapCache::instance() << std::endl;
+                }
+            } catch (std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                return 1;
+            }
+        }
+    }
+
     if (mode == "-console" || mode == "-file") {
         // Play the game
 
@@ -64,23 +129,245 @@ int main(int argc, char* argv[]) {
                 return 1;
             }
 
-            std::ifstream* commands = new std::ifstream(argv[2]);
-
-            if (!commands) {
+            try {
+                cp = new FileCommandProcessorAdapter(std::string(argv[2]));
+            } catch (std::exception& e) {
                 std::cerr << "Given file does not exist. Run without arguments to see help." << std::endl;
                 return 1;
             }
-
-            cp = new FileCommandProcessorAdapter(commands);
         }
 
         Game* game = new Game(cp);
         LogObserver* observer = new LogObserver();
         game->attach(observer);
-        game->startupPhase();
-        game->observerPlayers(observer);
-        game->mainGameLoop();
+        try {
+            game->startupPhase();
+        } catch (std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            delete game;
+            return 1;
+        }
+        if (game->getState() != Game::GameState::Tournament) {
+            game->observerPlayers(observer);
+            game->mainGameLoop();
+        }
         delete game;
+        Profiler::instance().report();
+    } else if (mode == "-generate") {
+        if (argc < 3) {
+            std::cerr << "-generate requires a filename. Run without arguments to see help." << std::endl;
+            return 1;
+        }
+
+        MapGenerator::Options options;
+        try {
+            for (int i = 3; i + 1 < argc; i += 2) {
+                std::string flag = argv[i];
+                std::string value = argv[i + 1];
+                if (flag == "-n") {
+                    options.territories = std::stoull(value);
+                } else if (flag == "-c") {
+                    options.continents = std::stoull(value);
+                } else if (flag == "-d") {
+                    options.averageDegree = std::stod(value);
+                } else if (flag == "-t") {
+                    options.topology = MapGenerator::parseTopology(value);
+                } else if (flag == "-s") {
+                    options.seed = static_cast<std::uint32_t>(std::stoul(value));
+                } else {
+                    std::cerr << "Unknown option " << flag << ". Run without arguments to see help." << std::endl;
+                    return 1;
+                }
+            }
+
+            MapGenerator generator(options);
+            std::ofstream file(argv[2]);
+            if (!file.is_open()) {
+                std::cerr << "Cannot open " << argv[2] << " for writing." << std::endl;
+                return 1;
+            }
+            std::cout << generator << std::endl;
+            generator.write(file);
+        } catch (std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    } else if (mode == "-compile") {
+        if (argc < 4) {
+            std::cerr << "-compile requires an input and an output filename. Run without arguments to see help." << std::endl;
+            return 1;
+        }
+
+        try {
+            std::ifstream input(argv[2]);
+            if (!input.is_open()) {
+                std::cerr << "Given file does not exist. Run without arguments to see help." << std::endl;
+                return 1;
+            }
+            Map* map = MapLoader(input).parse();
+            std::ofstream output(argv[3], std::ios::binary);
+            if (!output.is_open()) {
+                std::cerr << "Cannot open " << argv[3] << " for writing." << std::endl;
+                delete map;
+                return 1;
+            }
+            bool valid = MapCompiler(*map).write(output);
+            std::cout << "Compiled " << *map << (valid ? " It is valid." : " It is NOT valid.") << std::endl;
+            delete map;
+        } catch (ParsingException& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        } catch (std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    } else if (mode == "-serve") {
+        if (argc < 3) {
+            std::cerr << "-serve requires a socket path. Run without arguments to see help." << std::endl;
+            return 1;
+        }
+
+        try {
+            Server server(argv[2]);
+            std::cout << server << std::endl;
+            server.run();
+        } catch (std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    } else if (mode == "-batch") {
+        if (argc < 3) {
+            std::cerr << "-batch requires a directory or pattern of scripts. Run without arguments to see help." << std::endl;
+            return 1;
+        }
+
+        Batch::Options options;
+        options.scripts = argv[2];
+        try {
+            for (int i = 3; i + 1 < argc; i += 2) {
+                std::string flag = argv[i];
+                std::string value = argv[i + 1];
+                if (flag == "-o") {
+                    options.summary = value;
+                } else if (flag == "-j") {
+                    options.workers = std::stoull(value);
+                } else if (flag == "-D") {
+                    options.turns = std::stoull(value);
+                } else if (flag != "-seed" && flag != "-profile" && flag != "-history" && flag != "-preload") {
+                    std::cerr << "Unknown option " << flag << ". Run without arguments to see help." << std::endl;
+                    return 1;
+                }
+            }
+
+            Batch batch(options);
+            batch.run();
+            std::cout << batch << std::endl;
+            Profiler::instance().report();
+            if (batch.getFailures() > 0) {
+                return 1;
+            }
+        } catch (std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    } else if (mode == "-index") {
+        if (argc < 3) {
+            std::cerr << "-index requires a directory of maps. Run without arguments to see help." << std::endl;
+            return 1;
+        }
+
+        std::string output = "maps.index";
+        std::size_t workers = ThreadPool::defaultSize();
+        try {
+            for (int i = 3; i + 1 < argc; i += 2) {
+                std::string flag = argv[i];
+                std::string value = argv[i + 1];
+                if (flag == "-o") {
+                    output = value;
+                } else if (flag == "-j") {
+                    workers = std::stoull(value);
+                } else if (flag != "-profile") {
+                    std::cerr << "Unknown option " << flag << ". Run without arguments to see help." << std::endl;
+                    return 1;
+                }
+            }
+
+            MapIndex index = MapIndex::build(argv[2], workers);
+            index.save(output);
+            for (const auto& entry : index.getEntries()) {
+                if (!entry.error.empty()) {
+                    std::cerr << "Could not load " << entry.path << ": " << entry.error << std::endl;
+                }
+            }
+            std::cout << index << " Written to " << output << ". " << MapCache::instance() << std::endl;
+            Profiler::instance().report();
+        } catch (std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    } else if (mode == "-merge") {
+        if (argc < 4) {
+            std::cerr << "-merge requires an output and at least one rating file. Run without arguments to see help." << std::endl;
+            return 1;
+        }
+
+        try {
+            Ratings ratings;
+            for (int i = 3; i < argc; i++) {
+                std::ifstream input(argv[i], std::ios::binary);
+                if (!input.is_open()) {
+                    std::cerr << "Given file " << argv[i] << " does not exist." << std::endl;
+                    return 1;
+                }
+                ratings.read(input);
+            }
+            ratings.save(argv[2]);
+            std::cout << ratings << std::endl;
+        } catch (std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    } else if (mode == "-tune") {
+        if (argc < 3) {
+            std::cerr << "-tune requires a list of maps. Run without arguments to see help." << std::endl;
+            return 1;
+        }
+
+        Tuner::Options options;
+        options.processes = Tournament::defaultProcesses;
+        try {
+            std::stringstream maps(argv[2]);
+            std::string map;
+            while (std::getline(maps, map, ',')) {
+                options.maps.push_back(map);
+            }
+            for (int i = 3; i + 1 < argc; i += 2) {
+                std::string flag = argv[i];
+                std::string value = argv[i + 1];
+                if (flag == "-g") {
+                    options.games = std::stoull(value);
+                } else if (flag == "-D") {
+                    options.turns = std::stoull(value);
+                } else if (flag == "-n") {
+                    options.generations = std::stoull(value);
+                } else if (flag == "-l") {
+                    options.offspring = std::stoull(value);
+                } else if (flag == "-s" || flag == "-seed") {
+                    options.seed = static_cast<std::uint32_t>(std::stoul(value));
+                } else if (flag != "-processes" && flag != "-profile") {
+                    std::cerr << "Unknown option " << flag << ". Run without arguments to see help." << std::endl;
+                    return 1;
+                }
+            }
+
+            Tuner tuner(options);
+            Tuner::Evaluation best = tuner.tune();
+            std::cout << "Best " << best << std::endl
+                      << tuner << std::endl;
+        } catch (std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
     } else if (mode == "-test") {
         // Test the functionality
         int choice;
@@ -92,12 +379,22 @@ int main(int argc, char* argv[]) {
             switch (choice) {
             case 1:
                 testLoadMaps();
+                testGeneratedMaps();
+                testCompiledMaps();
+                testMapCache();
+                testDistances();
+                testNames();
+                testBoard();
+                testMapIndex();
+                testMapArena();
                 break;
             case 2:
+                testFrontier();
                 testPlayer();
                 break;
             case 3:
                 testOrdersList();
+                testBattleOdds();
                 break;
             case 4:
                 testCards();
@@ -108,6 +405,14 @@ int main(int argc, char* argv[]) {
                 std::cout << "2. test startupPhase" << std::endl;
                 std::cout << "3. test main play loop" << std::endl;
                 std::cout << "4. test tournament" << std::endl;
+                std::cout << "5. test profiler" << std::endl;
+                std::cout << "6. test parallel orders" << std::endl;
+                std::cout << "7. test position hashing" << std::endl;
+                std::cout << "8. test early end of games" << std::endl;
+                std::cout << "9. test worker processes" << std::endl;
+                std::cout << "10. test ratings" << std::endl;
+                std::cout << "11. test game server" << std::endl;
+                std::cout << "12. test batch of scripts" << std::endl;
                 std::cin >> choice;
                 if (choice == 1)
                     testGameStates();
@@ -117,6 +422,22 @@ int main(int argc, char* argv[]) {
                     testMainGameLoop();
                 else if (choice == 4)
                     testTournament();
+                else if (choice == 5)
+                    testProfiler();
+                else if (choice == 6)
+                    testParallelOrders();
+                else if (choice == 7)
+                    testZobrist();
+                else if (choice == 8)
+                    testEarlyEnd();
+                else if (choice == 9)
+                    testProcessRunner();
+                else if (choice == 10)
+                    testRatings();
+                else if (choice == 11)
+                    testServer();
+                else if (choice == 12)
+                    testBatch();
                 else
                     std::cout << "Invalid choice" << std::endl;
                 break;
@@ -124,6 +445,7 @@ int main(int argc, char* argv[]) {
                 testCommandProcessing();
                 break;
             case 7:
+                testEvents();
                 testLoggingObserver();
                 break;
             case 8:
@@ -133,17 +455,25 @@ int main(int argc, char* argv[]) {
                 std::cout << "3. Benevolent" << std::endl;
                 std::cout << "4. Neutral" << std::endl;
                 std::cout << "5. Cheater" << std::endl;
+                std::cout << "6. Dispatch benchmark" << std::endl;
+                std::cout << "7. Parameter tuning" << std::endl;
                 std::cin >> choice;
                 if (choice == 1)
                     testHumanStrategy();
-                else if (choice == 2)
+                else if (choice == 2) {
                     testAggressiveStrategy();
+                    testAttackCandidates();
+                }
                 else if (choice == 3)
                     testNeutralStrategy();
                 else if (choice == 4)
                     testNeutralStrategy();
                 else if (choice == 5)
                     testCheaterStrategy();
+                else if (choice == 6)
+                    testStrategyDispatch();
+                else if (choice == 7)
+                    testTuner();
                 else
                     std::cout << "Invalid choice" << std::endl;
                 break;
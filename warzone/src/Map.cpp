@@ -1,10 +1,20 @@
 #include "Map.h"
+#include "BinaryMap.h"
+#include "DistanceTable.h"
+#include "MappedFile.h"
 #include "Player.h"
+#include "Zobrist.h"
+#include <cstring>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <memory_resource>
+#include <mutex>
+#include <new>
 #include <ostream>
 #include <regex>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -18,58 +28,141 @@ Territory::~Territory() {
         this->adjacent[i] = nullptr;
     }
 }
-// full parametrized constructor
-Territory::Territory(std::string name, int armies, Player* owner, std::string continent)
-    : name(name)
+// full parametrized constructor, territories outside of a map use the global names
+Territory::Territory(std::string_view name, int armies, Player* owner, std::string_view continent)
+    : names(&NameTable::global())
+    , nameId(names->intern(name))
     , armies(armies)
     , owner(owner)
-    , continent(continent)
-
-{
+    , continentId(names->intern(continent))
+    , enemyNeighbors(0)
+    , frontierSlot(0)
+    , index(static_cast<size_t>(-1))
+    , map(nullptr) {
+} // constructor for the territories of a map, named in the map's table, adjacent to territories listed in the map's memory
+Territory::Territory(NameTable* names, std::uint32_t name, std::uint32_t continent, std::pmr::memory_resource* memory)
+    : names(names)
+    , nameId(name)
+    , armies(0)
+    , owner(nullptr)
+    , continentId(continent)
+    , adjacent(memory)
+    , enemyNeighbors(0)
+    , frontierSlot(0)
+    , index(static_cast<size_t>(-1))
+    , map(nullptr) {
 } // no owner parametrized delegated constructor
-Territory::Territory(std::string name, int armies, std::string continent)
+Territory::Territory(std::string_view name, int armies, std::string_view continent)
     : Territory(name, armies, nullptr, continent) {
 }
 // no owner no armies parametrized delegated constructor
-Territory::Territory(std::string name, std::string continent)
+Territory::Territory(std::string_view name, std::string_view continent)
     : Territory(name, 0, nullptr, continent) {
 }
-// special constructor for parsing
-Territory::Territory(std::string name)
+// name only constructor
+Territory::Territory(std::string_view name)
     : Territory(name, -1, nullptr, "") {
 }
 // copy constructor
 Territory::Territory(const Territory& other)
-    : Territory(other.name, other.armies, other.owner, other.continent) {
+    : Territory(other.names, other.nameId, other.continentId) {
+    this->armies = other.armies;
+    this->owner = other.owner;
+    this->enemyNeighbors = other.enemyNeighbors;
+    this->index = other.index;
 }
-// territory assignment operator
+// territory assignment operator, the territory stays in its map
 Territory& Territory::operator=(const Territory& other) {
-    name = other.name;
+    if (map) {
+        map->hash ^= zobrist();
+    }
+    names = other.names;
+    nameId = other.nameId;
     armies = other.armies;
     owner = other.owner;
-    continent = other.continent;
+    continentId = other.continentId;
     adjacent = other.adjacent;
+    enemyNeighbors = other.enemyNeighbors;
+    index = other.index;
+    if (map) {
+        map->hash ^= zobrist();
+        map->board.setArmies(index, armies);
+        map->board.setOwner(index, owner);
+    }
     return *this;
 }
 // setter
-void Territory::setName(std::string name) {
-    this->name = name;
+void Territory::setName(std::string_view name) {
+    this->nameId = this->names->intern(name);
 }
 // setter
 void Territory::setArmies(int armies) {
+    if (this->map && Zobrist::armyBucket(armies) != Zobrist::armyBucket(this->armies)) {
+        this->map->hash ^= Zobrist::key(Zobrist::Feature::Armies, this->index, Zobrist::armyBucket(this->armies))
+            ^ Zobrist::key(Zobrist::Feature::Armies, this->index, Zobrist::armyBucket(armies));
+    }
     this->armies = armies;
+    if (this->map) {
+        this->map->board.setArmies(this->index, armies);
+    }
 }
-// setter
+// setter, also keeps the enemy neighbor counts and the owners' frontiers up to date
 void Territory::setOwner(Player* owner) {
+    Player* previous = this->owner;
+    if (previous == owner) {
+        return;
+    }
+    if (previous && this->enemyNeighbors > 0) {
+        previous->removeFromFrontier(this);
+    }
+
+    if (this->map) {
+        this->map->hash ^= (previous ? Zobrist::key(Zobrist::Feature::Owner, this->index, previous->getZobristKey()) : 0)
+            ^ (owner ? Zobrist::key(Zobrist::Feature::Owner, this->index, owner->getZobristKey()) : 0);
+        this->map->ownerChanges++;
+        this->map->board.setOwner(this->index, owner);
+    }
     this->owner = owner;
+    this->enemyNeighbors = 0;
+    for (auto a : this->adjacent) {
+        if (a->owner != owner) {
+            this->enemyNeighbors++;
+        }
+        // Only the neighbors of the previous and new owner see their count change
+        if (a->owner == previous) {
+            if (a->enemyNeighbors++ == 0 && a->owner) {
+                a->owner->addToFrontier(a);
+            }
+        } else if (a->owner == owner) {
+            if (--a->enemyNeighbors == 0 && a->owner) {
+                a->owner->removeFromFrontier(a);
+            }
+        }
+    }
+    if (owner && this->enemyNeighbors > 0) {
+        owner->addToFrontier(this);
+    }
+}
+std::uint64_t Territory::zobrist() const {
+    std::uint64_t hash = Zobrist::key(Zobrist::Feature::Armies, this->index, Zobrist::armyBucket(this->armies));
+    if (this->owner) {
+        hash ^= Zobrist::key(Zobrist::Feature::Owner, this->index, this->owner->getZobristKey());
+    }
+    return hash;
+}
+void Territory::rekeyOwner(std::uint64_t previousKey) {
+    if (this->map && this->owner) {
+        this->map->hash ^= Zobrist::key(Zobrist::Feature::Owner, this->index, previousKey)
+            ^ Zobrist::key(Zobrist::Feature::Owner, this->index, this->owner->getZobristKey());
+    }
 }
 // setter
-void Territory::setContinent(std::string continent) {
-    this->continent = continent;
+void Territory::setContinent(std::string_view continent) {
+    this->continentId = this->names->intern(continent);
 }
 // getter
 std::string Territory::getName() const {
-    return this->name;
+    return this->names->name(this->nameId);
 }
 // getter
 int Territory::getArmies() const {
@@ -80,19 +173,35 @@ Player* Territory::getOwner() const {
     return this->owner;
 }
 // getter
+size_t Territory::getIndex() const {
+    return this->index;
+}
+// getter
 std::string Territory::getContinent() const {
-    return this->continent;
+    return this->names->name(this->continentId);
+}
+// getter
+std::uint32_t Territory::getNameId() const {
+    return this->nameId;
+}
+// getter
+std::uint32_t Territory::getContinentId() const {
+    return this->continentId;
 }
 
-const std::vector<Territory*>& Territory::getAdjacent() const {
+const std::pmr::vector<Territory*>& Territory::getAdjacent() const {
     return this->adjacent;
 }
+// getter
+int Territory::getEnemyNeighbors() const {
+    return this->enemyNeighbors;
+}
 // print the territory and adjacent territories
 void Territory::prettyPrint() {
     std::cout << *this << std::endl;
     std::cout << "The adjacent territories are: ";
     for (size_t i = 0; i < this->adjacent.size(); i++) {
-        std::cout << this->adjacent[i]->name << ", ";
+        std::cout << this->adjacent[i]->getName() << ", ";
     }
     std::cout << std::endl;
 }
@@ -100,17 +209,25 @@ void Territory::prettyPrint() {
 // territory stream insertion operator
 std::ostream& operator<<(std::ostream& out, const Territory& territory) {
     return out
-        << "This is " << territory.name
+        << "This is " << territory.getName()
         << " containing " << territory.armies
         << " armies, owned by " << *territory.owner
-        << " on the continent " << territory.continent;
+        << " on the continent " << territory.getContinent();
 }
 
 // fully parametrized constructor
-Continent::Continent(int armies, std::string name, std::vector<Territory*> territories)
+Continent::Continent(int armies, std::string_view name, std::pmr::vector<Territory*> territories)
+    : armies(armies)
+    , names(&NameTable::global())
+    , nameId(names->intern(name))
+    , territories(std::move(territories)) {
+}
+// constructor for the continents of a map, named in the map's table, listing its territories in the map's memory
+Continent::Continent(NameTable* names, std::uint32_t name, int armies, std::pmr::memory_resource* memory)
     : armies(armies)
-    , name(name)
-    , territories(territories) {
+    , names(names)
+    , nameId(name)
+    , territories(memory) {
 }
 // continent destructor
 Continent::~Continent() {
@@ -119,12 +236,11 @@ Continent::~Continent() {
     }
 }
 // no vector constructor
-Continent::Continent(int armies, std::string name)
-    : armies(armies)
-    , name(name) {
+Continent::Continent(int armies, std::string_view name)
+    : Continent(armies, name, std::pmr::vector<Territory*>()) {
 }
 // no vector, no armies delegated constructor
-Continent::Continent(std::string name)
+Continent::Continent(std::string_view name)
     : Continent(0, name) {
 }
 // default delegated constructor
@@ -132,18 +248,37 @@ Continent::Continent()
     : Continent(0, "") {
 }
 Continent::Continent(const Continent& other)
-    : Continent(other.armies, other.name, other.territories) {
+    : Continent(other.names, other.nameId, other.armies) {
+    this->territories = other.territories;
+}
+// move constructor, steals the territories unless they are listed in another memory than the default one
+Continent::Continent(Continent&& other)
+    : armies(other.armies)
+    , names(other.names)
+    , nameId(other.nameId)
+    , territories(std::move(other.territories), std::pmr::get_default_resource()) {
 }
 // continent assignment operator
 Continent& Continent::operator=(const Continent& other) {
-    name = other.name;
+    names = other.names;
+    nameId = other.nameId;
     armies = other.armies;
     territories = other.territories;
     return *this;
 }
+// continent move assignment operator, the territories stay in this continent's memory
+Continent& Continent::operator=(Continent&& other) {
+    if (this != &other) {
+        names = other.names;
+        nameId = other.nameId;
+        armies = other.armies;
+        territories = std::move(other.territories);
+    }
+    return *this;
+}
 // setter
-void Continent::setName(std::string name) {
-    this->name = name;
+void Continent::setName(std::string_view name) {
+    this->nameId = this->names->intern(name);
 }
 // setter
 void Continent::setArmies(int armies) {
@@ -151,7 +286,11 @@ void Continent::setArmies(int armies) {
 }
 // getter
 std::string Continent::getName() const {
-    return this->name;
+    return this->names->name(this->nameId);
+}
+// getter
+std::uint32_t Continent::getNameId() const {
+    return this->nameId;
 }
 // getter
 int Continent::getArmies() const {
@@ -173,45 +312,164 @@ void Continent::addTerritory(Territory* territory) {
 // continent stream insertion operator
 std::ostream& operator<<(std::ostream& out, const Continent& continent) {
     return out
-        << "This is the continent " << continent.name
+        << "This is the continent " << continent.getName()
         << " awarding " << continent.armies << " armies.";
 }
-// only map constructor
-Map::Map() {
-}
-// map destructor
-Map::~Map() {
-    for (size_t i = 0; i < this->territories.size(); i++) {
-        delete this->territories[i];
+// distance table of a map, computed once by whichever copy asks first
+struct Map::DistanceSlot {
+    std::once_flag once;
+    std::unique_ptr<DistanceTable> table;
+};
+// heap memory behind an arena, counting the blocks it hands out
+class ArenaUpstream : public std::pmr::memory_resource {
+public:
+    std::size_t bytes = 0;
+    std::size_t blocks = 0;
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        this->bytes += bytes;
+        this->blocks++;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+// territories and continents of a map with their adjacency and membership lists, in blocks freed together,
+// destroyed by the last map holding them
+struct Map::Arena {
+    /** @brief Room for a map without a known size, the blocks then double */
+    static constexpr std::size_t DEFAULT_BYTES = 16 * 1024;
+
+    ArenaUpstream upstream;
+    std::pmr::monotonic_buffer_resource memory;
+    std::pmr::vector<Territory*> territories;
+    std::pmr::vector<Continent*> continents;
+
+    Arena(std::size_t bytes)
+        : memory(bytes, &upstream)
+        , territories(&memory)
+        , continents(&memory) { }
+    Arena(const Arena& other) = delete;
+    ~Arena() {
+        for (auto t : this->territories) {
+            t->~Territory();
+        }
+        for (auto c : this->continents) {
+            c->~Continent();
+        }
     }
-    territories.clear();
 
-    for (size_t i = 0; i < this->continents.size(); i++) {
-        delete this->continents[i];
+    // Bytes for that many objects and links, with room to align each allocation
+    static std::size_t bytes(std::size_t territories, std::size_t continents, std::size_t links) {
+        std::size_t allocations = 2 * territories + 2 * continents + 2;
+        return territories * (sizeof(Territory) + sizeof(Territory*)) + continents * (sizeof(Continent) + sizeof(Continent*))
+            + links * sizeof(Territory*) + allocations * alignof(std::max_align_t);
     }
-    continents.clear();
+};
+// only map constructor, the arena is made with the first territory or continent
+Map::Map()
+    : validated(false)
+    , distances(std::make_shared<DistanceSlot>())
+    , names(std::make_shared<NameTable>())
+    , hash(0)
+    , ownerChanges(0)
+    , unresolved(0) {
+}
+// map destructor, the arena frees the territories and continents at once
+Map::~Map() {
 }
-// copy constructor
+// copy constructor, the copies are linked to each other the same way the originals are
 Map::Map(const Map& other)
-    : Map() {
+    : validated(other.validated)
+    , distances(other.distances)
+    , names(other.names)
+    , hash(0)
+    , ownerChanges(0)
+    , unresolved(other.unresolved) {
+    std::size_t n = other.territories.size();
+    std::size_t links = 0;
     for (auto t : other.territories) {
-        this->territories.push_back(new Territory(*t));
+        links += t->adjacent.size();
     }
     for (auto c : other.continents) {
-        this->continents.push_back(new Continent(c->getArmies(), c->getName()));
+        links += c->territories.size();
     }
-    this->associateTerritories();
-    for (size_t i = 0; i < this->getNumberTerritories(); i++) {
-        this->addTerritoryToContinent(this->territories[i]->getName(), this->territories[i]->getContinent());
+    reserve(n, other.continents.size(), links);
+    this->byName.assign(other.byName.size(), nullptr);
+    for (auto t : other.territories) {
+        Territory* copy = makeTerritory(t->nameId, t->continentId);
+        copy->armies = t->armies;
+        copy->owner = t->owner;
+        copy->enemyNeighbors = t->enemyNeighbors;
+        insertTerritory(copy);
     }
+    // The territories keep their index in the copy, links to anything else have no copy
+    auto copyOf = [&other, this](const Territory* t) {
+        if (t->index >= other.territories.size() || other.territories[t->index] != t) {
+            throw std::out_of_range("Territory " + t->getName() + " is not in the map");
+        }
+        return this->territories[t->index];
+    };
+    for (size_t i = 0; i < n; i++) {
+        auto& adjacent = this->territories[i]->adjacent;
+        adjacent.reserve(other.territories[i]->adjacent.size());
+        for (auto a : other.territories[i]->adjacent) {
+            adjacent.push_back(copyOf(a));
+        }
+    }
+    for (auto c : other.continents) {
+        Continent* copy = makeContinent(c->nameId, c->armies);
+        copy->territories.reserve(c->territories.size());
+        for (auto t : c->territories) {
+            copy->territories.push_back(copyOf(t));
+        }
+    }
+    this->board.layout = other.board.layout;
 }
-// map assignment operator
-Map& Map::operator=(Map* map) {
-    if (this != map) {
-        territories = map->territories;
-        continents = map->continents;
+
+void Map::reserve(std::size_t territories, std::size_t continents, std::size_t links) {
+    this->territories.reserve(territories);
+    this->continents.reserve(continents);
+    this->board.reserve(territories);
+    if (this->arena && (!this->arena->territories.empty() || !this->arena->continents.empty())) {
+        return;
     }
-    return *this;
+    this->arena = std::make_shared<Arena>(Arena::bytes(territories, continents, links));
+    this->arena->territories.reserve(territories);
+    this->arena->continents.reserve(continents);
+}
+
+Territory* Map::makeTerritory(std::uint32_t name, std::uint32_t continent) {
+    if (!this->arena) {
+        this->arena = std::make_shared<Arena>(Arena::DEFAULT_BYTES);
+    }
+    void* memory = this->arena->memory.allocate(sizeof(Territory), alignof(Territory));
+    Territory* territory = new (memory) Territory(this->names.get(), name, continent, &this->arena->memory);
+    this->arena->territories.push_back(territory);
+    return territory;
+}
+
+Continent* Map::makeContinent(std::uint32_t name, int armies) {
+    if (!this->arena) {
+        this->arena = std::make_shared<Arena>(Arena::DEFAULT_BYTES);
+    }
+    void* memory = this->arena->memory.allocate(sizeof(Continent), alignof(Continent));
+    Continent* continent = new (memory) Continent(this->names.get(), name, armies, &this->arena->memory);
+    this->arena->continents.push_back(continent);
+    this->continents.push_back(continent);
+    return continent;
+}
+
+std::size_t Map::getArenaBytes() const {
+    return this->arena ? this->arena->upstream.bytes : 0;
+}
+std::size_t Map::getArenaBlocks() const {
+    return this->arena ? this->arena->upstream.blocks : 0;
 }
 
 std::size_t Map::getNumberTerritories() const {
@@ -222,16 +480,36 @@ std::size_t Map::getNumberContinents() const {
 }
 
 // adds a territory to the map
-void Map::addTerritory(std::string name, std::string continent) {
-    this->territories.push_back(new Territory(name, continent)); // TODO: add parameters in the constructor
+void Map::addTerritory(std::string_view name, std::string_view continent) {
+    this->validated = false;
+    this->distances = std::make_shared<DistanceSlot>();
+    this->board.relayout();
+    insertTerritory(makeTerritory(this->names->intern(name), this->names->intern(continent)));
+}
+// registers a territory named in the map's table
+void Map::insertTerritory(Territory* territory) {
+    territory->index = this->territories.size();
+    territory->map = this;
+    this->hash ^= territory->zobrist();
+    this->territories.push_back(territory);
+    this->board.add(territory->armies, territory->owner);
+    if (territory->nameId >= this->byName.size()) {
+        this->byName.resize(territory->nameId + 1, nullptr);
+    }
+    // Like a search through the territories, the first one with a name is the one found
+    if (!this->byName[territory->nameId]) {
+        this->byName[territory->nameId] = territory;
+    }
 }
 
 // adds a continent to the map
-void Map::addContinent(int armies, std::string name) {
-    this->continents.push_back(new Continent(armies, name)); // TODO: add parameters in the constructor
+void Map::addContinent(int armies, std::string_view name) {
+    this->validated = false;
+    this->board.relayout();
+    makeContinent(this->names->intern(name), armies);
 }
 // modify a territory's owner in the map
-void Map::setTerritoryOwner(std::string territory, Player* owner) {
+void Map::setTerritoryOwner(std::string_view territory, Player* owner) {
     Territory* territoryPtr = findTerritory(territory);
     if (territoryPtr) {
         territoryPtr->setOwner(owner);
@@ -244,7 +522,8 @@ void Map::setTerritoryOwner(Territory* territory, Player* owner) {
     territory->setOwner(owner);
 }
 // adds a territory to a continent in the map, the territory is supposed to already exists in Map's territory vector
-void Map::addTerritoryToContinent(std::string territory, std::string continent) {
+void Map::addTerritoryToContinent(std::string_view territory, std::string_view continent) {
+    this->validated = false;
     if (!continents.front() || !territories.front()) {
         std::cout << "No continent or territory exists, cannot add territory to a continent" << std::endl;
         return;
@@ -254,23 +533,30 @@ void Map::addTerritoryToContinent(std::string territory, std::string continent)
         std::cout << "Did not find territory " << territory << " in the list of territories" << std::endl;
         return;
     }
-    for (size_t j = 0; j < this->continents.size(); ++j) {
-        if (continents[j]->getName() == continent) {
-            continents[j]->addTerritory(territoryPtr);
-            std::cout << "Successfully added " << territoryPtr->getName() << " territory to " << continent << " continent to the map" << std::endl;
-            std::cout << std::endl;
-            return;
-        }
+    Continent* continentPtr = findContinent(this->names->find(continent));
+    if (continentPtr) {
+        continentPtr->addTerritory(territoryPtr);
+        this->board.relayout();
+        std::cout << "Successfully added " << territory << " territory to " << continent << " continent to the map" << std::endl;
+        std::cout << std::endl;
+        return;
     }
     std::cout << "Did not find continent " << continent << " in the list of continents" << std::endl; // TODO: this should be throwing an error instead of printing
     // error should be handled to announce that the .map file is not forming a valid map
 }
 // find a territory in the map, returns a ptr to the territory(nullptr if not)
-Territory* Map::findTerritory(std::string territory) {
-    for (size_t i = 0; i < this->territories.size(); i++) {
-        if (this->territories[i]->getName() == territory) {
-            Territory* ptr = territories[i];
-            return ptr;
+Territory* Map::findTerritory(std::string_view territory) {
+    return findTerritory(this->names->find(territory));
+}
+// find a territory by the id of its name, returns nullptr if no territory has that name
+Territory* Map::findTerritory(std::uint32_t name) {
+    return name < this->byName.size() ? this->byName[name] : nullptr;
+}
+// find a continent by the id of its name, returns nullptr if no continent has that name
+Continent* Map::findContinent(std::uint32_t name) {
+    for (auto c : this->continents) {
+        if (c->nameId == name) {
+            return c;
         }
     }
     return nullptr;
@@ -296,36 +582,28 @@ void Map::prettyPrintContinents() const {
 }
 
 int Map::continentRewards(Player* p) {
-    int reinforcements = 0;
-    for (size_t i = 0; i < this->getNumberContinents(); i++) {
-        bool condition = true;
-        for (size_t j = 0; j < this->continents[i]->territories.size(); j++) {
-            if (this->continents[i]->territories[j]->getOwner() != p) {
-                condition = false;
-            }
-        }
-        if (condition) {
-            reinforcements += this->continents[i]->getArmies();
-        }
-    }
-    return reinforcements;
+    return getBoard().continentRewards(p);
 }
 
-// used in parsing, replaces each temporary territory present in each actual territory's adjacency vector with the proper territory
+// used in parsing, links each territory to the adjacent territories its line named, once they are all known
 void Map::associateTerritories() {
-    for (size_t i = 0; i < this->territories.size(); i++) {
-        if (this->territories[i] != nullptr) {
-            for (size_t j = 0; j < this->territories[i]->adjacent.size(); ++j) {
-                for (size_t k = 0; k < territories.size(); ++k) {
-                    if (territories[k]->getName() == territories[i]->adjacent[j]->getName()) {
-                        delete territories[i]->adjacent[j];
-                        territories[i]->adjacent[j] = territories[k];
-                        break;
-                    }
-                }
+    this->validated = false;
+    this->distances = std::make_shared<DistanceSlot>();
+    this->board.relayout();
+    for (size_t at = 0; at < this->adjacentNames.size();) {
+        Territory* territory = this->territories[this->adjacentNames[at]];
+        size_t end = at + 2 + this->adjacentNames[at + 1];
+        for (at += 2; at < end; at++) {
+            Territory* adjacent = findTerritory(this->adjacentNames[at]);
+            if (adjacent) {
+                territory->adjacent.push_back(adjacent);
+            } else {
+                this->unresolved++;
             }
         }
     }
+    this->adjacentNames.clear();
+    this->adjacentNames.shrink_to_fit();
 }
 // validation method for a completed map object, checks territory adjacency and ownership by continent
 // because of the parser's implementation, it is useless to check for a territory in multiple continents
@@ -335,18 +613,23 @@ bool Map::validate() const {
         std::cout << "This map is empty, it is not validated." << std::endl;
         return false;
     }
+    if (this->unresolved > 0) {
+        std::cout << "This map names " << this->unresolved << " adjacent territories it does not have, it is not validated." << std::endl;
+        return false;
+    }
+    if (this->validated) {
+        std::cout << "This map was already validated." << std::endl;
+        return true;
+    }
     std::cout << "Validating main graph structure" << std::endl;
     std::vector<size_t> visitedTerrs;
     visitedTerrs.assign(adjLsize, 0);
     for (size_t i = 0; i < adjLsize; i++) {
         if (!this->territories[i])
             return false;
-        for (size_t j = 0; j < this->territories[i]->adjacent.size(); ++j) {
-            for (size_t k = 0; k < adjLsize; ++k) {
-                if (territories[k] == territories[i]->adjacent[j]) {
-                    visitedTerrs.at(k)++;
-                    break;
-                }
+        for (auto a : this->territories[i]->adjacent) {
+            if (a->index < adjLsize && territories[a->index] == a) {
+                visitedTerrs[a->index]++;
             }
         }
     }
@@ -373,8 +656,48 @@ bool Map::validate() const {
     }
     std::cout << "Map's continent subgraphs are validated" << std::endl;
     std::cout << "Because of the parser's implementation, it is impossible for any territory to have more than one continent." << std::endl;
+    this->validated = true;
     return true;
 }
+const DistanceTable& Map::getDistances() const {
+    DistanceSlot& slot = *this->distances;
+    std::call_once(slot.once, [this, &slot]() {
+        slot.table = std::make_unique<DistanceTable>(*this);
+    });
+    return *slot.table;
+}
+
+const Board& Map::getBoard() const {
+    Board::Layout& layout = *this->board.layout;
+    std::call_once(layout.once, [this, &layout]() {
+        layout.build(*this);
+    });
+    return this->board;
+}
+
+bool Map::isValidated() const {
+    return this->validated;
+}
+
+const NameTable& Map::getNames() const {
+    return *this->names;
+}
+
+std::uint64_t Map::getHash() const {
+    return this->hash;
+}
+
+std::uint64_t Map::getOwnerChanges() const {
+    return this->ownerChanges;
+}
+
+std::uint64_t Map::computeHash() const {
+    std::uint64_t hash = 0;
+    for (auto t : this->territories) {
+        hash ^= t->zobrist();
+    }
+    return hash;
+}
 // map stream operator
 std::ostream& operator<<(std::ostream& out, const Map& map) {
     return out
@@ -441,6 +764,9 @@ Map* MapLoader::parse() {
         throw ParsingException(lineNumber, message);
     };
     Map* mapObj = new Map();
+    // Names of the adjacent territories, reused from one line to the next
+    std::vector<std::string> adjacent;
+    std::size_t adjacentCount = 0;
     for (std::string line; std::getline(this->stream, line);) {
         lineNumber++;
 
@@ -572,12 +898,17 @@ Map* MapLoader::parse() {
             }
             expectCharacter(',');
             std::string country = getUntil(',');
-            std::vector<std::string> adjacent;
-            adjacent.reserve(10);
-            for (std::string a; std::getline(lineStream, a, ',');) {
-                adjacent.push_back(a);
+            adjacentCount = 0;
+            while (true) {
+                if (adjacentCount == adjacent.size()) {
+                    adjacent.emplace_back();
+                }
+                if (!std::getline(lineStream, adjacent[adjacentCount], ',')) {
+                    break;
+                }
+                adjacentCount++;
             }
-            if (adjacent.empty()) {
+            if (adjacentCount == 0) {
                 fail("Expected list of adjacent territories");
             }
             mapObj->addTerritory(territory, country);
@@ -588,9 +919,13 @@ Map* MapLoader::parse() {
                 << " at (" << x << ", " << y << ")"
                 << " in country " << country
                 << " adjacent to ";
-            for (auto a : adjacent) {
-                temp->adjacent.push_back(new Territory(a));
-                std::cout << a << ", ";
+            temp->adjacent.reserve(temp->adjacent.size() + adjacentCount);
+            // Only the names are kept for now, the territories are linked once they are all known
+            mapObj->adjacentNames.push_back(static_cast<std::uint32_t>(temp->index));
+            mapObj->adjacentNames.push_back(static_cast<std::uint32_t>(adjacentCount));
+            for (std::size_t i = 0; i < adjacentCount; i++) {
+                mapObj->adjacentNames.push_back(mapObj->names->intern(adjacent[i]));
+                std::cout << adjacent[i] << ", ";
             }
             std::cout << std::endl;
             temp = nullptr;
@@ -602,6 +937,23 @@ Map* MapLoader::parse() {
     return mapObj;
 }
 
+Map* MapLoader::load(const std::string& path) {
+    if (BinaryMapLoader::isBinary(path)) {
+        return BinaryMapLoader(path).parse();
+    }
+    std::ifstream file(path);
+    return MapLoader(file).parse();
+}
+
+Map* MapLoader::load(const MappedFile& file) {
+    if (file.size() >= sizeof(wzmap::MAGIC) && std::memcmp(file.data(), wzmap::MAGIC, sizeof(wzmap::MAGIC)) == 0) {
+        return BinaryMapLoader(file.getPath()).parse();
+    }
+    MemoryBuffer buffer(file.data(), file.size());
+    std::istream stream(&buffer);
+    return MapLoader(stream).parse();
+}
+
 std::ostream& operator<<(std::ostream& strm, const MapLoader* maploader) {
     return strm << "This MapLoader loads a file.";
 }
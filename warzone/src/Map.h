@@ -1,54 +1,98 @@
 #pragma once
 
+#include "Board.h"
+#include "NameTable.h"
 #include "Player.fwd.h"
+#include <cstdint>
 #include <exception>
 #include <iomanip>
 #include <iostream>
+#include <memory>
+#include <memory_resource>
 #include <regex>
 #include <string>
+#include <string_view>
 #include <vector>
 
 extern std::regex TRIM_WHITESPACE;
 
+class DistanceTable;
+class Map;
+class MappedFile;
+
 /**
  * @class Territory
  * @brief a class to implement a Territory object
- * @param name string: the name of the territory
+ * @param names NameTable*: the table holding the names of the territory and its continent, the map's or the global one
+ * @param nameId uint32_t: the id of the name of the territory
  * @param armies int: the number of armies currently in the territory
  * @param owner string: the name of the player owning the territory
- * @param continent string: the name of the continent the territory is on
- * @param adjacent vector<Territory*>: a vector containing pointers to adjacent territories
+ * @param continentId uint32_t: the id of the name of the continent the territory is on
+ * @param adjacent pmr::vector<Territory*>: a vector containing pointers to adjacent territories, in the map's arena for the territories of a map
+ * @param enemyNeighbors int: the number of adjacent territories not owned by the owner, kept up to date by setOwner
+ * @param frontierSlot size_t: the position of the territory in its owner's frontier, if it is on the frontier
+ * @param index size_t: the position of the territory in its map, the same in every copy of the map
+ * @param map Map*: the map holding the territory, whose hash follows its owner and armies
  */
 class Territory {
     friend class Map;
     friend class MapLoader;
+    friend class MapCompiler;
+    friend class BinaryMapLoader;
+    friend class DistanceTable;
+    friend class Board;
 
 private:
-    std::string name;
+    NameTable* names;
+    std::uint32_t nameId;
     int armies;
     Player* owner;
-    std::string continent;
-    std::vector<Territory*> adjacent;
+    std::uint32_t continentId;
+    std::pmr::vector<Territory*> adjacent;
+    int enemyNeighbors;
+    size_t frontierSlot;
+    size_t index;
+    Map* map;
+
+    friend class Player;
+
+    /**
+     * @brief Keys of the owner and armies of the territory in the Zobrist hash of its map
+     */
+    std::uint64_t zobrist() const;
+    /**
+     * @brief Update the hash of the map after the owner got a new key
+     */
+    void rekeyOwner(std::uint64_t previousKey);
+
+    Territory(NameTable* names, std::uint32_t name, std::uint32_t continent, std::pmr::memory_resource* memory = std::pmr::get_default_resource());
 
 public:
     Territory();
     ~Territory();
-    Territory(std::string name, int armies, Player* owner, std::string continent);
-    Territory(std::string name, int armies, std::string continent);
-    Territory(std::string name, std::string continent);
-    Territory(std::string name);
+    Territory(std::string_view name, int armies, Player* owner, std::string_view continent);
+    Territory(std::string_view name, int armies, std::string_view continent);
+    Territory(std::string_view name, std::string_view continent);
+    Territory(std::string_view name);
     Territory(const Territory& other);
     Territory& operator=(const Territory& other);
 
-    void setName(std::string name);
+    void setName(std::string_view name);
     void setArmies(int armies);
     void setOwner(Player* owner);
-    void setContinent(std::string continent);
+    void setContinent(std::string_view continent);
     std::string getName() const;
     int getArmies() const;
     Player* getOwner() const;
     std::string getContinent() const;
-    const std::vector<Territory*>& getAdjacent() const;
+    std::uint32_t getNameId() const;
+    std::uint32_t getContinentId() const;
+    const std::pmr::vector<Territory*>& getAdjacent() const;
+    /**
+     * @brief Number of adjacent territories owned by someone else (or no one), in O(1)
+     */
+    int getEnemyNeighbors() const;
+    size_t getIndex() const;
 
     void prettyPrint();
     friend std::ostream& operator<<(std::ostream& out, const Territory& territory);
@@ -58,30 +102,43 @@ public:
  * @class Continent
  * @brief a class to implement a Continent object
  * @param armies int: the number of armies the continent awards
- * @param name string: the name of the continent
- * @param territories vector<Territory*>: a vector containing pointers to the territories in the continent
+ * @param names NameTable*: the table holding the name of the continent, the map's or the global one
+ * @param nameId uint32_t: the id of the name of the continent
+ * @param territories pmr::vector<Territory*>: a vector containing pointers to the territories in the continent, in the map's arena for the continents of a map
  */
 class Continent {
     friend class Map;
+    friend class MapCompiler;
+    friend class BinaryMapLoader;
+    friend class Board;
 
 private:
     int armies;
-    std::string name;
-    std::vector<Territory*> territories;
+    NameTable* names;
+    std::uint32_t nameId;
+    std::pmr::vector<Territory*> territories;
+
+    Continent(NameTable* names, std::uint32_t name, int armies, std::pmr::memory_resource* memory = std::pmr::get_default_resource());
 
 public:
     Continent();
     ~Continent();
-    Continent(int armies, std::string name, std::vector<Territory*> territories);
-    Continent(int armies, std::string name); // This constructor creates a vector<Territory*>
-    Continent(std::string name); // This constructor creates a vector<Territory*>
+    Continent(int armies, std::string_view name, std::pmr::vector<Territory*> territories);
+    Continent(int armies, std::string_view name); // This constructor creates a vector<Territory*>
+    Continent(std::string_view name); // This constructor creates a vector<Territory*>
     Continent(const Continent& other);
+    /**
+     * @brief Take the territories of the other continent, without copying them unless it lives in a map's arena
+     */
+    Continent(Continent&& other);
     Continent& operator=(const Continent& other);
+    Continent& operator=(Continent&& other);
 
-    void setName(std::string name);
+    void setName(std::string_view name);
     void setArmies(int armies);
 
     std::string getName() const;
+    std::uint32_t getNameId() const;
     int getArmies() const;
     void prettyPrint() const;
     void addTerritory(Territory* territory); // Add a territory at the end of the vector
@@ -94,36 +151,88 @@ public:
  * @brief a class to implement a Map object
  * @param territories vector<Territory*>: a vector containing pointers to the territories in the map
  * @param continents vector<Continent*>: a vector containing pointers to the continents on the map
+ * @param validated bool: whether the map is known to be valid, set by validate and reset by any structural change
+ * @param distances DistanceSlot: the distance table, shared by all the copies of the map and replaced by any structural change
+ * @param names NameTable: the names of the territories and continents, shared by all the copies of the map
+ * @param byName vector<Territory*>: the territories indexed by the id of their name
+ * @param hash uint64_t: the Zobrist hash of the owners and armies of the territories, kept up to date by the territories
+ * @param ownerChanges uint64_t: the number of times a territory of the map changed owner
+ * @param board Board: the owners and armies of the territories in contiguous arrays, kept up to date by the territories
+ * @param arena Arena: the memory of the territories and continents, freed at once with the map
+ * @param adjacentNames vector<uint32_t>: for each parsed territory, its index, the number of its adjacent territories and the name of each, linked by associateTerritories
+ * @param unresolved size_t: the adjacent territories named by the file but not on the map, which is then never valid
  */
 class Map {
+    friend class Territory;
+    friend class MapLoader;
+    friend class MapCompiler;
+    friend class BinaryMapLoader;
+    friend class DistanceTable;
+    friend class Board;
+
 private:
+    struct DistanceSlot;
+    struct Arena;
+
     std::vector<Territory*> territories;
     std::vector<Continent*> continents;
+    mutable bool validated;
+    std::shared_ptr<DistanceSlot> distances;
+    std::shared_ptr<NameTable> names;
+    std::vector<Territory*> byName;
+    std::uint64_t hash;
+    std::uint64_t ownerChanges;
+    Board board;
+    std::shared_ptr<Arena> arena;
+    std::vector<std::uint32_t> adjacentNames;
+    std::size_t unresolved;
+
+    /**
+     * @brief Make room for that many territories, continents and links between them, the arena is only sized before anything is made in it
+     */
+    void reserve(std::size_t territories, std::size_t continents, std::size_t links);
+    /**
+     * @brief Make a territory named in the map's table in the arena, owned by the map but not one of its territories yet
+     */
+    Territory* makeTerritory(std::uint32_t name, std::uint32_t continent);
+    /**
+     * @brief Make a continent named in the map's table in the arena and add it to the map
+     */
+    Continent* makeContinent(std::uint32_t name, int armies);
+    /**
+     * @brief Add a territory made with the map's names, keeping its index and the lookup by name up to date
+     */
+    void insertTerritory(Territory* territory);
+    Continent* findContinent(std::uint32_t name);
 
 public:
     Map();
     ~Map();
     Map(const Map& other);
-    Map& operator=(Map* other);
+    Map& operator=(const Map& other) = delete;
 
     std::size_t getNumberTerritories() const;
     std::size_t getNumberContinents() const;
 
-    void addTerritory(std::string name, std::string continent);
-    void addContinent(int armies, std::string name);
+    void addTerritory(std::string_view name, std::string_view continent);
+    void addContinent(int armies, std::string_view name);
     /**
      * @brief to add an owner to a territory by name
      */
-    void setTerritoryOwner(std::string territory, Player* player);
+    void setTerritoryOwner(std::string_view territory, Player* player);
     /**
      * @brief overloaded to accommodate for an index in AdjL
      */
     void setTerritoryOwner(Territory* territory, Player* player);
-    void addTerritoryToContinent(std::string territory, std::string continent);
+    void addTerritoryToContinent(std::string_view territory, std::string_view continent);
+    /**
+     * @brief To find a territory by name, in O(1)
+     */
+    Territory* findTerritory(std::string_view territory);
     /**
-     * @brief To find a territory by name
+     * @brief To find a territory by the id of its name in the map's NameTable
      */
-    Territory* findTerritory(std::string territory);
+    Territory* findTerritory(std::uint32_t name);
     /**
      * @brief To find a territory by index in AdjL
      */
@@ -138,6 +247,41 @@ public:
 
     void associateTerritories();
     bool validate() const;
+    /**
+     * @brief Hop distances between the territories, computed on first use.
+     *
+     * Copies of the map share the table, so it is computed once for every game on the same map.
+     * Safe to call from several threads.
+     */
+    const DistanceTable& getDistances() const;
+    const NameTable& getNames() const;
+    /**
+     * @brief Whether validate found the map valid, without validating it again.
+     */
+    bool isValidated() const;
+    /**
+     * @brief Owners and armies of the territories by index, for evaluations of the whole board.
+     *
+     * Laid out on first use, then safe to read from several threads while no territory changes.
+     */
+    const Board& getBoard() const;
+    /**
+     * @brief Zobrist hash of who owns each territory and with how many armies, in O(1)
+     */
+    std::uint64_t getHash() const;
+    /**
+     * @brief The same hash computed from scratch, in O(n)
+     */
+    std::uint64_t computeHash() const;
+    /**
+     * @brief Number of times a territory changed owner, to tell whether anything was conquered since a previous call
+     */
+    std::uint64_t getOwnerChanges() const;
+    /**
+     * @brief Bytes taken from the heap for the territories and continents, in as many blocks as getArenaBlocks
+     */
+    std::size_t getArenaBytes() const;
+    std::size_t getArenaBlocks() const;
 
     friend std::ostream& operator<<(std::ostream& out, const Map& map);
 };
@@ -197,6 +341,18 @@ public:
      */
     Map* parse();
 
+    /**
+     * @brief Load the map file at the given path.
+     *
+     * Compiled `.wzmap` files are memory-mapped,
+     * anything else is parsed as a text map.
+     */
+    static Map* load(const std::string& path);
+    /**
+     * @brief Load a map from a file already mapped in memory, a text map is parsed in place.
+     */
+    static Map* load(const MappedFile& file);
+
     friend std::ostream& operator<<(std::ostream& out, const MapLoader& mapLoader);
 
 private:
@@ -0,0 +1,161 @@
+#include "MapCache.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <regex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+MapCache& MapCache::instance() {
+    static MapCache cache;
+    return cache;
+}
+
+MapCache::MapCache()
+    : hits(0)
+    , misses(0) { }
+
+std::uint64_t MapCache::hash(const char* data, std::size_t size) {
+    std::uint64_t result = 14695981039346656037ull;
+    for (std::size_t i = 0; i < size; i++) {
+        result ^= static_cast<unsigned char>(data[i]);
+        result *= 1099511628211ull;
+    }
+    return result;
+}
+
+std::shared_ptr<const Map> MapCache::get(const std::string& path) {
+    std::error_code error;
+    auto modifiedTime = std::filesystem::last_write_time(path, error);
+    std::int64_t modified = error ? 0 : static_cast<std::int64_t>(modifiedTime.time_since_epoch().count());
+    std::uintmax_t size = std::filesystem::file_size(path, error);
+    if (error) {
+        size = 0;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        auto it = this->entries.find(path);
+        if (it != this->entries.end() && it->second.modified == modified && it->second.size == size) {
+            this->hits++;
+            return it->second.map;
+        }
+    }
+
+    // The file is new or was touched, check whether its contents actually changed
+    // and keep it mapped to parse it from memory if it did
+    std::uint64_t contentHash = 0;
+    std::unique_ptr<MappedFile> file;
+    if (size > 0) {
+        file = std::make_unique<MappedFile>(path);
+        contentHash = hash(file->data(), file->size());
+    }
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        std::shared_ptr<const Map> known;
+        auto it = this->entries.find(path);
+        if (it != this->entries.end() && it->second.hash == contentHash) {
+            known = it->second.map;
+        } else {
+            auto same = this->byHash.find(contentHash);
+            if (same != this->byHash.end()) {
+                known = same->second.lock();
+            }
+        }
+        if (known) {
+            this->hits++;
+            this->entries[path] = Entry { modified, size, contentHash, known };
+            return known;
+        }
+        this->misses++;
+    }
+
+    // Parse and validate outside of the lock, the map is immutable from now on
+    std::shared_ptr<Map> map(file ? MapLoader::load(*file) : MapLoader::load(path));
+    map->validate();
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->entries[path] = Entry { modified, size, contentHash, map };
+    this->byHash[contentHash] = map;
+    return map;
+}
+
+Map* MapCache::load(const std::string& path) {
+    std::shared_ptr<const Map> map = this->get(path);
+    if (!map->isValidated()) {
+        throw std::invalid_argument("Map " + path + " is not valid");
+    }
+    return new Map(*map);
+}
+
+std::size_t MapCache::preload(const std::vector<std::string>& paths) {
+    ThreadPool pool;
+    std::vector<std::future<void>> results;
+    results.reserve(paths.size());
+    for (const auto& path : paths) {
+        results.push_back(pool.submit([this, path]() { this->get(path); }));
+    }
+
+    std::size_t loaded = 0;
+    for (std::size_t i = 0; i < results.size(); i++) {
+        try {
+            results[i].get();
+            loaded++;
+        } catch (std::exception& e) {
+            std::cerr << "Could not preload " << paths[i] << ": " << e.what() << std::endl;
+        }
+    }
+    return loaded;
+}
+
+std::size_t MapCache::preloadList(const std::string& listPath) {
+    std::ifstream list(listPath);
+    if (!list.is_open()) {
+        throw std::runtime_error("Cannot open " + listPath);
+    }
+    std::vector<std::string> paths;
+    for (std::string line; std::getline(list, line);) {
+        line = std::regex_replace(line, TRIM_WHITESPACE, "");
+        if (line.empty()) {
+            continue;
+        }
+        if (!std::filesystem::exists(line)) {
+            std::cerr << "File " << line << " not found" << std::endl;
+            continue;
+        }
+        paths.push_back(line);
+    }
+    return this->preload(paths);
+}
+
+std::uint64_t MapCache::getHash(const std::string& path) const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    auto it = this->entries.find(path);
+    return it == this->entries.end() ? 0 : it->second.hash;
+}
+
+void MapCache::clear() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->entries.clear();
+    this->byHash.clear();
+}
+
+std::size_t MapCache::size() const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->entries.size();
+}
+
+std::ostream& operator<<(std::ostream& out, const MapCache& cache) {
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    return out
+        << "This MapCache holds " << cache.entries.size()
+        << " maps after " << cache.hits << " hits and "
+        << cache.misses << " misses.";
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "Map.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class MapCache
+ *
+ * @brief Process-wide cache of parsed and validated maps.
+ *
+ * Maps are kept as immutable prototypes keyed by path. A cached map is reused as long as
+ * the file's modification time and size are unchanged, or its contents hash to the same value.
+ * Games get their own copy of the prototype, so they never pay parsing or validation again.
+ * Maps that do not validate are cached too, so an index can report them, but no game gets a copy.
+ */
+class MapCache {
+public:
+    /**
+     * @brief The cache shared by the whole process.
+     */
+    static MapCache& instance();
+
+    MapCache();
+    MapCache(const MapCache& other) = delete;
+    MapCache& operator=(const MapCache& other) = delete;
+
+    /**
+     * @brief Get the immutable map for the file at the given path, parsing and validating it on first use.
+     *
+     * The map may not be valid, see Map::isValidated.
+     * @throws ParsingException or std::runtime_error if the file cannot be parsed.
+     */
+    std::shared_ptr<const Map> get(const std::string& path);
+
+    /**
+     * @brief Get a new copy of the map for the file at the given path, owned by the caller.
+     *
+     * @throws std::invalid_argument if the map does not validate.
+     */
+    Map* load(const std::string& path);
+
+    /**
+     * @brief Parse and validate the given files concurrently.
+     *
+     * @return Number of files that could be loaded.
+     */
+    std::size_t preload(const std::vector<std::string>& paths);
+
+    /**
+     * @brief Preload every file listed in a text file, one path per line (like `res/map/files.txt`).
+     */
+    std::size_t preloadList(const std::string& listPath);
+
+    void clear();
+    std::size_t size() const;
+    /**
+     * @brief Hash of the contents the map cached for the path was parsed from, 0 if none is cached.
+     */
+    std::uint64_t getHash(const std::string& path) const;
+
+    /**
+     * @brief 64-bit FNV-1a hash of a byte range.
+     */
+    static std::uint64_t hash(const char* data, std::size_t size);
+
+    friend std::ostream& operator<<(std::ostream& out, const MapCache& cache);
+
+private:
+    /**
+     * @brief Cached map along with what identifies the file it came from.
+     */
+    struct Entry {
+        std::int64_t modified;
+        std::uintmax_t size;
+        std::uint64_t hash;
+        std::shared_ptr<const Map> map;
+    };
+
+    mutable std::mutex mutex;
+    /** @brief Entries by path. */
+    std::unordered_map<std::string, Entry> entries;
+    /** @brief Maps by content hash, so identical files share a prototype. */
+    std::unordered_map<std::uint64_t, std::weak_ptr<const Map>> byHash;
+    std::size_t hits;
+    std::size_t misses;
+};
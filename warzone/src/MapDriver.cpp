@@ -1,8 +1,28 @@
+#include "BinaryMap.h"
+#include "DistanceTable.h"
 #include "Map.h"
+#include "MapCache.h"
+#include "MapGenerator.h"
+#include "MapIndex.h"
+#include "MappedFile.h"
+#include "Player.h"
+#include "PlayerStrategies.h"
+#include "Profiler.h"
 
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <regex>
+#include <sstream>
+#include <stdexcept>
+
+// Path of a file written by a test, unique to the run and out of the map directories, so a failed test leaves nothing to scan
+static std::string scratchPath(const std::string& name) {
+    auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+    return (std::filesystem::temp_directory_path() / ("warzone-" + std::to_string(now) + "-" + name)).string();
+}
 
 void testLoadMaps() {
     std::ifstream files("./res/map/files.txt");
@@ -27,3 +47,338 @@ void testLoadMaps() {
         }
     }
 }
+
+void testGeneratedMaps() {
+    MapGenerator::Topology topologies[] = {
+        MapGenerator::Topology::Grid,
+        MapGenerator::Topology::Planar,
+        MapGenerator::Topology::SmallWorld,
+    };
+    for (auto topology : topologies) {
+        MapGenerator::Options options;
+        options.territories = 200;
+        options.continents = 7;
+        options.averageDegree = 5;
+        options.topology = topology;
+        MapGenerator generator(options);
+        std::cout << generator << std::endl;
+
+        std::stringstream stream;
+        generator.write(stream);
+        Map* obj = nullptr;
+        try {
+            obj = MapLoader(stream).parse();
+        } catch (ParsingException& e) {
+            std::cout << e.inStream(stream) << std::endl;
+            continue;
+        }
+        std::cout << *obj << std::endl;
+        if (!obj->validate()) {
+            std::cout << "Generated map is invalid!" << std::endl;
+        }
+        delete obj;
+    }
+}
+
+void testCompiledMaps() {
+    std::ifstream file("./res/map/lp.map");
+    Map* text = MapLoader(file).parse();
+
+    std::string path = scratchPath("lp.wzmap");
+    {
+        std::ofstream output(path, std::ios::binary);
+        MapCompiler compiler(*text);
+        std::cout << compiler << std::endl;
+        compiler.write(output);
+    }
+
+    std::cout << "Compiled map is binary: " << BinaryMapLoader::isBinary(path) << std::endl
+              << "Text map is binary: " << BinaryMapLoader::isBinary("./res/map/lp.map") << std::endl;
+
+    BinaryMapLoader loader(path);
+    std::cout << loader << std::endl;
+    Map* compiled = loader.parse();
+    std::cout << "Text map: " << *text << std::endl
+              << "Compiled map: " << *compiled << std::endl;
+    compiled->findTerritory("1L")->prettyPrint();
+    std::cout << "Compiled map is valid: " << compiled->validate() << std::endl;
+
+    delete text;
+    delete compiled;
+    std::remove(path.c_str());
+}
+
+void testMapCache() {
+    MapCache& cache = MapCache::instance();
+    std::cout << "Preloaded " << cache.preloadList("./res/map/files.txt") << " maps" << std::endl
+              << cache << std::endl;
+
+    Map* first = cache.load("./res/map/lp.map");
+    Map* second = cache.load("./res/map/lp.map");
+    std::cout << cache << std::endl
+              << "Both games share the same prototype: " << (cache.get("./res/map/lp.map") == cache.get("./res/map/lp.map")) << std::endl
+              << "Each game has its own copy: " << (first != second && first->findTerritory("1L") != second->findTerritory("1L")) << std::endl;
+
+    // The copies must keep their adjacency, pointing into their own map
+    Territory* territory = second->findTerritory("1L");
+    territory->prettyPrint();
+    std::cout << "Adjacent territory belongs to the copy: " << (territory->getAdjacent()[0] == second->findTerritory("2L")) << std::endl
+              << "Copy is valid without validating again: " << second->validate() << std::endl;
+
+    // A map that does not validate is cached but never handed to a game
+    bool refused = false;
+    try {
+        delete cache.load("./res/map/asia-1200.map");
+    } catch (std::invalid_argument& e) {
+        refused = true;
+        std::cout << e.what() << std::endl;
+    }
+    std::cout << "Invalid map is cached: " << !cache.get("./res/map/asia-1200.map")->isValidated() << ", and not loaded: " << refused << std::endl;
+
+    delete first;
+    delete second;
+}
+
+void testDistances() {
+    MapCache& cache = MapCache::instance();
+    std::shared_ptr<const Map> map = cache.get("./res/map/King of the Hills.map");
+    const DistanceTable& matrix = map->getDistances();
+    std::cout << matrix << std::endl;
+
+    // The landmark version must find the same distances, only slower
+    DistanceTable landmarks(*map, 0);
+    std::cout << landmarks << std::endl;
+    bool same = true;
+    std::size_t n = matrix.size();
+    for (std::size_t i = 0; i < n; i += 97) {
+        for (std::size_t j = 0; j < n; j += 13) {
+            if (matrix.distance(i, j) != landmarks.distance(i, j) || landmarks.path(i, j).size() != matrix.path(i, j).size()) {
+                same = false;
+            }
+        }
+    }
+    std::cout << "Landmarks find the same distances as the matrix: " << same << std::endl;
+
+    // Games share the table of the map they were copied from
+    Map* game = cache.load("./res/map/King of the Hills.map");
+    std::cout << "Copies share the table: " << (&game->getDistances() == &matrix) << std::endl;
+
+    Territory* from = game->findTerritoryByIndex(0);
+    Territory* to = game->findTerritoryByIndex(n - 1);
+    std::cout << "Path from " << from->getName() << " to " << to->getName() << ":";
+    for (auto t : matrix.path(from->getIndex(), to->getIndex())) {
+        std::cout << " " << game->findTerritoryByIndex(t)->getName();
+    }
+    std::cout << std::endl;
+    Territory* next = matrix.nextHop(from, to);
+    std::cout << "First move goes to " << next->getName() << ", adjacent and belonging to the copy: "
+              << (next == game->findTerritory(next->getName())) << std::endl;
+
+    delete game;
+}
+
+void testNames() {
+    std::ifstream file("./res/map/lp.map");
+    Map* map = MapLoader(file).parse();
+    std::cout << map->getNames() << std::endl;
+
+    // Territories and continents refer to names by id, the characters are only looked up to display them
+    Territory* territory = map->findTerritory("1L");
+    std::cout << "Found " << territory->getName() << " with id " << territory->getNameId()
+              << " on " << territory->getContinent() << " with id " << territory->getContinentId() << std::endl
+              << "Same territory by id: " << (map->findTerritory(territory->getNameId()) == territory) << std::endl
+              << "Unknown name: " << (map->findTerritory("Atlantis") == nullptr) << std::endl;
+
+    // Copies share the names of the map they come from
+    Map* copy = new Map(*map);
+    std::cout << "Copy finds its own territory: " << (copy->findTerritory("1L") != territory && copy->findTerritory("1L")->getNameId() == territory->getNameId()) << std::endl
+              << "Copy shares the names: " << (&copy->getNames() == &map->getNames()) << std::endl;
+
+    delete copy;
+    delete map;
+}
+
+void testBoard() {
+    Map* map = MapCache::instance().load("./res/map/King of the Hills.map");
+    std::vector<Player*> players;
+    players.push_back(new Player("Ann", NeutralPlayer(map, nullptr, &players)));
+    players.push_back(new Player("Bob", NeutralPlayer(map, nullptr, &players)));
+    players.push_back(new Player("Cid", NeutralPlayer(map, nullptr, &players)));
+    std::size_t n = map->getNumberTerritories();
+    for (std::size_t i = 0; i < n; i++) {
+        Territory* t = map->findTerritoryByIndex(i);
+        t->setOwner(i % 5 == 0 ? nullptr : players[i % players.size()]);
+        t->setArmies(static_cast<int>(i % 7) + 1);
+    }
+    const Board& board = map->getBoard();
+    std::cout << board << std::endl;
+
+    // The kernels must agree with the territories, territory by territory
+    bool same = true;
+    for (Player* p : players) {
+        std::int64_t armies = 0;
+        std::size_t territories = 0;
+        std::int64_t threatened = 0;
+        std::vector<std::int64_t> threats = board.threats(p);
+        for (std::size_t i = 0; i < n; i++) {
+            Territory* t = map->findTerritoryByIndex(i);
+            std::int64_t threat = 0;
+            if (t->getOwner() == p) {
+                armies += t->getArmies();
+                territories++;
+                for (auto a : t->getAdjacent()) {
+                    threat += a->getOwner() && a->getOwner() != p ? a->getArmies() : 0;
+                }
+            }
+            same = same && threats[i] == threat;
+            threatened += threat;
+        }
+        same = same && board.armiesOf(p) == armies && board.territoriesOf(p) == territories && board.threatenedArmies(p) == threatened;
+    }
+    std::cout << "Kernels agree with the territories: " << same << std::endl
+              << "No one owns the whole board: " << (board.soleOwner() == nullptr) << std::endl;
+
+    // Taking a whole continent earns its armies, losing one of its territories loses them
+    Territory* first = map->findTerritoryByIndex(0);
+    for (std::size_t i = 0; i < n; i++) {
+        Territory* t = map->findTerritoryByIndex(i);
+        if (t->getContinentId() == first->getContinentId()) {
+            t->setOwner(players[0]);
+        }
+    }
+    int rewards = board.continentRewards(players[0]);
+    first->setOwner(players[1]);
+    std::cout << "Whole continent awards armies: " << (rewards > 0 && board.continentRewards(players[0]) < rewards) << std::endl;
+
+    for (std::size_t i = 0; i < n; i++) {
+        map->findTerritoryByIndex(i)->setOwner(players[2]);
+    }
+    std::cout << "Cid owns the whole board: " << (board.soleOwner() == players[2] && board.territoriesOf(players[2]) == n) << std::endl;
+
+    // A copy has its own board, matching its own territories
+    Map* copy = new Map(*map);
+    copy->findTerritoryByIndex(0)->setArmies(1000);
+    std::cout << "Copy has its own armies: " << (copy->getBoard().getArmies(0) == 1000 && board.getArmies(0) != 1000
+                                                    && copy->getBoard().armiesOf(players[2]) == board.armiesOf(players[2]) + 1000 - board.getArmies(0))
+              << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+    std::int64_t total = 0;
+    for (int round = 0; round < 1000; round++) {
+        for (Player* p : players) {
+            total += board.armiesOf(p) + static_cast<std::int64_t>(board.territoriesOf(p)) + board.continentRewards(p);
+        }
+    }
+    std::cout << "1000 evaluations of " << n << " territories for 3 players in "
+              << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms (" << total << ")" << std::endl;
+
+    delete copy;
+    for (std::size_t i = 0; i < n; i++) {
+        map->findTerritoryByIndex(i)->setOwner(nullptr);
+    }
+    for (Player* p : players) {
+        delete p;
+    }
+    delete map;
+}
+
+void testMapIndex() {
+    // A cache of its own, so the first build parses every map
+    MapCache cache;
+    MapIndex index = MapIndex::build("./res/map", 4, cache);
+    std::cout << index << std::endl
+              << cache << std::endl;
+    for (const auto& entry : index.getEntries()) {
+        std::cout << "  " << entry.path << ": " << entry.territories << " territories, " << entry.continents << " continents, "
+                  << (entry.valid ? "valid" : "invalid") << std::endl;
+    }
+
+    // The hashes are those of the files, the counts those of the maps
+    bool same = !index.getEntries().empty();
+    for (const auto& entry : index.getEntries()) {
+        MappedFile file(entry.path);
+        std::shared_ptr<const Map> map = cache.get(entry.path);
+        same = same && entry.error.empty() && entry.hash == MapCache::hash(file.data(), file.size())
+            && entry.territories == map->getNumberTerritories() && entry.continents == map->getNumberContinents();
+    }
+    std::cout << "Index matches the files and their maps: " << same << std::endl;
+
+    MapIndex again = MapIndex::build("./res/map", 4, cache);
+    std::cout << "Second build only hits the cache: " << (again.getEntries() == index.getEntries()) << " " << cache << std::endl;
+
+    std::stringstream stream;
+    index.write(stream);
+    std::cout << "Index reads back the same: " << (MapIndex::read(stream).getEntries() == index.getEntries()) << std::endl
+              << "Paths with spaces are found: " << (index.find("./res/map/Flower Z.map") != nullptr) << std::endl;
+
+    // A broken map is indexed as invalid, and its error quotes the line from the mapped file
+    std::string directory = scratchPath("index");
+    std::filesystem::create_directory(directory);
+    {
+        std::ofstream broken(directory + "/broken.map");
+        broken << "[Continents]\nNorth=5\n[Territories]\nA,0,0,North,B\nB,0,0\n";
+    }
+    MapIndex invalid = MapIndex::build(directory, 1, cache);
+    std::cout << invalid << std::endl
+              << "Broken map is invalid: " << (invalid.getEntries().size() == 1 && !invalid.getEntries()[0].valid) << " ("
+              << invalid.getEntries()[0].error << ")" << std::endl;
+    {
+        MappedFile file(directory + "/broken.map");
+        MemoryBuffer buffer(file.data(), file.size());
+        std::istream mapped(&buffer);
+        try {
+            delete MapLoader(mapped).parse();
+        } catch (ParsingException& e) {
+            std::cout << e.inStream(mapped) << std::endl;
+        }
+    }
+    std::filesystem::remove_all(directory);
+}
+
+void testMapArena() {
+    MapCache& cache = MapCache::instance();
+    std::shared_ptr<const Map> small = cache.get("./res/map/lp.map");
+    std::shared_ptr<const Map> large = cache.get("./res/map/King of the Hills.map");
+    std::cout << "Parsed " << large->getNumberTerritories() << " territories into " << large->getArenaBlocks() << " blocks of "
+              << large->getArenaBytes() << " bytes" << std::endl;
+
+    // Copying a map costs the same handful of allocations whatever its size, its arena being one of them
+    Profiler& profiler = Profiler::instance();
+    profiler.enable("arena", false);
+    std::uint64_t before = profiler.get(Profiler::Counter::Allocations);
+    Map* smallCopy = new Map(*small);
+    std::uint64_t smallAllocations = profiler.get(Profiler::Counter::Allocations) - before;
+    before = profiler.get(Profiler::Counter::Allocations);
+    Map* largeCopy = new Map(*large);
+    std::uint64_t largeAllocations = profiler.get(Profiler::Counter::Allocations) - before;
+    profiler.disable();
+    profiler.reset();
+    std::cout << "Copying " << small->getNumberTerritories() << " territories took " << smallAllocations << " allocations, "
+              << large->getNumberTerritories() << " territories " << largeAllocations << std::endl
+              << "Allocations do not grow with the map: " << (smallAllocations == largeAllocations) << std::endl
+              << "Each copy is one block, freed at once: " << (smallCopy->getArenaBlocks() == 1 && largeCopy->getArenaBlocks() == 1) << std::endl;
+
+    // The copy in the arena is linked to itself and still valid
+    Territory* territory = largeCopy->findTerritoryByIndex(0);
+    Territory* adjacent = territory->getAdjacent()[0];
+    std::cout << "Adjacent territory belongs to the copy: " << (adjacent == largeCopy->findTerritory(adjacent->getName())) << std::endl
+              << "Copy is valid: " << largeCopy->validate() << std::endl;
+    delete smallCopy;
+
+    // A compiled map knows its size up front, so it is made in one block too
+    std::string path = scratchPath("arena.wzmap");
+    {
+        std::ofstream output(path, std::ios::binary);
+        MapCompiler(*largeCopy).write(output);
+    }
+    Map* compiled = MapLoader::load(path);
+    std::cout << "Compiled map is one block: " << (compiled->getArenaBlocks() == 1) << std::endl;
+    delete compiled;
+    delete largeCopy;
+    std::remove(path.c_str());
+
+    // Moving a continent takes its territories along
+    Continent continent(3, "Moved", std::pmr::vector<Territory*>(large->getNumberTerritories(), nullptr));
+    Continent moved(std::move(continent));
+    std::cout << moved << std::endl;
+}
@@ -3,3 +3,11 @@
 #include "Map.h"
 
 void testLoadMaps();
+void testGeneratedMaps();
+void testCompiledMaps();
+void testMapCache();
+void testDistances();
+void testNames();
+void testBoard();
+void testMapIndex();
+void testMapArena();
@@ -0,0 +1,243 @@
+#include "MapGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+MapGenerator::MapGenerator(const Options& options)
+    : options(options) {
+    if (options.territories < 2) {
+        throw std::invalid_argument("A map needs at least 2 territories");
+    }
+    if (options.territories > UINT32_MAX / 2) {
+        throw std::invalid_argument("Too many territories");
+    }
+    if (options.continents < 1 || options.continents > options.territories) {
+        throw std::invalid_argument("Number of continents must be between 1 and the number of territories");
+    }
+    if (!(options.averageDegree > 0)) {
+        throw std::invalid_argument("Average degree must be positive");
+    }
+}
+
+MapGenerator::Topology MapGenerator::parseTopology(const std::string& name) {
+    if (name == "grid") {
+        return Topology::Grid;
+    }
+    if (name == "planar") {
+        return Topology::Planar;
+    }
+    if (name == "smallworld") {
+        return Topology::SmallWorld;
+    }
+    throw std::invalid_argument("Unknown topology " + name);
+}
+
+// Width and height of the smallest near-square grid holding n cells
+static std::pair<std::size_t, std::size_t> gridSize(std::size_t n) {
+    std::size_t width = static_cast<std::size_t>(std::ceil(std::sqrt(static_cast<double>(n))));
+    std::size_t height = (n + width - 1) / width;
+    return { width, height };
+}
+
+// Grid territories are numbered row by row. Every row is a path and the rows are linked
+// through the first column, so the map stays connected whatever edges get dropped.
+void MapGenerator::generateGrid() {
+    std::size_t n = options.territories;
+    auto [width, height] = gridSize(n);
+    std::mt19937 rng(options.seed);
+
+    // A full 4-neighbourhood averages 4 adjacent territories, the spanning comb about 2
+    double degree = options.averageDegree;
+    std::bernoulli_distribution keepVertical(std::clamp((degree - 2.0) / 2.0, 0.0, 1.0));
+    std::bernoulli_distribution keepDiagonal(std::clamp((degree - 4.0) / 4.0, 0.0, 1.0));
+
+    for (std::size_t i = 0; i < n; i++) {
+        std::size_t x = i % width;
+        std::size_t y = i / width;
+        coordinates.emplace_back(static_cast<int>(x * 10), static_cast<int>(y * 10));
+
+        std::uint32_t self = static_cast<std::uint32_t>(i);
+        if (x + 1 < width && i + 1 < n) {
+            edges.emplace_back(self, self + 1);
+        }
+        std::size_t below = i + width;
+        if (below < n && (x == 0 || keepVertical(rng))) {
+            edges.emplace_back(self, static_cast<std::uint32_t>(below));
+        }
+        if (below + 1 < n && x + 1 < width && keepDiagonal(rng)) {
+            edges.emplace_back(self, static_cast<std::uint32_t>(below + 1));
+        }
+        if (below - 1 < n && x > 0 && keepDiagonal(rng)) {
+            edges.emplace_back(self, static_cast<std::uint32_t>(below - 1));
+        }
+    }
+}
+
+// Jittered points on a grid where every cell is split by one random diagonal, which is a
+// planar triangulation. Edges outside of the spanning comb are then dropped at random.
+void MapGenerator::generatePlanar() {
+    std::size_t n = options.territories;
+    auto [width, height] = gridSize(n);
+    std::mt19937 rng(options.seed);
+    std::uniform_int_distribution<int> jitter(0, 7);
+    std::bernoulli_distribution flip(0.5);
+
+    // A triangulation averages 6 adjacent territories, the spanning comb about 2
+    std::bernoulli_distribution keep(std::clamp((options.averageDegree - 2.0) / 4.0, 0.0, 1.0));
+
+    for (std::size_t i = 0; i < n; i++) {
+        std::size_t x = i % width;
+        std::size_t y = i / width;
+        coordinates.emplace_back(static_cast<int>(x * 10) + jitter(rng), static_cast<int>(y * 10) + jitter(rng));
+
+        std::uint32_t self = static_cast<std::uint32_t>(i);
+        if (x + 1 < width && i + 1 < n) {
+            edges.emplace_back(self, self + 1);
+        }
+        std::size_t below = i + width;
+        if (below < n && (x == 0 || keep(rng))) {
+            edges.emplace_back(self, static_cast<std::uint32_t>(below));
+        }
+        if (x + 1 < width && below + 1 < n) {
+            bool diagonal = keep(rng);
+            if (flip(rng)) {
+                if (diagonal) {
+                    edges.emplace_back(self, static_cast<std::uint32_t>(below + 1));
+                }
+            } else if (diagonal) {
+                edges.emplace_back(self + 1, static_cast<std::uint32_t>(below));
+            }
+        }
+    }
+}
+
+// Ring lattice where each territory is linked to its k closest neighbours on each side.
+// All but the closest link get rewired to a random territory with a small probability.
+void MapGenerator::generateSmallWorld() {
+    std::size_t n = options.territories;
+    std::mt19937 rng(options.seed);
+    std::bernoulli_distribution rewire(0.1);
+    std::uniform_int_distribution<std::uint32_t> anyTerritory(0, static_cast<std::uint32_t>(n - 1));
+
+    std::size_t k = std::max<std::size_t>(1, static_cast<std::size_t>(std::lround(options.averageDegree / 2.0)));
+    k = std::min(k, (n - 1) / 2 + 1);
+
+    const double pi = std::acos(-1.0);
+    double radius = static_cast<double>(n) * 2.0;
+    for (std::size_t i = 0; i < n; i++) {
+        double angle = 2.0 * pi * static_cast<double>(i) / static_cast<double>(n);
+        coordinates.emplace_back(
+            static_cast<int>(radius + radius * std::cos(angle)),
+            static_cast<int>(radius + radius * std::sin(angle))
+        );
+
+        std::uint32_t self = static_cast<std::uint32_t>(i);
+        for (std::size_t j = 1; j <= k; j++) {
+            std::uint32_t other = static_cast<std::uint32_t>((i + j) % n);
+            if (j > 1 && rewire(rng)) {
+                other = anyTerritory(rng);
+            }
+            if (other != self) {
+                edges.emplace_back(std::min(self, other), std::max(self, other));
+            }
+        }
+    }
+}
+
+void MapGenerator::write(std::ostream& out) {
+    edges.clear();
+    coordinates.clear();
+    coordinates.reserve(options.territories);
+
+    switch (options.topology) {
+    case Topology::Grid:
+        generateGrid();
+        break;
+    case Topology::Planar:
+        generatePlanar();
+        break;
+    case Topology::SmallWorld:
+        generateSmallWorld();
+        break;
+    }
+
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    // Compressed adjacency, every edge is listed on both of its territories
+    std::size_t n = options.territories;
+    std::vector<std::size_t> offsets(n + 1, 0);
+    for (const auto& [a, b] : edges) {
+        offsets[a + 1]++;
+        offsets[b + 1]++;
+    }
+    for (std::size_t i = 0; i < n; i++) {
+        offsets[i + 1] += offsets[i];
+    }
+    std::vector<std::uint32_t> adjacent(offsets[n]);
+    std::vector<std::size_t> fill(offsets.begin(), offsets.end() - 1);
+    for (const auto& [a, b] : edges) {
+        adjacent[fill[a]++] = b;
+        adjacent[fill[b]++] = a;
+    }
+    edges.clear();
+    edges.shrink_to_fit();
+
+    // Territories are numbered in a locality-preserving order, so consecutive ranges make compact continents
+    std::size_t nbContinents = options.continents;
+    auto continentOf = [n, nbContinents](std::size_t territory) {
+        return territory * nbContinents / n;
+    };
+
+    out << "[Map]\n"
+        << "author=MapGenerator\n"
+        << "image=none.bmp\n"
+        << "wrap=no\n"
+        << "scroll=none\n"
+        << "warn=no\n"
+        << "\n[Continents]\n";
+    for (std::size_t c = 0; c < nbContinents; c++) {
+        std::size_t first = (c * n + nbContinents - 1) / nbContinents;
+        std::size_t last = ((c + 1) * n + nbContinents - 1) / nbContinents;
+        out << 'C' << c << '=' << 1 + (last - first) / 4 << '\n';
+    }
+
+    out << "\n[Territories]\n";
+    std::string line;
+    for (std::size_t i = 0; i < n; i++) {
+        line.clear();
+        line += 'T';
+        line += std::to_string(i);
+        line += ',';
+        line += std::to_string(coordinates[i].first);
+        line += ',';
+        line += std::to_string(coordinates[i].second);
+        line += ",C";
+        line += std::to_string(continentOf(i));
+        for (std::size_t j = offsets[i]; j < offsets[i + 1]; j++) {
+            line += ",T";
+            line += std::to_string(adjacent[j]);
+        }
+        line += '\n';
+        out << line;
+    }
+    out.flush();
+}
+
+std::ostream& operator<<(std::ostream& out, const MapGenerator& generator) {
+    const char* topology = "grid";
+    if (generator.options.topology == MapGenerator::Topology::Planar) {
+        topology = "planar";
+    } else if (generator.options.topology == MapGenerator::Topology::SmallWorld) {
+        topology = "smallworld";
+    }
+    return out
+        << "This MapGenerator makes a " << topology
+        << " map of " << generator.options.territories
+        << " territories and " << generator.options.continents
+        << " continents with an average degree of " << generator.options.averageDegree;
+}
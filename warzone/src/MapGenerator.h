@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @class MapGenerator
+ *
+ * @brief Utility class for generating large synthetic `.map` files.
+ *
+ * The generated files use the same `[Map]`/`[Continents]`/`[Territories]`
+ * format as the bundled maps, so they can be loaded with MapLoader and
+ * pass Map::validate. They are meant as input for benchmarks and stress tests.
+ */
+class MapGenerator {
+public:
+    /**
+     * @brief Shape of the generated territory graph.
+     */
+    enum class Topology : char {
+        /** @brief Square grid, 4-neighbourhood with random diagonals. */
+        Grid,
+        /** @brief Triangulated jittered point set, thinned down to the requested degree. */
+        Planar,
+        /** @brief Watts-Strogatz ring lattice with random shortcuts. */
+        SmallWorld,
+    };
+
+    /**
+     * @brief Options for the generated map.
+     */
+    struct Options {
+        /** @brief Number of territories. */
+        std::size_t territories = 1000;
+        /** @brief Number of continents, at most the number of territories. */
+        std::size_t continents = 10;
+        /** @brief Target average number of adjacent territories. */
+        double averageDegree = 4.0;
+        /** @brief Shape of the graph. */
+        Topology topology = Topology::Grid;
+        /** @brief Seed of the random generator, same seed gives the same map. */
+        std::uint32_t seed = 1;
+    };
+
+    /**
+     * @brief Construct with the given options.
+     *
+     * @throws std::invalid_argument if the options cannot form a valid map.
+     */
+    MapGenerator(const Options& options);
+
+    /**
+     * @brief Generate the map and write it to the stream.
+     */
+    void write(std::ostream& out);
+
+    /**
+     * @brief Parse a topology name (`grid`, `planar` or `smallworld`).
+     *
+     * @throws std::invalid_argument if the name is unknown.
+     */
+    static Topology parseTopology(const std::string& name);
+
+    friend std::ostream& operator<<(std::ostream& out, const MapGenerator& generator);
+
+private:
+    Options options;
+
+    /** @brief Undirected edges, each stored once with `first < second`. */
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> edges;
+    /** @brief Coordinates of each territory, only used for display in the file. */
+    std::vector<std::pair<int, int>> coordinates;
+
+    void generateGrid();
+    void generatePlanar();
+    void generateSmallWorld();
+};
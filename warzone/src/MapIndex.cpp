@@ -0,0 +1,137 @@
+#include "MapIndex.h"
+#include "QuietConsole.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+
+bool MapIndex::Entry::operator==(const Entry& other) const {
+    return this->path == other.path && this->territories == other.territories && this->continents == other.continents
+        && this->valid == other.valid && this->hash == other.hash;
+}
+
+MapIndex MapIndex::build(const std::string& directory, std::size_t workers, MapCache& cache) {
+    namespace fs = std::filesystem;
+    std::error_code error;
+    std::vector<std::string> paths;
+    for (const auto& file : fs::directory_iterator(directory, error)) {
+        if (file.is_regular_file(error) && file.path().extension() == EXTENSION) {
+            paths.push_back(file.path().string());
+        }
+    }
+    if (error) {
+        throw std::invalid_argument("Cannot read the directory " + directory + ": " + error.message());
+    }
+    std::sort(paths.begin(), paths.end());
+
+    MapIndex index;
+    index.entries.resize(paths.size());
+    {
+        // The loader prints what it parses
+        QuietConsole quiet;
+        ThreadPool pool(std::max<std::size_t>(1, std::min(workers, paths.size())));
+        std::vector<std::future<void>> loading;
+        loading.reserve(paths.size());
+        for (std::size_t i = 0; i < paths.size(); i++) {
+            Entry* entry = &index.entries[i];
+            entry->path = paths[i];
+            loading.push_back(pool.submit([entry, &cache]() {
+                // get maps the file once, to hash it and to parse it, then validates the map
+                std::shared_ptr<const Map> map = cache.get(entry->path);
+                entry->territories = map->getNumberTerritories();
+                entry->continents = map->getNumberContinents();
+                entry->valid = map->isValidated();
+                entry->hash = cache.getHash(entry->path);
+            }));
+        }
+        for (std::size_t i = 0; i < loading.size(); i++) {
+            try {
+                loading[i].get();
+            } catch (std::exception& e) {
+                index.entries[i].error = e.what();
+            }
+        }
+    }
+    return index;
+}
+
+MapIndex MapIndex::read(std::istream& in) {
+    std::string header;
+    if (!std::getline(in, header) || header != HEADER) {
+        throw std::runtime_error("Not a map index, it does not start with " + HEADER);
+    }
+    MapIndex index;
+    for (std::string line; std::getline(in, line);) {
+        if (line.empty()) {
+            continue;
+        }
+        std::istringstream fields(line);
+        Entry entry;
+        int valid = 0;
+        fields >> std::hex >> entry.hash >> std::dec >> valid >> entry.territories >> entry.continents;
+        if (!fields || fields.get() != ' ') {
+            throw std::runtime_error("Malformed map index line: " + line);
+        }
+        entry.valid = valid != 0;
+        std::getline(fields, entry.path);
+        index.entries.push_back(entry);
+    }
+    return index;
+}
+
+MapIndex MapIndex::load(const std::string& path) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    return read(in);
+}
+
+void MapIndex::write(std::ostream& out) const {
+    out << HEADER << '\n';
+    for (const Entry& entry : this->entries) {
+        out << std::hex << std::setw(16) << std::setfill('0') << entry.hash << std::dec << std::setfill(' ') << ' '
+            << entry.valid << ' ' << entry.territories << ' ' << entry.continents << ' ' << entry.path << '\n';
+    }
+}
+
+void MapIndex::save(const std::string& path) const {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out.is_open()) {
+        throw std::runtime_error("Cannot open " + path + " for writing");
+    }
+    write(out);
+}
+
+const std::vector<MapIndex::Entry>& MapIndex::getEntries() const {
+    return this->entries;
+}
+
+std::vector<std::string> MapIndex::validPaths() const {
+    std::vector<std::string> paths;
+    for (const Entry& entry : this->entries) {
+        if (entry.valid) {
+            paths.push_back(entry.path);
+        }
+    }
+    return paths;
+}
+
+const MapIndex::Entry* MapIndex::find(const std::string& path) const {
+    auto it = std::find_if(this->entries.begin(), this->entries.end(), [&path](const Entry& entry) { return entry.path == path; });
+    return it == this->entries.end() ? nullptr : &*it;
+}
+
+std::ostream& operator<<(std::ostream& out, const MapIndex& index) {
+    std::size_t territories = 0;
+    for (const auto& entry : index.entries) {
+        territories += entry.territories;
+    }
+    return out << "This MapIndex holds " << index.entries.size() << " maps, " << index.validPaths().size() << " of them valid, with "
+               << territories << " territories in all.";
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "MapCache.h"
+#include "ThreadPool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @class MapIndex
+ *
+ * @brief Summary of every `.map` file in a directory: its territories, continents, validity and hash.
+ *
+ * Building the index memory-maps each file, parses and validates it on a thread pool through the
+ * MapCache, so the maps it found are ready for the games and tournaments that follow. The index
+ * itself is small enough to be saved and read back to pick maps without parsing them again.
+ *
+ * The saved format is a `wzindex 1` header, then one line per map with its hash in hexadecimal,
+ * whether it is valid, its territories, its continents and its path, last as it may hold spaces.
+ */
+class MapIndex {
+public:
+    /** @brief Extension of the files indexed. */
+    inline static const std::string EXTENSION = ".map";
+    /** @brief First line of a saved index. */
+    inline static const std::string HEADER = "wzindex 1";
+
+    /**
+     * @brief What the index knows of one map.
+     */
+    struct Entry {
+        std::string path;
+        std::size_t territories = 0;
+        std::size_t continents = 0;
+        bool valid = false;
+        /** @brief Hash of the file contents, see MapCache::hash. */
+        std::uint64_t hash = 0;
+        /** @brief Why the map could not be loaded, not saved. */
+        std::string error;
+
+        bool operator==(const Entry& other) const;
+    };
+
+    MapIndex() = default;
+
+    /**
+     * @brief Index every map of the directory, sorted by path, loading them on that many workers.
+     *
+     * Maps that fail to parse are indexed as invalid, with the reason in their error.
+     * @throws std::invalid_argument if the directory cannot be read.
+     */
+    static MapIndex build(const std::string& directory, std::size_t workers = ThreadPool::defaultSize(), MapCache& cache = MapCache::instance());
+
+    /**
+     * @throws std::runtime_error if the input is not an index.
+     */
+    static MapIndex read(std::istream& in);
+    static MapIndex load(const std::string& path);
+    void write(std::ostream& out) const;
+    void save(const std::string& path) const;
+
+    const std::vector<Entry>& getEntries() const;
+    /** @brief Paths of the valid maps, in the order of the index. */
+    std::vector<std::string> validPaths() const;
+    /** @brief The entry of the map at path, nullptr if it is not indexed. */
+    const Entry* find(const std::string& path) const;
+
+    friend std::ostream& operator<<(std::ostream& out, const MapIndex& index);
+
+private:
+    std::vector<Entry> entries;
+};
@@ -0,0 +1,109 @@
+#include "MappedFile.h"
+
+#include <fstream>
+#include <ios>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define WARZONE_HAS_MMAP 1
+#endif
+
+MappedFile::MappedFile(const std::string& path)
+    : path(path)
+    , bytes(nullptr)
+    , length(0)
+    , mapped(false) {
+#ifdef WARZONE_HAS_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Cannot read the size of " + path);
+    }
+    this->length = static_cast<std::size_t>(info.st_size);
+    if (this->length > 0) {
+        void* address = ::mmap(nullptr, this->length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address != MAP_FAILED) {
+            this->bytes = static_cast<const char*>(address);
+            this->mapped = true;
+        }
+    }
+    ::close(fd);
+    if (this->mapped || this->length == 0) {
+        return;
+    }
+#endif
+    // No mmap, read the whole file instead
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    this->length = static_cast<std::size_t>(file.tellg());
+    this->buffer.resize(this->length);
+    file.seekg(0);
+    if (!file.read(this->buffer.data(), static_cast<std::streamsize>(this->length))) {
+        throw std::runtime_error("Cannot read " + path);
+    }
+    this->bytes = this->buffer.data();
+}
+
+MappedFile::~MappedFile() {
+#ifdef WARZONE_HAS_MMAP
+    if (this->mapped) {
+        ::munmap(const_cast<char*>(this->bytes), this->length);
+    }
+#endif
+}
+
+MemoryBuffer::MemoryBuffer(const char* data, std::size_t size) {
+    // The get area is never written to, streambuf only wants it mutable
+    char* begin = const_cast<char*>(data);
+    this->setg(begin, begin, begin + size);
+}
+
+MemoryBuffer::pos_type MemoryBuffer::seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode which) {
+    if (!(which & std::ios_base::in)) {
+        return pos_type(off_type(-1));
+    }
+    off_type base = direction == std::ios_base::beg ? 0
+        : direction == std::ios_base::cur           ? this->gptr() - this->eback()
+                                                    : this->egptr() - this->eback();
+    off_type target = base + offset;
+    if (target < 0 || target > this->egptr() - this->eback()) {
+        return pos_type(off_type(-1));
+    }
+    this->setg(this->eback(), this->eback() + target, this->egptr());
+    return pos_type(target);
+}
+
+MemoryBuffer::pos_type MemoryBuffer::seekpos(pos_type position, std::ios_base::openmode which) {
+    return this->seekoff(off_type(position), std::ios_base::beg, which);
+}
+
+const char* MappedFile::data() const {
+    return this->bytes;
+}
+
+std::size_t MappedFile::size() const {
+    return this->length;
+}
+
+const std::string& MappedFile::getPath() const {
+    return this->path;
+}
+
+std::ostream& operator<<(std::ostream& out, const MappedFile& file) {
+    return out
+        << "This file " << file.path
+        << " holds " << file.length << " bytes"
+        << (file.mapped ? " mapped in memory." : " read in memory.");
+}
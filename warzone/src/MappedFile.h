@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <iosfwd>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+/**
+ * @class MappedFile
+ *
+ * @brief Read-only view of a whole file, memory-mapped when the platform allows it.
+ *
+ * On platforms without `mmap` the file is read into memory instead,
+ * so callers can always treat `data()` as the file contents.
+ */
+class MappedFile {
+public:
+    /**
+     * @brief Map the file at the given path.
+     *
+     * @throws std::runtime_error if the file cannot be opened or mapped.
+     */
+    MappedFile(const std::string& path);
+    MappedFile(const MappedFile& other) = delete;
+    ~MappedFile();
+
+    MappedFile& operator=(const MappedFile& other) = delete;
+
+    const char* data() const;
+    std::size_t size() const;
+    const std::string& getPath() const;
+
+    friend std::ostream& operator<<(std::ostream& out, const MappedFile& file);
+
+private:
+    /** @brief Path the file was opened from. */
+    std::string path;
+    /** @brief Start of the file contents. */
+    const char* bytes;
+    /** @brief Size of the file in bytes. */
+    std::size_t length;
+    /** @brief Whether `bytes` comes from `mmap` and must be unmapped. */
+    bool mapped;
+    /** @brief File contents when the file could not be mapped. */
+    std::vector<char> buffer;
+};
+
+/**
+ * @class MemoryBuffer
+ *
+ * @brief Stream buffer reading a range of bytes in place, so a mapped file is parsed without copying it.
+ */
+class MemoryBuffer : public std::streambuf {
+public:
+    MemoryBuffer(const char* data, std::size_t size);
+
+protected:
+    /** @brief Seeking is what lets a parsing error quote the line it happened on. */
+    pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode which) override;
+    pos_type seekpos(pos_type position, std::ios_base::openmode which) override;
+};
@@ -0,0 +1,110 @@
+#include "NameTable.h"
+
+#include <stdexcept>
+
+NameTable::NameTable()
+    : offsets { 0 }
+    , slots(16, 0) {
+}
+
+NameTable::NameTable(const NameTable& other) {
+    std::lock_guard<std::mutex> lock(other.mutex);
+    this->chars = other.chars;
+    this->offsets = other.offsets;
+    this->hashes = other.hashes;
+    this->slots = other.slots;
+}
+
+NameTable& NameTable::global() {
+    static NameTable table;
+    return table;
+}
+
+// 32-bit FNV-1a
+std::uint32_t NameTable::hash(std::string_view name) {
+    std::uint32_t hash = 2166136261u;
+    for (char c : name) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+std::string_view NameTable::view(std::uint32_t id) const {
+    return std::string_view(this->chars.data() + this->offsets[id], this->offsets[id + 1] - this->offsets[id]);
+}
+
+std::size_t NameTable::probe(std::string_view name, std::uint32_t hash) const {
+    std::size_t mask = this->slots.size() - 1;
+    for (std::size_t i = hash & mask;; i = (i + 1) & mask) {
+        std::uint32_t slot = this->slots[i];
+        if (slot == 0 || (this->hashes[slot - 1] == hash && view(slot - 1) == name)) {
+            return i;
+        }
+    }
+}
+
+// Keeps the table at most half full
+void NameTable::grow() {
+    std::vector<std::uint32_t> slots(this->slots.size() * 2, 0);
+    std::size_t mask = slots.size() - 1;
+    for (std::uint32_t id = 0; id < this->hashes.size(); id++) {
+        std::size_t i = this->hashes[id] & mask;
+        while (slots[i] != 0) {
+            i = (i + 1) & mask;
+        }
+        slots[i] = id + 1;
+    }
+    this->slots = std::move(slots);
+}
+
+std::uint32_t NameTable::intern(std::string_view name) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    std::uint32_t h = hash(name);
+    std::size_t i = probe(name, h);
+    if (this->slots[i] != 0) {
+        return this->slots[i] - 1;
+    }
+    if (this->chars.size() + name.size() > std::numeric_limits<std::uint32_t>::max() || this->hashes.size() + 1 >= NONE) {
+        throw std::length_error("Too many names");
+    }
+
+    std::uint32_t id = static_cast<std::uint32_t>(this->hashes.size());
+    this->chars.insert(this->chars.end(), name.begin(), name.end());
+    this->offsets.push_back(static_cast<std::uint32_t>(this->chars.size()));
+    this->hashes.push_back(h);
+    this->slots[i] = id + 1;
+    if (this->hashes.size() * 2 > this->slots.size()) {
+        grow();
+    }
+    return id;
+}
+
+std::uint32_t NameTable::find(std::string_view name) const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    std::uint32_t slot = this->slots[probe(name, hash(name))];
+    return slot == 0 ? NONE : slot - 1;
+}
+
+std::string NameTable::name(std::uint32_t id) const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (id >= this->hashes.size()) {
+        return "";
+    }
+    return std::string(view(id));
+}
+
+std::size_t NameTable::size() const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->hashes.size();
+}
+
+std::size_t NameTable::memory() const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->chars.capacity()
+        + (this->offsets.capacity() + this->hashes.capacity() + this->slots.capacity()) * sizeof(std::uint32_t);
+}
+
+std::ostream& operator<<(std::ostream& out, const NameTable& table) {
+    return out << "This NameTable holds " << table.size() << " names in " << table.memory() << " bytes.";
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @class NameTable
+ *
+ * @brief Interned names, each identified by a dense integer id.
+ *
+ * The characters of every name are kept back to back in one buffer, and an open-addressing
+ * hash table maps a name to its id. Territories and continents only keep the ids, so the
+ * engine compares integers and only looks the characters up to display them.
+ *
+ * Every map has its own table, shared by its copies. Names created outside of a map go to
+ * the global table. Tables are safe to use from several threads.
+ */
+class NameTable {
+public:
+    /** @brief Id of a name that is not in the table. */
+    static constexpr std::uint32_t NONE = std::numeric_limits<std::uint32_t>::max();
+
+    NameTable();
+    NameTable(const NameTable& other);
+    NameTable& operator=(const NameTable& other) = delete;
+
+    /**
+     * @brief Table for the names that do not belong to a map.
+     */
+    static NameTable& global();
+
+    /**
+     * @brief Id of the name, adding it if it is not in the table yet.
+     */
+    std::uint32_t intern(std::string_view name);
+    /**
+     * @brief Id of the name, or NONE.
+     */
+    std::uint32_t find(std::string_view name) const;
+    /**
+     * @brief Name with the given id.
+     */
+    std::string name(std::uint32_t id) const;
+
+    std::size_t size() const;
+    /**
+     * @brief Bytes used by the table.
+     */
+    std::size_t memory() const;
+
+    friend std::ostream& operator<<(std::ostream& out, const NameTable& table);
+
+private:
+    mutable std::mutex mutex;
+    /** @brief Characters of all the names, name `i` is `chars[offsets[i]..offsets[i + 1]]`. */
+    std::vector<char> chars;
+    std::vector<std::uint32_t> offsets;
+    /** @brief Hash of each name, so growing never reads the characters again. */
+    std::vector<std::uint32_t> hashes;
+    /** @brief Open-addressing slots holding `id + 1`, 0 when empty. Always a power of two long. */
+    std::vector<std::uint32_t> slots;
+
+    static std::uint32_t hash(std::string_view name);
+    std::string_view view(std::uint32_t id) const;
+    /** @brief Slot holding the name, or the empty slot where it would go. */
+    std::size_t probe(std::string_view name, std::uint32_t hash) const;
+    void grow();
+};
@@ -1,6 +1,7 @@
 #include "Orders.h"
 #include "LoggingObserver.h"
 #include "Player.h"
+#include "Profiler.h"
 #include <sstream>
 
 /// @brief Base class for orders
@@ -34,7 +35,7 @@ Order& Order::operator=(const Order& other) {
 }
 
 void Order::attach(Observer* observer) {
-    this->attach(observer);
+    Subject::attach(observer);
 }
 
 std::string Order::stringToLog() const {
@@ -43,6 +44,10 @@ std::string Order::stringToLog() const {
     return ss.str();
 }
 
+const std::string& Order::getName() const {
+    return this->orderName;
+}
+
 // Override for printing out Order objects
 std::ostream& operator<<(std::ostream& out, const Order& order) {
     out << "\t- Type: " << order.orderName << std::endl;
@@ -95,7 +100,7 @@ void DeployOrder::execute() {
         target->setArmies(amount + target->getArmies());
         player->removeArmiesFromPool(amount);
         std::cout << "Deploy executed!" << std::endl;
-        notify(this);
+        notify(Event::Kind::OrderExecuted, this);
     }
 }
 
@@ -182,7 +187,7 @@ void AdvanceOrder::execute() {
             simulateAttack(player, source, target, amount);
         }
         std::cout << "Advance order executed!" << std::endl;
-        notify(this);
+        notify(Event::Kind::OrderExecuted, this);
     }
 }
 
@@ -194,9 +199,13 @@ void AdvanceOrder::execute() {
 void AdvanceOrder::simulateAttack(Player* sPlayer, Territory* sSource, Territory* sTarget, int sAmount) {
     int successfulAttacks = 0;
     int successfulDefends = 0;
-    std::mt19937 rng(std::random_device {}());
+    // The attacker's generator rolls for both sides, so a game replays from its seed
+    std::mt19937& rng = sPlayer->getRandom();
     std::uniform_int_distribution<std::mt19937::result_type> range(0, 100);
 
+    Profiler::count(Profiler::Counter::Battles);
+    Profiler::count(Profiler::Counter::RandomDraws, sAmount + std::max(sTarget->getArmies(), 0));
+
     // Remove attackers from source territory
     sSource->setArmies(sSource->getArmies() - sAmount);
 
@@ -227,7 +236,7 @@ void AdvanceOrder::simulateAttack(Player* sPlayer, Territory* sSource, Territory
 
         // TODO: See how to give the player a card
         std::cout << player->getName() << " won a new card!" << std::endl;
-        player->getHand()->addCard(deck->draw());
+        player->addCardToHand(deck->draw());
     } else {
         // Loss
         std::cout << "Territory was not conquered! " << sPlayer->getName() << " lost the battle for " << sTarget->getName() << "!" << std::endl;
@@ -241,10 +250,10 @@ void AdvanceOrder::simulateAttack(Player* sPlayer, Territory* sSource, Territory
         if (sSource->getOwner())
             sSource->getOwner()->removeTerritory(sSource);
     }
-    if (target->getArmies() == 0) {
+    // A territory lost in an earlier battle has no owner left to lose it
+    if (target->getArmies() == 0 && sTarget->getOwner()) {
         std::cout << sTarget->getOwner()->getName() << " has lost the " << sTarget->getName() << " territory in the process!";
-        if (sTarget->getOwner())
-            sTarget->getOwner()->removeTerritory(sTarget);
+        sTarget->getOwner()->removeTerritory(sTarget);
     }
 }
 
@@ -292,15 +301,11 @@ bool BombOrder::validate() {
         return false;
     }
 
-    bool isAdjacent = false;
-    for (auto t : player->getOwnedTerritories()) {
-        const auto& adjacentToT = t->getAdjacent();
-
-        if (std::find(adjacentToT.begin(), adjacentToT.end(), target) != adjacentToT.end()) {
-            isAdjacent = true;
-            break;
-        }
-    }
+    // Adjacency is symmetric, so only the target's neighbors need to be checked
+    const auto& adjacentToTarget = target->getAdjacent();
+    bool isAdjacent = std::any_of(adjacentToTarget.begin(), adjacentToTarget.end(), [this](const Territory* t) {
+        return t->getOwner() == player;
+    });
     if (!isAdjacent) {
         std::cout << "Order Invalid. The target territory is not adjacent to yours!" << std::endl;
         return false;
@@ -326,7 +331,7 @@ void BombOrder::execute() {
                 target->getOwner()->removeTerritory(target);
         }
         std::cout << "Bomb order executed!" << std::endl;
-        notify(this);
+        notify(Event::Kind::OrderExecuted, this);
     }
 }
 
@@ -385,7 +390,7 @@ void BlockadeOrder::execute() {
             target->getOwner()->removeTerritory(target);
 
         std::cout << "Blockade executed!" << std::endl;
-        notify(this);
+        notify(Event::Kind::OrderExecuted, this);
     }
 }
 
@@ -462,7 +467,7 @@ void AirliftOrder::execute() {
                 source->getOwner()->removeTerritory(source);
         }
         std::cout << "Airlift executed!" << std::endl;
-        notify(this);
+        notify(Event::Kind::OrderExecuted, this);
     }
 }
 
@@ -516,7 +521,7 @@ void NegotiateOrder::execute() {
         currentPlayer->addFriend(targetPlayer);
         targetPlayer->addFriend(currentPlayer);
         std::cout << "A negotiation was made between " << currentPlayer->getName() << " and " << targetPlayer->getName() << "!" << std::endl;
-        notify(this);
+        notify(Event::Kind::OrderExecuted, this);
     }
 }
 
@@ -568,7 +573,7 @@ OrdersList::~OrdersList() {
 void OrdersList::add(Order* order) {
     if (order) {
         this->orders.push_back(order);
-        notify(this);
+        notify(Event::Kind::OrderAdded, this);
     } else {
         throw std::invalid_argument("Order is null somehow");
     }
@@ -30,6 +30,7 @@ public:
     virtual Order* clone() const = 0;
     virtual void print(std::ostream& out) const = 0;
     std::string stringToLog() const override;
+    const std::string& getName() const;
 
     void attach(Observer* observer) override;
 
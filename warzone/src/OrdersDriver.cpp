@@ -1,6 +1,11 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <fstream>
 #include <iostream>
+#include <random>
 
+#include "BattleOdds.h"
 #include "Cards.h"
 #include "Orders.h"
 #include "OrdersDriver.h"
@@ -107,3 +112,54 @@ void testOrdersList() {
     delete foe;
     delete deck;
 }
+
+// The rolls of AdvanceOrder::simulateAttack, without touching any territory
+static bool simulatedConquest(std::mt19937& rng, int attackers, int defenders) {
+    std::uniform_int_distribution<std::mt19937::result_type> range(0, 100);
+    int kills = 0;
+    int losses = 0;
+    for (int i = 0; i < attackers; i++) {
+        kills += static_cast<int>(range(rng) % 100 + 1) <= 60;
+    }
+    for (int i = 0; i < defenders; i++) {
+        losses += static_cast<int>(range(rng) % 100 + 1) <= 70;
+    }
+    return attackers - losses > 0 && defenders - kills <= 0;
+}
+
+void testBattleOdds() {
+    const BattleOdds& odds = BattleOdds::instance();
+    std::cout << odds << std::endl;
+
+    // Monte Carlo battles against the tables, exact and approximated
+    std::mt19937 rng(1);
+    const int trials = 20000;
+    double worst = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (auto [attackers, defenders] : { std::pair { 3, 1 }, { 5, 3 }, { 10, 6 }, { 40, 20 }, { 150, 85 }, { 300, 170 } }) {
+        int won = 0;
+        for (int i = 0; i < trials; i++) {
+            won += simulatedConquest(rng, attackers, defenders);
+        }
+        double simulated = static_cast<double>(won) / trials;
+        double table = odds.conquest(attackers, defenders);
+        worst = std::max(worst, std::abs(simulated - table));
+        std::cout << attackers << " against " << defenders << ": table " << table << ", simulated " << simulated
+                  << ", " << odds.expectedSurvivors(attackers, defenders) << " survivors expected" << std::endl;
+    }
+    std::chrono::duration<double> simulation = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    double sum = 0;
+    for (int i = 0; i < 6 * trials; i++) {
+        sum += odds.conquest(1 + i % 300, 1 + i % 170);
+    }
+    std::chrono::duration<double> lookup = std::chrono::steady_clock::now() - start;
+
+    std::cout << "Tables match simulated battles within 2%: " << (worst < 0.02) << std::endl
+              << "More attackers never lower the odds: "
+              << (odds.conquest(20, 10) >= odds.conquest(19, 10) && odds.conquest(200, 150) >= odds.conquest(199, 150)) << std::endl
+              << "Looked up odds are probabilities: " << (sum >= 0 && sum <= 6 * trials) << std::endl
+              << "Lookups are " << static_cast<long>(simulation.count() / std::max(lookup.count(), 1e-9))
+              << " times faster than simulating" << std::endl;
+}
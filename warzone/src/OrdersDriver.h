@@ -6,3 +6,8 @@
  * @brief A function that serves to test Order and OrdersList
  */
 void testOrdersList();
+
+/**
+ * @brief A function that checks the battle odds against simulated battles
+ */
+void testBattleOdds();
@@ -1,23 +1,27 @@
 #include "Player.h"
 #include "Orders.h"
 #include "PlayerStrategies.h"
+#include "Profiler.h"
+#include "Zobrist.h"
 #include <algorithm>
 #include <cstdlib>
 #include <iostream>
 
-Player::Player(std::string name, PlayerStrategy* strategy)
+Player::Player(std::string name, Strategy strategy)
     : name(name)
     , cards(new Hand())
     , pool(0)
     , orders(new OrdersList())
-    , strategy(strategy) {
-    strategy->player = this;
+    , strategy(std::move(strategy))
+    , zobristKey(Zobrist::nextPlayerKey()) {
+    context().player = this;
 }
 
 Player::Player(std::string name, Map* map, Deck* deck, std::vector<Player*>& otherPlayers)
-    : Player(name, new HumanPlayer(map, deck, &otherPlayers)) { }
+    : Player(name, HumanPlayer(map, deck, &otherPlayers)) { }
 
-Player::Player(const Player& other) {
+Player::Player(const Player& other)
+    : strategy(other.strategy) {
     for (auto t : other.territories) {
         // Map handles the territories, no need to copy
         territories.push_back(t);
@@ -30,8 +34,9 @@ Player::Player(const Player& other) {
     this->cards = new Hand(*other.cards);
     this->pool = other.pool;
     this->orders = new OrdersList(*other.orders);
-    this->strategy = other.strategy->clone();
-    this->strategy->player = this;
+    context().player = this;
+    this->random = other.random;
+    this->zobristKey = other.zobristKey;
 }
 
 // Destructor
@@ -41,19 +46,37 @@ Player::~Player() {
     // Hand destructor is called automatically
     delete cards;
     delete orders;
-    delete strategy;
 }
 
 std::vector<Territory*> Player::toDefend() {
-    return this->strategy->toDefend();
+    return std::visit([](auto& s) { return s.toDefend(); }, this->strategy);
 }
 
 std::vector<Territory*> Player::toAttack() {
-    return this->strategy->toAttack();
+    return std::visit([](auto& s) { return s.toAttack(); }, this->strategy);
 }
 
 void Player::issueOrder() {
-    return this->strategy->issueOrder();
+    PROFILE_SCOPE("issueOrder " + strategyName(this->strategy));
+    std::visit([](auto& s) { s.issueOrder(); }, this->strategy);
+}
+
+void Player::beginOrders() {
+    if (HumanPlayer* human = std::get_if<HumanPlayer>(&this->strategy)) {
+        human->beginTurn();
+        return;
+    }
+    issueOrder();
+}
+
+std::optional<std::string> Player::prompt() const {
+    const HumanPlayer* human = std::get_if<HumanPlayer>(&this->strategy);
+    return human ? human->prompt() : std::nullopt;
+}
+
+std::string Player::answer(const std::string& line) {
+    HumanPlayer* human = std::get_if<HumanPlayer>(&this->strategy);
+    return human ? human->answer(line) : "Only humans answer questions.";
 }
 
 Order* Player::getNextOrder() {
@@ -88,6 +111,28 @@ const std::vector<Territory*>& Player::getOwnedTerritories() const {
     return this->territories;
 }
 
+const std::vector<Territory*>& Player::getFrontier() const {
+    return this->frontier;
+}
+
+void Player::addToFrontier(Territory* territory) {
+    territory->frontierSlot = this->frontier.size();
+    this->frontier.push_back(territory);
+}
+
+void Player::removeFromFrontier(Territory* territory) {
+    size_t slot = territory->frontierSlot;
+    if (slot >= this->frontier.size() || this->frontier[slot] != territory) {
+        // Copied territories may point to an owner that never tracked them
+        return;
+    }
+    // Swap with the last territory so removal is O(1)
+    Territory* last = this->frontier.back();
+    this->frontier[slot] = last;
+    last->frontierSlot = slot;
+    this->frontier.pop_back();
+}
+
 int Player::getPool() {
     return this->pool;
 }
@@ -96,7 +141,7 @@ void Player::addTerritory(Territory* territory) {
     auto it = std::find(territories.begin(), territories.end(), territory);
     if (it == territories.end()) {
         territories.push_back(territory);
-        this->strategy->map->setTerritoryOwner(territory, this);
+        context().map->setTerritoryOwner(territory, this);
     }
 }
 
@@ -104,7 +149,7 @@ void Player::removeTerritory(Territory* territory) {
     auto it = std::find(territories.begin(), territories.end(), territory);
     if (it != territories.end()) {
         territories.erase(it);
-        this->strategy->map->setTerritoryOwner(territory, nullptr);
+        context().map->setTerritoryOwner(territory, nullptr);
     }
 }
 
@@ -119,9 +164,9 @@ void Player::removeArmiesFromPool(int i) {
     }
 }
 
-void Player::addCardToHand(Card* card) {
+void Player::addCardToHand(const std::optional<Card>& card) {
     if (card) {
-        cards->addCard(card);
+        cards->addCard(*card);
     }
 }
 
@@ -149,14 +194,24 @@ bool Player::isFriendsWith(Player* player) {
     return it != friends.end();
 }
 
-void Player::setStrategy(PlayerStrategy* strategy) {
-    this->strategy = strategy->clone();
-    this->strategy->player = this;
+void Player::setStrategy(Strategy strategy) {
+    this->strategy = std::move(strategy);
+    context().player = this;
+}
+
+const Strategy& Player::getStrategy() const {
+    return this->strategy;
 }
+
 void Player::initStrategy(Map* map, Deck* deck, std::vector<Player*>* players) {
-    this->strategy->map = map;
-    this->strategy->deck = deck;
-    this->strategy->players = players;
+    PlayerStrategy& context = this->context();
+    context.map = map;
+    context.deck = deck;
+    context.players = players;
+}
+
+PlayerStrategy& Player::context() {
+    return std::visit([](PlayerStrategy& s) -> PlayerStrategy& { return s; }, this->strategy);
 }
 
 Player& Player::operator=(const Player& other) {
@@ -175,6 +230,18 @@ Player& Player::operator=(const Player& other) {
     return *this;
 }
 
+bool Player::issuesConcurrently() const {
+    return readsBoardOnly(this->strategy);
+}
+
+void Player::seed(std::uint32_t seed) {
+    this->random.seed(seed);
+}
+
+std::mt19937& Player::getRandom() {
+    return this->random;
+}
+
 void Player::observer(Observer* observer) {
     this->orders->attach(observer);
     orders->observeAllOrders(observer);
@@ -186,3 +253,20 @@ std::ostream& operator<<(std::ostream& out, const Player& player) {
     }
     return out << "Player " << player.name;
 }
+
+std::uint64_t Player::getZobristKey() const {
+    return this->zobristKey;
+}
+
+void Player::setZobristKey(std::uint64_t key) {
+    std::uint64_t previous = this->zobristKey;
+    this->zobristKey = key;
+    for (auto t : this->territories) {
+        t->rekeyOwner(previous);
+    }
+}
+
+std::uint64_t Player::hash() const {
+    return Zobrist::key(Zobrist::Feature::Pool, this->zobristKey, static_cast<std::uint32_t>(this->pool))
+        ^ Zobrist::key(Zobrist::Feature::Cards, this->zobristKey, this->cards->hash());
+}
@@ -5,7 +5,10 @@
 #include "Orders.h"
 #include "Player.fwd.h"
 #include "PlayerStrategies.h"
+#include <cstdint>
+#include <optional>
 #include <ostream>
+#include <random>
 #include <vector>
 
 /**
@@ -19,6 +22,8 @@ private:
     std::string name;
     /** @brief Collection of territories owned by the player. */
     std::vector<Territory*> territories;
+    /** @brief Owned territories adjacent to at least one territory owned by someone else, maintained by Territory::setOwner. */
+    std::vector<Territory*> frontier;
     /** @brief Collection of cards in the player's hand. */
     Hand* cards;
     /** @brief the number of reinforcements the player has in his pool(reinforcements not in territories) */
@@ -28,13 +33,24 @@ private:
 
     OrdersList* orders;
 
-    PlayerStrategy* strategy;
+    /** @brief The player's strategy, held by value so calls dispatch without virtual functions. */
+    Strategy strategy;
+
+    /** @brief Random generator for everything the player decides or rolls, seeded by the game. */
+    std::mt19937 random;
+    /** @brief Identifies the player in Zobrist hashes, copies of a player share it. */
+    std::uint64_t zobristKey;
+
+    friend class Territory;
+    void addToFrontier(Territory* territory);
+    void removeFromFrontier(Territory* territory);
+    PlayerStrategy& context();
 
 public:
     /**
      * @brief Default constructor for the Player class.
      */
-    Player(std::string name, PlayerStrategy* strategy);
+    Player(std::string name, Strategy strategy);
 
     /**
      * @brief Default constructor for the Player class.
@@ -75,6 +91,20 @@ public:
      * It will be implemented later in the assignment.
      */
     void issueOrder();
+    /**
+     * @brief Start issuing the orders of the turn without waiting for input.
+     *
+     * Computers issue all their orders at once, humans ask their first question, see prompt.
+     */
+    void beginOrders();
+    /**
+     * @brief The question a human is waiting on, nothing once its orders are issued or for a computer.
+     */
+    std::optional<std::string> prompt() const;
+    /**
+     * @brief Answer the question of a human, see HumanPlayer::answer.
+     */
+    std::string answer(const std::string& line);
     Order* getNextOrder();
 
     /**
@@ -85,11 +115,17 @@ public:
     const std::vector<Player*>& getFriends() const;
     size_t getTerritories();
     const std::vector<Territory*>& getOwnedTerritories() const;
+    /**
+     * @brief Owned territories adjacent to at least one territory owned by someone else.
+     *
+     * Kept up to date as territories change owner, in no particular order.
+     */
+    const std::vector<Territory*>& getFrontier() const;
     int getPool();
     Hand* getHand();
     void addTerritory(Territory* territory);
     void addReinforcementToPool(int i);
-    void addCardToHand(Card* card);
+    void addCardToHand(const std::optional<Card>& card);
 
     bool hasReinforcementsInPool() const { return pool > 0; }
     bool wantsToIssueOrder() const;
@@ -101,8 +137,36 @@ public:
     void clearFriends();
     bool isFriendsWith(Player* player);
 
-    void setStrategy(PlayerStrategy* strategy);
+    /**
+     * @brief Replace the strategy in place, keeping the game it plays in.
+     *
+     * When called from the current strategy, that strategy is destroyed on return.
+     */
+    void setStrategy(Strategy strategy);
+    const Strategy& getStrategy() const;
     void initStrategy(Map* map, Deck* deck, std::vector<Player*>* players);
+    /**
+     * @brief Whether the player's orders can be issued at the same time as other players'.
+     *
+     * True for the strategies that only read the board and need no input.
+     */
+    bool issuesConcurrently() const;
+
+    /**
+     * @brief Seed the player's random generator, the same seed gives the same decisions and rolls.
+     */
+    void seed(std::uint32_t seed);
+    std::mt19937& getRandom();
+
+    std::uint64_t getZobristKey() const;
+    /**
+     * @brief Identify the player by another key, updating the hash of the territories it owns.
+     */
+    void setZobristKey(std::uint64_t key);
+    /**
+     * @brief Zobrist hash of the player's pool and hand, in O(1)
+     */
+    std::uint64_t hash() const;
 
     void observer(Observer* observer);
     Player& operator=(const Player& other);
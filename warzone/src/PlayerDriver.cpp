@@ -1,6 +1,8 @@
 #include "PlayerDriver.h"
 #include "Player.h"
+#include <algorithm>
 #include <iostream>
+#include <random>
 
 void testPlayer() {
     std::cout << "This section is from PlayerDriver" << std::endl;
@@ -40,3 +42,63 @@ void testPlayer() {
     std::cout << "Name:" << std::endl
               << player.getName() << std::endl;
 }
+
+// Owned territories adjacent to a territory owned by someone else, found by scanning everything
+static std::vector<Territory*> scanFrontier(const Player& player) {
+    std::vector<Territory*> frontier;
+    for (auto t : player.getOwnedTerritories()) {
+        for (auto a : t->getAdjacent()) {
+            if (a->getOwner() != &player) {
+                frontier.push_back(t);
+                break;
+            }
+        }
+    }
+    std::sort(frontier.begin(), frontier.end());
+    return frontier;
+}
+
+void testFrontier() {
+    std::cout << "This section checks the player frontiers" << std::endl;
+    std::ifstream file("./res/map/King of the Hills.map");
+    Map* map = MapLoader(file).parse();
+    Deck* deck = new Deck();
+    std::vector<Player*> players;
+    players.push_back(new Player("John Warzone", map, deck, players));
+    players.push_back(new Player("Willem Dafoe", map, deck, players));
+    players.push_back(new Player("Willem Dafriend", map, deck, players));
+
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<size_t> anyTerritory(0, map->getNumberTerritories() - 1);
+    std::uniform_int_distribution<size_t> anyPlayer(0, players.size());
+    bool consistent = true;
+    for (size_t i = 0; i < 2000; i++) {
+        // Give a random territory to a random player, or to no one
+        Territory* territory = map->findTerritoryByIndex(anyTerritory(rng));
+        size_t index = anyPlayer(rng);
+        if (territory->getOwner()) {
+            territory->getOwner()->removeTerritory(territory);
+        }
+        if (index < players.size()) {
+            players[index]->addTerritory(territory);
+        }
+
+        for (auto p : players) {
+            std::vector<Territory*> frontier = p->getFrontier();
+            std::sort(frontier.begin(), frontier.end());
+            if (frontier != scanFrontier(*p)) {
+                consistent = false;
+            }
+        }
+    }
+    for (auto p : players) {
+        std::cout << *p << " owns " << p->getTerritories() << " territories, " << p->getFrontier().size() << " on the frontier" << std::endl;
+    }
+    std::cout << "Frontiers match a full scan: " << consistent << std::endl;
+
+    for (auto p : players) {
+        delete p;
+    }
+    delete deck;
+    delete map;
+}
@@ -6,3 +6,8 @@
  * @brief A function that serves to test Order and OrdersList
  */
 void testPlayer();
+
+/**
+ * @brief Checks the incrementally maintained frontiers against a full scan
+ */
+void testFrontier();
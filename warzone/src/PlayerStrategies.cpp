@@ -1,12 +1,18 @@
 #include "PlayerStrategies.h"
+#include "BattleOdds.h"
+#include "DistanceTable.h"
+#include "Map.h"
 #include "Orders.h"
 #include "Player.h"
+#include "Profiler.h"
+#include <algorithm>
 #include <cctype>
 #include <limits>
 #include <random>
 #include <set>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 static const int INITIAL_POOL_AMOUNT = 50;
@@ -24,21 +30,68 @@ PlayerStrategy::PlayerStrategy(const PlayerStrategy& other)
     : player(other.player)
     , map(other.map)
     , deck(other.deck)
-    , players(other.players) { };
+    , players(other.players)
+    , parameters(other.parameters) { };
 
 PlayerStrategy& PlayerStrategy::operator=(const PlayerStrategy& other) {
     this->player = other.player;
     this->map = other.map;
+    this->parameters = other.parameters;
     return *this;
 }
 
-std::ostream& operator<<(std::ostream& out, const PlayerStrategy& playerStrategy) {
+const StrategyParameters& PlayerStrategy::getParameters() const {
+    return this->parameters;
+}
+
+void PlayerStrategy::setParameters(const StrategyParameters& parameters) {
+    this->parameters = parameters;
+}
+
+std::ostream& operator<<(std::ostream& out, const StrategyParameters& parameters) {
     return out
-        << playerStrategy.name()
+        << "card chance " << parameters.cardChance
+        << ", attack confidence " << parameters.attackConfidence
+        << ", deploy share " << parameters.deployShare
+        << ", advance share " << parameters.advanceShare
+        << ", attack limit " << parameters.attackLimit;
+}
+
+std::string strategyName(const Strategy& strategy) {
+    return std::visit([](const auto& s) { return s.name(); }, strategy);
+}
+
+bool readsBoardOnly(const Strategy& strategy) {
+    return !std::holds_alternative<HumanPlayer>(strategy) && !std::holds_alternative<CheaterPlayer>(strategy);
+}
+
+bool isPassive(const Strategy& strategy) {
+    return std::holds_alternative<NeutralPlayer>(strategy) || std::holds_alternative<BenevolentPlayer>(strategy);
+}
+
+std::optional<Strategy> strategyFromName(const std::string& name) {
+    if (name == "human") {
+        return HumanPlayer();
+    } else if (name == "aggressive") {
+        return AggressivePlayer();
+    } else if (name == "benevolent") {
+        return BenevolentPlayer();
+    } else if (name == "neutral") {
+        return NeutralPlayer();
+    } else if (name == "cheater") {
+        return CheaterPlayer();
+    }
+    return std::nullopt;
+}
+
+std::ostream& operator<<(std::ostream& out, const Strategy& strategy) {
+    const PlayerStrategy& context = std::visit([](const PlayerStrategy& s) -> const PlayerStrategy& { return s; }, strategy);
+    return out
+        << strategyName(strategy)
         << " with "
-        << *playerStrategy.player
+        << *context.player
         << " on "
-        << *playerStrategy.map;
+        << *context.map;
 }
 
 #define STRATEGY_BOILERPLATE(Type)                                                  \
@@ -51,9 +104,8 @@ std::ostream& operator<<(std::ostream& out, const PlayerStrategy& playerStrategy
     Type##Player::Type##Player(const Type##Player& other)                           \
         : PlayerStrategy(other) {};                                                 \
                                                                                     \
-    PlayerStrategy* Type##Player::clone() const {                                   \
-        return new Type##Player(*this);                                             \
-    }                                                                               \
+    Type##Player::Type##Player(const PlayerStrategy& context)                       \
+        : PlayerStrategy(context) {};                                               \
                                                                                     \
     std::string Type##Player::name() const {                                        \
         return #Type;                                                               \
@@ -65,14 +117,34 @@ std::ostream& operator<<(std::ostream& out, const PlayerStrategy& playerStrategy
 
 // clang-format on
 
-STRATEGY_BOILERPLATE(Human)
-STRATEGY_BOILERPLATE(Aggressive)
 STRATEGY_BOILERPLATE(Benevolent)
 STRATEGY_BOILERPLATE(Neutral)
 STRATEGY_BOILERPLATE(Cheater)
 
 #undef STRATEGY_BOILERPLATE
 
+// The candidates are the state of one turn, copies start without any
+AggressivePlayer::AggressivePlayer(Map* map, Deck* deck, std::vector<Player*>* players)
+    : PlayerStrategy(map, deck, players) { }
+
+AggressivePlayer::AggressivePlayer()
+    : PlayerStrategy() { }
+
+AggressivePlayer::AggressivePlayer(const AggressivePlayer& other)
+    : PlayerStrategy(other) { }
+
+AggressivePlayer::AggressivePlayer(const PlayerStrategy& context)
+    : PlayerStrategy(context) { }
+
+std::string AggressivePlayer::name() const {
+    return "Aggressive";
+}
+
+AggressivePlayer& AggressivePlayer::operator=(const AggressivePlayer& other) {
+    PlayerStrategy::operator=(other);
+    return *this;
+}
+
 static std::string readLine() {
     while (true) {
         std::flush(std::cout);
@@ -87,105 +159,96 @@ static std::string readLine() {
     }
 }
 
-static size_t readInt(size_t max) {
-    while (true) {
-        std::string line = readLine();
-        try {
-            size_t integer = std::stoi(line);
-            if (integer > max) {
-                std::cout << "Larger than pool: " << integer << std::endl;
-                continue;
-            }
-
-            return integer;
-        } catch (const std::invalid_argument& e) {
-            std::cout << "Invalid number: " << line << std::endl;
-        } catch (const std::out_of_range& e) {
-            std::cout << "Number out of range: " << line << std::endl;
+// The answers are parsed apart from where they come from, the console or a client of the server,
+// each parser returns why the answer is refused or an empty string
+static std::string parseInt(const std::string& line, size_t max, size_t& integer) {
+    try {
+        // Checked before it is stored, a negative number would wrap to a huge count
+        int parsed = std::stoi(line);
+        if (parsed < 0) {
+            return "Negative number: " + line;
+        }
+        integer = static_cast<size_t>(parsed);
+        if (integer > max) {
+            return "Larger than pool: " + std::to_string(integer);
         }
+        return "";
+    } catch (const std::invalid_argument& e) {
+        return "Invalid number: " + line;
+    } catch (const std::out_of_range& e) {
+        return "Number out of range: " + line;
     }
 }
 
-static bool readBool() {
-    while (true) {
-        std::string line = readLine();
-        std::transform(line.begin(), line.end(), line.begin(), ::tolower);
-        if (line == "yes" || line == "yep" || line == "mhm" || line == "true" || line == "1") {
-            return true;
+static std::string parseBool(std::string line, bool& boolean) {
+    std::transform(line.begin(), line.end(), line.begin(), ::tolower);
+    if (line == "yes" || line == "yep" || line == "mhm" || line == "true" || line == "1") {
+        boolean = true;
+        return "";
+    }
+    if (line == "no" || line == "nope" || line == "nu uh" || line == "false" || line == "0") {
+        boolean = false;
+        return "";
+    }
+    return "Invalid boolean: " + line;
+}
+
+static std::string parseIndices(const std::string& line, size_t count, std::vector<size_t>& indices) {
+    indices.clear();
+    std::stringstream input(line);
+    std::string token;
+    while (std::getline(input, token, ',')) {
+        size_t index;
+        std::string error = parseInt(token, std::numeric_limits<size_t>::max(), index);
+        if (!error.empty()) {
+            return error;
         }
-        if (line == "no" || line == "nope" || line == "nu uh" || line == "false" || line == "0") {
-            return false;
+        if (index >= count) {
+            return "Index out of range: " + std::to_string(index);
         }
-        std::cout << "Invalid boolean: " << line << std::endl;
+        indices.push_back(index);
     }
+    return "";
 }
 
 template <class T>
-static T* readOption(const std::vector<T*>& source) {
+static void listOptions(std::ostream& out, const std::vector<T*>& source) {
     for (size_t i = 0; i < source.size(); i++) {
-        std::cout
-            << "    "
+        out
+            << "\n    "
             << i
             << ". "
-            << *source[i]
-            << std::endl;
-    }
-    if (source.size() == 0) {
-        return nullptr;
-    }
-    if (source.size() == 1) {
-        std::cout << "Auto selected your only option: " << *source[0] << std::endl;
-        return source[0];
-    }
-    while (true) {
-        return source[readInt(source.size() - 1)];
+            << *source[i];
     }
 }
 
 template <class T>
 static std::vector<T*> readOptions(const std::vector<T*>& source) {
-    std::cout << "Comma separated, no spaces" << std::endl;
-    for (size_t i = 0; i < source.size(); i++) {
-        std::cout
-            << "    "
-            << i
-            << ". "
-            << *source[i]
-            << std::endl;
-    }
+    std::cout << "Comma separated, no spaces";
+    listOptions(std::cout, source);
+    std::cout << std::endl;
     if (source.size() == 0) {
         return std::vector<T*> {};
     }
     while (true) {
-    restart:
+        std::vector<size_t> indices;
+        std::string error = parseIndices(readLine(), source.size(), indices);
+        if (!error.empty()) {
+            std::cout << error << std::endl;
+            continue;
+        }
         std::vector<T*> result;
-
-        std::stringstream input(readLine());
-        std::string token;
-        while (std::getline(input, token, ',')) {
-            try {
-                size_t index = std::stoi(token);
-                if (index >= source.size()) {
-                    std::cout << "Index out of range: " << index << std::endl;
-                    goto restart;
-                }
-                result.push_back(source[index]);
-            } catch (const std::invalid_argument& e) {
-                std::cout << "Invalid number: " << token << std::endl;
-                goto restart;
-            } catch (const std::out_of_range& e) {
-                std::cout << "Number out of range: " << token << std::endl;
-                goto restart;
-            }
+        for (size_t index : indices) {
+            result.push_back(source[index]);
         }
-
         return result;
     }
 }
 
+// Only the player's frontier can be adjacent to enemies
 static std::vector<Territory*> adjacentEnemyTerritories(Player* player) {
     std::set<Territory*> adjacent_set;
-    for (auto& t : player->getOwnedTerritories()) {
+    for (auto& t : player->getFrontier()) {
         for (auto& a : t->getAdjacent()) {
             if (a->getOwner() != player) {
                 adjacent_set.emplace(a);
@@ -198,98 +261,418 @@ static std::vector<Territory*> adjacentEnemyTerritories(Player* player) {
     return adjacent_vec;
 }
 
-static int randomInt(int min, int max) {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    return std::uniform_int_distribution<>(min, max)(gen);
+// Owned territories an attack on the target can come from
+static std::vector<Territory*> ownedAdjacentTerritories(Player* player, Territory* target) {
+    std::vector<Territory*> adjacent;
+    for (auto a : target->getAdjacent()) {
+        if (a->getOwner() == player) {
+            adjacent.push_back(a);
+        }
+    }
+    return adjacent;
 }
 
-void HumanPlayer::issueOrder() {
-    // Defend
-    for (auto t : this->player->toDefend()) {
-        std::cout
-            << "=== Your pool is " << this->player->getPool()
-            << std::endl
-            << "=== Enter how many armies to defend with:" << std::endl;
-        std::cout << *t << std::endl;
+// Territories sorted by how many hostile territories surround them, only the frontier needs counting
+static std::vector<Territory*> territoriesByEnemies(Player* player) {
+    std::vector<std::tuple<Territory*, int>> territoriesWithEnemies;
+    std::vector<Territory*> territories;
+    territories.reserve(player->getOwnedTerritories().size());
 
-        this->player->getOrders().add(new DeployOrder(
-            this->player,
-            t,
-            readInt(this->player->getPool())));
+    for (Territory* territory : player->getOwnedTerritories()) {
+        if (territory->getEnemyNeighbors() == 0) {
+            // Surrounded by its own territories, no enemies to count
+            territories.push_back(territory);
+            continue;
+        }
+        int enemyTerritories = 0;
+        for (auto adjTerritory : territory->getAdjacent()) {
+            Player* territoryOwner = adjTerritory->getOwner();
+            if (territoryOwner != player && territoryOwner != nullptr && !player->isFriendsWith(territoryOwner))
+                enemyTerritories++;
+        }
+        // Add the territory and how many enemy territories surround it
+        territoriesWithEnemies.emplace_back(territory, enemyTerritories);
     }
 
-    // Attack
-    for (auto t : this->player->toAttack()) {
-        std::cout
-            << "=== Attacking " << *t
-            << std::endl;
-        std::vector<Territory*> adjacent;
-        for (auto p : this->player->getOwnedTerritories()) {
-            const auto& adj = t->getAdjacent();
-            auto it = std::find(adj.begin(), adj.end(), p);
-            if (it != adj.end()) {
-                adjacent.push_back(p);
-            }
+    // Sort the territories based on how many enemy territories surround it
+    std::stable_sort(territoriesWithEnemies.begin(), territoriesWithEnemies.end(), [](auto const& tup1, auto const& tup2) {
+        return std::get<1>(tup1) < std::get<1>(tup2);
+    });
+
+    for (auto territory : territoriesWithEnemies) {
+        // Get the territory back from the tuple
+        territories.push_back(std::get<0>(territory));
+    }
+
+    return territories;
+}
+
+// The territory facing the most armies of other players, or the most hostile neighbors without a map,
+// the first one on a tie; the threats of the whole board are summed in one pass over the map's board
+static Territory* mostThreatened(Player* player, const Map* map, const std::vector<Territory*>& territories, const Territory* excluded = nullptr) {
+    std::vector<std::int64_t> threats;
+    if (map) {
+        threats = map->getBoard().threats(player);
+    }
+    Territory* target = nullptr;
+    std::int64_t most = -1;
+    for (auto t : territories) {
+        if (t == excluded)
+            continue;
+        std::int64_t threat = t->getIndex() < threats.size() ? threats[t->getIndex()] : t->getEnemyNeighbors();
+        if (threat > most) {
+            most = threat;
+            target = t;
         }
+    }
+    return target;
+}
 
-        Territory* source = readOption(adjacent);
+// Every random decision of a player comes from its own generator, so games replay from their seed
+static int randomInt(Player* player, int min, int max) {
+    Profiler::count(Profiler::Counter::RandomDraws);
+    return std::uniform_int_distribution<>(min, max)(player->getRandom());
+}
 
-        std::cout << "=== Enter how many armies to attack with:" << std::endl;
-        this->player->getOrders().add(new AdvanceOrder(
-            this->player,
-            source,
-            t,
-            readInt(std::numeric_limits<size_t>::max()),
-            this->deck));
+static bool randomChance(Player* player, double chance) {
+    Profiler::count(Profiler::Counter::RandomDraws);
+    return std::bernoulli_distribution(chance)(player->getRandom());
+}
+
+// Armies deployed on the next territory, at least one and at most the share of the pool
+static int deployment(Player* player, double share) {
+    int most = std::max(1, static_cast<int>(player->getPool() * share));
+    return randomInt(player, 1, most);
+}
+
+HumanPlayer::HumanPlayer(Map* map, Deck* deck, std::vector<Player*>* players)
+    : PlayerStrategy(map, deck, players) { }
+
+HumanPlayer::HumanPlayer()
+    : PlayerStrategy() { }
+
+HumanPlayer::HumanPlayer(const HumanPlayer& other)
+    : PlayerStrategy(other)
+    , step(other.step)
+    , options(other.options)
+    , others(other.others)
+    , chosen(other.chosen)
+    , index(other.index)
+    , source(other.source)
+    , target(other.target)
+    , card(other.card) { }
+
+HumanPlayer::HumanPlayer(const PlayerStrategy& context)
+    : PlayerStrategy(context) { }
+
+std::string HumanPlayer::name() const {
+    return "Human";
+}
+
+HumanPlayer& HumanPlayer::operator=(const HumanPlayer& other) {
+    PlayerStrategy::operator=(other);
+    this->step = other.step;
+    this->options = other.options;
+    this->others = other.others;
+    this->chosen = other.chosen;
+    this->index = other.index;
+    this->source = other.source;
+    this->target = other.target;
+    this->card = other.card;
+    return *this;
+}
+
+void HumanPlayer::issueOrder() {
+    beginTurn();
+    while (std::optional<std::string> question = prompt()) {
+        std::cout << *question << std::endl;
+        std::string error = answer(readLine());
+        if (!error.empty()) {
+            std::cout << error << std::endl;
+        }
     }
+}
 
-    // Cards
-    Card* card = this->player->getHand()->draw();
-    if (card) {
-        std::cout << "=== Do you want to play your card?: " << *card << std::endl;
-        if (readBool()) {
-            switch (card->getType()) {
-            case CardType::BOMB: {
-                std::cout << "Select a territory to bomb: " << std::endl;
-                Territory* target = readOption(adjacentEnemyTerritories(this->player));
-                this->player->getOrders().add(new BombOrder(this->player, target));
-            } break;
-            case CardType::REINFORCEMENT:
-                std::cout << this->player->getName() << " played a Reinforcement card and has added 5 more units to their pool!" << std::endl;
-                this->player->addReinforcementToPool(5);
-                break;
-            case CardType::BLOCKADE: {
-                std::cout << "Select a territory to blockade: " << std::endl;
-                Territory* target = readOption(this->player->getOwnedTerritories());
-                this->player->getOrders().add(new BlockadeOrder(this->player, target));
-            } break;
-            case CardType::AIRLIFT: {
-                std::cout << "Select the source territory to airlift from: " << std::endl;
-                Territory* source = readOption(this->player->getOwnedTerritories());
-                std::cout << "Select the target territory to airlift to: " << std::endl;
-                Territory* target = readOption(this->player->getOwnedTerritories());
-                std::cout << "Select the amount of armies" << std::endl;
-                int amount = readInt(std::numeric_limits<int>::max());
-                this->player->getOrders().add(new AirliftOrder(this->player, source, target, amount));
-            } break;
-            case CardType::DIPLOMACY: {
-                std::vector<Player*> otherPlayers;
-                for (auto p : *this->players) {
-                    if (p != this->player) {
-                        otherPlayers.push_back(p);
-                    }
+void HumanPlayer::beginTurn() {
+    this->card.reset();
+    this->options = this->player->getOwnedTerritories();
+    if (this->options.empty()) {
+        askAttack();
+        return;
+    }
+    this->step = Step::Defend;
+}
+
+std::optional<std::string> HumanPlayer::prompt() const {
+    std::stringstream out;
+    switch (this->step) {
+    case Step::Idle:
+        return std::nullopt;
+    case Step::Defend:
+        out << "=== Enter territories to defend\nComma separated, no spaces";
+        listOptions(out, this->options);
+        break;
+    case Step::Deploy:
+        out << "=== Your pool is " << this->player->getPool()
+            << "\n=== Enter how many armies to defend with:\n"
+            << *this->chosen[this->index];
+        break;
+    case Step::Attack:
+        out << "=== Enter territories to attack\nComma separated, no spaces";
+        listOptions(out, this->options);
+        break;
+    case Step::Source:
+        out << "=== Attacking " << *this->chosen[this->index];
+        listOptions(out, this->options);
+        break;
+    case Step::Armies:
+        out << "=== Attacking " << *this->chosen[this->index] << " from " << *this->source
+            << "\n=== Enter how many armies to attack with:";
+        break;
+    case Step::Card:
+        out << "=== Do you want to play your card?: " << *this->card;
+        break;
+    case Step::Bomb:
+        out << "Select a territory to bomb: ";
+        listOptions(out, this->options);
+        break;
+    case Step::Blockade:
+        out << "Select a territory to blockade: ";
+        listOptions(out, this->options);
+        break;
+    case Step::AirliftSource:
+        out << "Select the source territory to airlift from: ";
+        listOptions(out, this->options);
+        break;
+    case Step::AirliftTarget:
+        out << "Select the target territory to airlift to: ";
+        listOptions(out, this->options);
+        break;
+    case Step::AirliftArmies:
+        out << "Select the amount of armies";
+        break;
+    case Step::Negotiate:
+        out << "Select a player to negotiate with: ";
+        listOptions(out, this->others);
+        break;
+    }
+    return out.str();
+}
+
+std::string HumanPlayer::answer(const std::string& line) {
+    std::string trimmed = std::regex_replace(line, TRIM_WHITESPACE, "");
+    std::string error;
+    switch (this->step) {
+    case Step::Idle:
+        return "No question is waiting for an answer.";
+    case Step::Defend:
+    case Step::Attack: {
+        std::vector<size_t> indices;
+        error = parseIndices(trimmed, this->options.size(), indices);
+        if (!error.empty()) {
+            return error;
+        }
+        this->chosen.clear();
+        for (size_t i : indices) {
+            this->chosen.push_back(this->options[i]);
+        }
+        this->index = 0;
+        if (this->step == Step::Defend) {
+            askDeploy();
+        } else {
+            askSource();
+        }
+    } break;
+    case Step::Deploy: {
+        size_t armies;
+        error = parseInt(trimmed, this->player->getPool(), armies);
+        if (!error.empty()) {
+            return error;
+        }
+        this->player->getOrders().add(new DeployOrder(this->player, this->chosen[this->index], armies));
+        this->index++;
+        askDeploy();
+    } break;
+    case Step::Armies: {
+        size_t armies;
+        // Bounded like an airlift, the armies deployed on the source this turn are not on it yet
+        error = parseInt(trimmed, std::numeric_limits<int>::max(), armies);
+        if (!error.empty()) {
+            return error;
+        }
+        this->player->getOrders().add(new AdvanceOrder(this->player, this->source, this->chosen[this->index], static_cast<int>(armies), this->deck));
+        this->index++;
+        askSource();
+    } break;
+    case Step::Card: {
+        bool play;
+        error = parseBool(trimmed, play);
+        if (!error.empty()) {
+            return error;
+        }
+        if (!play) {
+            this->player->getHand()->addCard(*this->card);
+            finish();
+            break;
+        }
+        switch (this->card->getType()) {
+        case CardType::BOMB:
+            this->options = adjacentEnemyTerritories(this->player);
+            askOne(Step::Bomb);
+            break;
+        case CardType::REINFORCEMENT:
+            std::cout << this->player->getName() << " played a Reinforcement card and has added 5 more units to their pool!" << std::endl;
+            this->player->addReinforcementToPool(5);
+            finish();
+            break;
+        case CardType::BLOCKADE:
+            this->options = this->player->getOwnedTerritories();
+            askOne(Step::Blockade);
+            break;
+        case CardType::AIRLIFT:
+            this->options = this->player->getOwnedTerritories();
+            askOne(Step::AirliftSource);
+            break;
+        case CardType::DIPLOMACY:
+            this->others.clear();
+            for (auto p : *this->players) {
+                if (p != this->player) {
+                    this->others.push_back(p);
                 }
-                Player* target = readOption(otherPlayers);
-                this->player->getOrders().add(new NegotiateOrder(this->player, target));
-            } break;
             }
-        } else {
-            this->player->getHand()->addCard(card);
+            if (this->others.size() == 1) {
+                this->player->getOrders().add(new NegotiateOrder(this->player, this->others[0]));
+                finish();
+            } else if (this->others.empty()) {
+                this->player->getHand()->addCard(*this->card);
+                finish();
+            } else {
+                this->step = Step::Negotiate;
+            }
+            break;
+        }
+    } break;
+    case Step::AirliftArmies: {
+        size_t armies;
+        error = parseInt(trimmed, std::numeric_limits<int>::max(), armies);
+        if (!error.empty()) {
+            return error;
+        }
+        this->player->getOrders().add(new AirliftOrder(this->player, this->source, this->target, static_cast<int>(armies)));
+        finish();
+    } break;
+    case Step::Negotiate: {
+        size_t picked;
+        error = parseInt(trimmed, this->others.size() - 1, picked);
+        if (!error.empty()) {
+            return error;
+        }
+        this->player->getOrders().add(new NegotiateOrder(this->player, this->others[picked]));
+        finish();
+    } break;
+    case Step::Source:
+    case Step::Bomb:
+    case Step::Blockade:
+    case Step::AirliftSource:
+    case Step::AirliftTarget: {
+        size_t index;
+        error = parseInt(trimmed, this->options.size() - 1, index);
+        if (!error.empty()) {
+            return error;
+        }
+        picked(this->options[index]);
+    } break;
+    }
+    return "";
+}
+
+void HumanPlayer::askDeploy() {
+    if (this->index < this->chosen.size()) {
+        this->step = Step::Deploy;
+        return;
+    }
+    askAttack();
+}
+
+void HumanPlayer::askAttack() {
+    this->options = adjacentEnemyTerritories(this->player);
+    if (this->options.empty()) {
+        askCard();
+        return;
+    }
+    this->step = Step::Attack;
+}
+
+void HumanPlayer::askSource() {
+    // Targets no owned territory touches cannot be attacked, they are skipped
+    while (this->index < this->chosen.size()) {
+        this->options = ownedAdjacentTerritories(this->player, this->chosen[this->index]);
+        if (!this->options.empty()) {
+            askOne(Step::Source);
+            return;
+        }
+        this->index++;
+    }
+    askCard();
+}
+
+void HumanPlayer::askCard() {
+    this->card = this->player->getHand()->draw();
+    if (!this->card) {
+        finish();
+        return;
+    }
+    this->step = Step::Card;
+}
+
+void HumanPlayer::askOne(Step step) {
+    this->step = step;
+    if (this->options.empty()) {
+        // Nothing to pick, a card is kept for later
+        if (this->card) {
+            this->player->getHand()->addCard(*this->card);
         }
+        finish();
+    } else if (this->options.size() == 1) {
+        picked(this->options[0]);
     }
 }
 
+void HumanPlayer::picked(Territory* territory) {
+    switch (this->step) {
+    case Step::Source:
+        this->source = territory;
+        this->step = Step::Armies;
+        break;
+    case Step::Bomb:
+        this->player->getOrders().add(new BombOrder(this->player, territory));
+        finish();
+        break;
+    case Step::Blockade:
+        this->player->getOrders().add(new BlockadeOrder(this->player, territory));
+        finish();
+        break;
+    case Step::AirliftSource:
+        this->source = territory;
+        askOne(Step::AirliftTarget);
+        break;
+    case Step::AirliftTarget:
+        this->target = territory;
+        this->step = Step::AirliftArmies;
+        break;
+    default:
+        break;
+    }
+}
+
+void HumanPlayer::finish() {
+    this->step = Step::Idle;
+    this->options.clear();
+    this->others.clear();
+    this->chosen.clear();
+    this->card.reset();
+}
+
 std::vector<Territory*> HumanPlayer::toDefend() {
     std::cout
         << "=== Enter territories to defend";
@@ -310,61 +693,84 @@ void AggressivePlayer::issueOrder() {
         if (player->getPool() <= 0)
             return;
 
-        int unitsToDeploy = randomInt(1, player->getPool());
+        int unitsToDeploy = deployment(this->player, this->parameters.deployShare);
 
         this->player->getOrders().add(new DeployOrder(
             this->player,
             t,
             unitsToDeploy));
     }
-    // Attack
-    for (auto t : this->player->toAttack()) {
-        std::cout
-            << "=== Attacking " << *t
-            << std::endl;
-        std::vector<Territory*> adjacent;
-        for (auto p : this->player->getOwnedTerritories()) {
-            const auto& adj = t->getAdjacent();
-            auto it = std::find(adj.begin(), adj.end(), p);
-            if (it != adj.end()) {
-                adjacent.push_back(p);
+    // Attack from the strongest neighbor with just enough armies to win most of the time,
+    // armies already sent from a territory this turn are not available for the next attack
+    const BattleOdds& odds = BattleOdds::instance();
+    std::unordered_map<Territory*, int> committed;
+    this->candidates.collect(this->player);
+    std::size_t attacks = 0;
+    while (this->parameters.attackLimit == 0 || attacks < this->parameters.attackLimit) {
+        Territory* t = this->candidates.next();
+        if (!t)
+            break;
+        Territory* source = nullptr;
+        int available = 0;
+        for (auto a : ownedAdjacentTerritories(this->player, t)) {
+            int armies = a->getArmies() - committed[a];
+            if (armies > available) {
+                source = a;
+                available = armies;
             }
         }
 
-        Territory* source = adjacent[0];
-        if (adjacent.size() > 1) {
-            int randomIndex = randomInt(0, adjacent.size() - 1);
-
-            source = adjacent[randomIndex];
-        }
-
-        int unitsToDeploy = randomInt(1, player->getPool());
+        int attackers = odds.attackersFor(t->getArmies(), this->parameters.attackConfidence, available);
+        if (attackers == 0)
+            continue;
+        std::cout
+            << "=== Attacking " << *t
+            << ", sending " << attackers << " armies, " << static_cast<int>(odds.conquest(attackers, t->getArmies()) * 100) << "% to win"
+            << std::endl;
+        committed[source] += attackers;
+        attacks++;
 
         this->player->getOrders().add(new AdvanceOrder(
             this->player,
             source,
             t,
-            unitsToDeploy,
+            attackers,
             this->deck));
     }
+    // Move the armies left behind the front one step closer to it
+    const auto& frontier = this->player->getFrontier();
+    if (this->map && !frontier.empty()) {
+        const DistanceTable& distances = this->map->getDistances();
+        for (auto t : this->player->getOwnedTerritories()) {
+            int moving = static_cast<int>((t->getArmies() - 1) * this->parameters.advanceShare);
+            if (t->getEnemyNeighbors() > 0 || moving < 1)
+                continue;
+            Territory* next = distances.stepTowards(t, frontier);
+            if (next) {
+                this->player->getOrders().add(new AdvanceOrder(
+                    this->player,
+                    t,
+                    next,
+                    moving,
+                    this->deck));
+            }
+        }
+    }
 
-    Card* card = this->player->getHand()->draw();
+    std::optional<Card> card = this->player->getHand()->draw();
     if (card) {
-        std::srand(std::time(0));
-        int willPlayCard = std::rand() % 2;
-
         // Leave it to chance to decide if they will use the card or keep it
-        if (willPlayCard) {
+        if (randomChance(this->player, this->parameters.cardChance)) {
             switch (card->getType()) {
             case CardType::BOMB: {
-                auto territoriesToAttack = this->player->toAttack();
-                if (territoriesToAttack.empty()) {
+                // The candidates of the attacks still stand, nothing was executed since
+                Territory* target = this->candidates.strongest();
+                if (!target) {
                     std::cout << this->player->getName() << " tried to play a Bomb card, but there's no territories to attack!" << std::endl;
                     return;
                 }
 
-                // Choose the last territory from the list to attack
-                Territory* target = territoriesToAttack[territoriesToAttack.size() - 1];
+                // Bomb the strongest territory, the attacks went for the weakest
                 this->player->getOrders().add(new BombOrder(this->player, target));
             } break;
             case CardType::REINFORCEMENT:
@@ -374,23 +780,11 @@ void AggressivePlayer::issueOrder() {
             case CardType::BLOCKADE: {
                 auto territoriesToDefend = this->player->toDefend();
 
-                // Pick the territory surrounded by the most enemies
-                Territory* target = territoriesToDefend[0];
-                int enemyCount = 0;
-                for (auto t : territoriesToDefend) {
-                    int enemies = 0;
-                    for (auto adjTerritory : t->getAdjacent()) {
-                        if (adjTerritory->getOwner() != player)
-                            enemies++;
-                    }
-
-                    if (enemies > enemyCount) {
-                        enemyCount = enemies;
-                        target = t;
-                    }
+                // Pick the territory threatened by the most armies
+                Territory* target = mostThreatened(this->player, this->map, territoriesToDefend);
+                if (target) {
+                    this->player->getOrders().add(new BlockadeOrder(this->player, target));
                 }
-
-                this->player->getOrders().add(new BlockadeOrder(this->player, target));
             } break;
             case CardType::AIRLIFT: {
                 auto territoriesToDefend = this->player->toDefend();
@@ -399,24 +793,9 @@ void AggressivePlayer::issueOrder() {
                     return;
                 }
 
-                // Airlift the armies from the strongest territory to the territory with the most enemies surrounding it
+                // Airlift the armies from the safest territory to the one threatened by the most armies
                 Territory* source = territoriesToDefend[0];
-                Territory* target = territoriesToDefend[1];
-                int enemyCount = 0;
-                for (auto t : territoriesToDefend) {
-                    if (t == source)
-                        continue;
-
-                    int enemies = 0;
-                    for (auto adjTerritory : t->getAdjacent()) {
-                        if (adjTerritory->getOwner() != player)
-                            enemies++;
-                    }
-                    if (enemies > enemyCount) {
-                        enemyCount = enemies;
-                        target = t;
-                    }
-                }
+                Territory* target = mostThreatened(this->player, this->map, territoriesToDefend, source);
 
                 // Leave at least one unit behind
                 this->player->getOrders().add(new AirliftOrder(this->player, source, target, source->getArmies() - 1));
@@ -441,61 +820,84 @@ void AggressivePlayer::issueOrder() {
             } break;
             }
         } else {
-            this->player->getHand()->addCard(card);
+            this->player->getHand()->addCard(*card);
         }
     }
 }
 
 std::vector<Territory*> AggressivePlayer::toDefend() {
-    std::vector<std::tuple<Territory*, int>> territoriesWithEnemies;
-
     // Aggressive players prioritize defending territories connected to enemies
-    for (Territory* territory : player->getOwnedTerritories()) {
-        int enemyTerritories = 0;
-        std::vector<Territory*> adjacentTerritories = territory->getAdjacent();
-        for (auto adjTerritory : adjacentTerritories) {
-            Player* territoryOwner = adjTerritory->getOwner();
-            if (territoryOwner != player && territoryOwner != nullptr && !player->isFriendsWith(territoryOwner))
-                enemyTerritories++;
-        }
-        // Add the territory and how many enemy territories surround it
-        territoriesWithEnemies.emplace_back(territory, enemyTerritories);
-    }
-
-    // Sort the territories based on how many enemy territories surround it
-    // Prioritize the most armies first
-    std::sort(territoriesWithEnemies.begin(), territoriesWithEnemies.end(), [](auto const tup1, auto const tup2) {
-        return std::get<1>(tup1) < std::get<1>(tup2);
-    });
+    return territoriesByEnemies(this->player);
+}
 
+std::vector<Territory*> AggressivePlayer::toAttack() {
+    // Aggressive players prioritize attacking territories with fewer armies (Easier targets)
+    this->candidates.collect(this->player);
     std::vector<Territory*> territories;
-    for (auto territory : territoriesWithEnemies) {
-        // Get the territory back from the tuple
-        territories.push_back(std::get<0>(territory));
+    territories.reserve(this->candidates.size());
+    while (Territory* t = this->candidates.next()) {
+        territories.push_back(t);
     }
-
     return territories;
 }
 
-std::vector<Territory*> AggressivePlayer::toAttack() {
-    std::vector<Territory*> territories;
+// The weakest territory at the front of the heap
+static bool strongerThan(const Territory* a, const Territory* b) {
+    return a->getArmies() > b->getArmies();
+}
 
-    // Aggressive players prioritize attacking territories with fewer enemies
-    for (Territory* territory : player->getOwnedTerritories()) {
-        std::vector<Territory*> adjacentTerritories = territory->getAdjacent();
-        for (auto adjTerritory : adjacentTerritories) {
+void AttackCandidates::collect(Player* player) {
+    this->heap.clear();
+    this->strongestCandidate = nullptr;
+    if (++this->generation == 0) {
+        // Wrapped around, the old marks could pass for the new ones
+        std::fill(this->seen.begin(), this->seen.end(), 0);
+        this->generation = 1;
+    }
+    for (Territory* territory : player->getFrontier()) {
+        for (auto adjTerritory : territory->getAdjacent()) {
             Player* territoryOwner = adjTerritory->getOwner();
-            if (territoryOwner != player && territoryOwner != nullptr && !player->isFriendsWith(territoryOwner))
-                territories.push_back(adjTerritory);
+            if (territoryOwner == player || territoryOwner == nullptr || player->isFriendsWith(territoryOwner))
+                continue;
+            std::size_t index = adjTerritory->getIndex();
+            if (index == static_cast<std::size_t>(-1)) {
+                // Outside of any map, only a search tells whether it was seen
+                if (std::find(this->heap.begin(), this->heap.end(), adjTerritory) != this->heap.end())
+                    continue;
+            } else {
+                if (index >= this->seen.size()) {
+                    this->seen.resize(index + 1, 0);
+                }
+                if (this->seen[index] == this->generation)
+                    continue;
+                this->seen[index] = this->generation;
+            }
+            this->heap.push_back(adjTerritory);
+            if (!this->strongestCandidate || adjTerritory->getArmies() > this->strongestCandidate->getArmies()) {
+                this->strongestCandidate = adjTerritory;
+            }
         }
     }
+    std::make_heap(this->heap.begin(), this->heap.end(), strongerThan);
+    this->collected = this->heap.size();
+}
 
-    // Sort by least amount of enemies (Easier targets)
-    std::sort(territories.begin(), territories.end(), [](const Territory* territory1, const Territory* territory2) {
-        return territory1->getArmies() < territory2->getArmies();
-    });
+Territory* AttackCandidates::next() {
+    if (this->heap.empty()) {
+        return nullptr;
+    }
+    std::pop_heap(this->heap.begin(), this->heap.end(), strongerThan);
+    Territory* weakest = this->heap.back();
+    this->heap.pop_back();
+    return weakest;
+}
 
-    return territories;
+Territory* AttackCandidates::strongest() const {
+    return this->strongestCandidate;
+}
+
+std::size_t AttackCandidates::size() const {
+    return this->collected;
 }
 
 void BenevolentPlayer::issueOrder() {
@@ -503,7 +905,7 @@ void BenevolentPlayer::issueOrder() {
         if (player->getPool() <= 0)
             return;
 
-        int unitsToDeploy = randomInt(1, player->getPool());
+        int unitsToDeploy = deployment(this->player, this->parameters.deployShare);
 
         this->player->getOrders().add(new DeployOrder(
             this->player,
@@ -511,11 +913,9 @@ void BenevolentPlayer::issueOrder() {
             unitsToDeploy));
     }
 
-    Card* card = this->player->getHand()->draw();
+    std::optional<Card> card = this->player->getHand()->draw();
     if (card) {
-        int willPlayCard = randomInt(0, 1);
-
-        if (willPlayCard) {
+        if (randomChance(this->player, this->parameters.cardChance)) {
             switch (card->getType()) {
 
             case CardType::BOMB:
@@ -537,22 +937,7 @@ void BenevolentPlayer::issueOrder() {
                 }
 
                 Territory* source = territoriesToDefend[0];
-                Territory* target = territoriesToDefend[1];
-                int enemyCount = 0;
-                for (auto t : territoriesToDefend) {
-                    if (t == source)
-                        continue;
-
-                    int enemies = 0;
-                    for (auto adjTerritory : t->getAdjacent()) {
-                        if (adjTerritory->getOwner() != player)
-                            enemies++;
-                    }
-                    if (enemies > enemyCount) {
-                        enemyCount = enemies;
-                        target = t;
-                    }
-                }
+                Territory* target = mostThreatened(this->player, this->map, territoriesToDefend, source);
 
                 this->player->getOrders().add(new AirliftOrder(this->player, source, target, source->getArmies() - 1));
 
@@ -577,35 +962,13 @@ void BenevolentPlayer::issueOrder() {
             } break;
             }
         } else {
-            this->player->getHand()->addCard(card);
+            this->player->getHand()->addCard(*card);
         }
     }
 }
 
 std::vector<Territory*> BenevolentPlayer::toDefend() {
-    std::vector<std::tuple<Territory*, int>> territoriesWithEnemies;
-
-    for (Territory* territory : player->getOwnedTerritories()) {
-        int enemyTerritories = 0;
-        std::vector<Territory*> adjacentTerritories = territory->getAdjacent();
-        for (auto adjTerritory : adjacentTerritories) {
-            Player* territoryOwner = adjTerritory->getOwner();
-            if (territoryOwner != player && territoryOwner != nullptr && !player->isFriendsWith(territoryOwner))
-                enemyTerritories++;
-        }
-        territoriesWithEnemies.emplace_back(territory, enemyTerritories);
-    }
-
-    std::sort(territoriesWithEnemies.begin(), territoriesWithEnemies.end(), [](auto const tup1, auto const tup2) {
-        return std::get<1>(tup1) < std::get<1>(tup2);
-    });
-
-    std::vector<Territory*> territories;
-    for (auto territory : territoriesWithEnemies) {
-        territories.push_back(std::get<0>(territory));
-    }
-
-    return territories;
+    return territoriesByEnemies(this->player);
 }
 
 std::vector<Territory*> BenevolentPlayer::toAttack() {
@@ -617,8 +980,10 @@ void NeutralPlayer::issueOrder() {
     // Neutral players don't actually issue orders, but become aggressive when attacked
     if (this->player->getPool() != INITIAL_POOL_AMOUNT) {
         std::cout << this->player->getName() << " got attacked! They are now aggressive!" << std::endl;
-        this->player->setStrategy(new AggressivePlayer(this->map, this->deck, this->players));
-        this->player->issueOrder();
+        // Switching replaces this strategy in place, so nothing of it may be used afterwards
+        Player* player = this->player;
+        player->setStrategy(AggressivePlayer(*this));
+        player->issueOrder();
     } else {
         std::cout << this->player->getName() << " does nothing!" << std::endl;
     }
@@ -642,12 +1007,8 @@ void CheaterPlayer::issueOrder() {
     }
 
     for (auto& t : this->player->toAttack()) {
-        for (auto& p : this->player->getOwnedTerritories()) {
-            const auto& adj = t->getAdjacent();
-            auto it = std::find(adj.begin(), adj.end(), p);
-            if (it != adj.end()) {
-                this->player->getOrders().add(new AdvanceOrder(this->player, p, t, 999, nullptr));
-            }
+        for (auto& p : ownedAdjacentTerritories(this->player, t)) {
+            this->player->getOrders().add(new AdvanceOrder(this->player, p, t, 999, nullptr));
         }
     }
 }
@@ -1,58 +1,279 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <optional>
 #include <ostream>
+#include <string>
 #include <tuple>
+#include <variant>
 #include <vector>
 
 #include "Cards.h"
 #include "Map.h"
 #include "Player.fwd.h"
 
+class HumanPlayer;
+class AggressivePlayer;
+class BenevolentPlayer;
+class NeutralPlayer;
+class CheaterPlayer;
+
+/**
+ * @brief One of the strategies, held by value in a Player.
+ */
+using Strategy = std::variant<HumanPlayer, AggressivePlayer, BenevolentPlayer, NeutralPlayer, CheaterPlayer>;
+
+/**
+ * @brief The knobs of the computer strategies, the defaults play as the strategies always have.
+ *
+ * Every strategy carries its own copy, so players with the same strategy can play differently,
+ * which is what the Tuner needs to pit candidate parameters against the defaults.
+ */
+struct StrategyParameters {
+    /** @brief Chance to play the card drawn each turn rather than keep it. */
+    double cardChance = 0.5;
+    /** @brief Aggressive players only attack when they conquer at least this often. */
+    double attackConfidence = 0.75;
+    /** @brief Largest share of the pool deployed on one territory, each deployment is random up to it. */
+    double deployShare = 1.0;
+    /** @brief Share of the armies behind the front that aggressive players move towards it each turn. */
+    double advanceShare = 1.0;
+    /** @brief Most attacks aggressive players order each turn, 0 for as many as they can afford. */
+    std::size_t attackLimit = 0;
+};
+
+std::ostream& operator<<(std::ostream& out, const StrategyParameters& parameters);
+
+/**
+ * @class PlayerStrategy
+ *
+ * @brief What every strategy knows about the game: its player, the map, the deck and the other players.
+ *
+ * The strategies below derive from it without virtual functions, a Player holds one of them by value
+ * in a Strategy and dispatches to it with std::visit, so the calls can be inlined and switching
+ * strategy never allocates.
+ */
 class PlayerStrategy {
 protected:
     Player* player;
     Map* map;
     Deck* deck;
     std::vector<Player*>* players;
+    StrategyParameters parameters;
 
 public:
     PlayerStrategy(Map* map, Deck* deck, std::vector<Player*>* players);
     PlayerStrategy();
     PlayerStrategy(const PlayerStrategy& other);
-    virtual ~PlayerStrategy() = default;
-
-    virtual PlayerStrategy* clone() const = 0;
-    virtual std::string name() const = 0;
-    virtual void issueOrder() = 0;
-    virtual std::vector<Territory*> toDefend() = 0;
-    virtual std::vector<Territory*> toAttack() = 0;
+    ~PlayerStrategy() = default;
 
     PlayerStrategy& operator=(const PlayerStrategy& other);
-    friend std::ostream& operator<<(std::ostream& out, const PlayerStrategy& playerStrategy);
+
+    const StrategyParameters& getParameters() const;
+    void setParameters(const StrategyParameters& parameters);
+
+    friend std::ostream& operator<<(std::ostream& out, const Strategy& strategy);
     friend class Player;
 };
 
 #define STRATEGY_BOILERPLATE(Type)                                         \
-    class Type##Player : public PlayerStrategy {                           \
+    class Type##Player final : public PlayerStrategy {                     \
     public:                                                                \
         Type##Player(Map* map, Deck* deck, std::vector<Player*>* players); \
         Type##Player();                                                    \
         Type##Player(const Type##Player& other);                           \
-        ~Type##Player() override = default;                                \
+        /** @brief Takes over the game of another strategy. */           \
+        explicit Type##Player(const PlayerStrategy& context);              \
+        ~Type##Player() = default;                                         \
                                                                            \
-        PlayerStrategy* clone() const override;                            \
-        std::string name() const override;                                 \
-        void issueOrder() override;                                        \
-        std::vector<Territory*> toDefend() override;                       \
-        std::vector<Territory*> toAttack() override;                       \
+        std::string name() const;                                          \
+        void issueOrder();                                                 \
+        std::vector<Territory*> toDefend();                                \
+        std::vector<Territory*> toAttack();                                \
                                                                            \
         Type##Player& operator=(const Type##Player& other);                \
     };
 
-STRATEGY_BOILERPLATE(Human)
-STRATEGY_BOILERPLATE(Aggressive)
 STRATEGY_BOILERPLATE(Benevolent)
 STRATEGY_BOILERPLATE(Neutral)
 STRATEGY_BOILERPLATE(Cheater)
 
 #undef STRATEGY_BOILERPLATE
+
+/**
+ * @class AttackCandidates
+ *
+ * @brief The enemy territories next to a player, each once, handed out from the one with the fewest armies on.
+ *
+ * collect gathers them in one pass over the player's frontier, skipping the duplicates with a mark
+ * per territory, and heapifies them in linear time; next then pops one in O(log n). A player that
+ * stops after k attacks pays O(E + k log E) rather than sorting every adjacency of its frontier.
+ */
+class AttackCandidates {
+public:
+    /**
+     * @brief Gather the candidates of the player as the board stands, forgetting the previous ones.
+     *
+     * Territories of friends and of no one are left out.
+     */
+    void collect(Player* player);
+    /**
+     * @brief The weakest candidate not handed out yet, nullptr once they all were.
+     */
+    Territory* next();
+    /** @brief The candidate with the most armies, handed out or not, nullptr if there is none. */
+    Territory* strongest() const;
+    /** @brief Number of candidates collected. */
+    std::size_t size() const;
+
+private:
+    std::vector<Territory*> heap;
+    /** @brief Generation in which each territory, by index, was last collected. */
+    std::vector<std::uint32_t> seen;
+    std::uint32_t generation = 0;
+    Territory* strongestCandidate = nullptr;
+    std::size_t collected = 0;
+};
+
+/**
+ * @class AggressivePlayer
+ *
+ * @brief Deploys on its frontier and attacks the weakest enemy territories it can take, at most attackLimit a turn.
+ *
+ * The candidates gathered for the attacks of a turn are kept for the cards played in the same turn.
+ */
+class AggressivePlayer final : public PlayerStrategy {
+public:
+    AggressivePlayer(Map* map, Deck* deck, std::vector<Player*>* players);
+    AggressivePlayer();
+    AggressivePlayer(const AggressivePlayer& other);
+    /** @brief Takes over the game of another strategy. */
+    explicit AggressivePlayer(const PlayerStrategy& context);
+    ~AggressivePlayer() = default;
+
+    std::string name() const;
+    void issueOrder();
+    std::vector<Territory*> toDefend();
+    /**
+     * @brief Every candidate, weakest first.
+     */
+    std::vector<Territory*> toAttack();
+
+    AggressivePlayer& operator=(const AggressivePlayer& other);
+
+private:
+    AttackCandidates candidates;
+};
+
+/**
+ * @class HumanPlayer
+ *
+ * @brief Asks its orders one question at a time, and waits for the answers without holding a thread.
+ *
+ * A turn is a state machine: beginTurn asks the first question, prompt tells which one is waiting,
+ * and answer takes the answer and moves to the next question, until the turn is over and prompt
+ * returns nothing. issueOrder drives it from the console, the Game drives it from applyCommand,
+ * so a server can host many games with humans on one thread, each waiting for its own client.
+ */
+class HumanPlayer final : public PlayerStrategy {
+public:
+    HumanPlayer(Map* map, Deck* deck, std::vector<Player*>* players);
+    HumanPlayer();
+    HumanPlayer(const HumanPlayer& other);
+    /** @brief Takes over the game of another strategy. */
+    explicit HumanPlayer(const PlayerStrategy& context);
+    ~HumanPlayer() = default;
+
+    std::string name() const;
+    /**
+     * @brief Play a whole turn, reading the answers from the console.
+     */
+    void issueOrder();
+    std::vector<Territory*> toDefend();
+    std::vector<Territory*> toAttack();
+
+    /**
+     * @brief Start a turn, forgetting whatever was left of the previous one.
+     */
+    void beginTurn();
+    /**
+     * @brief The question waiting for an answer, with its options, nothing once the turn is over.
+     */
+    std::optional<std::string> prompt() const;
+    /**
+     * @brief Answer the waiting question, issuing the orders it completes.
+     *
+     * @return Why the answer was refused, the question then stays, or an empty string.
+     */
+    std::string answer(const std::string& line);
+
+    HumanPlayer& operator=(const HumanPlayer& other);
+
+private:
+    /** @brief The question a turn is waiting on. */
+    enum class Step : char {
+        Idle,
+        Defend,
+        Deploy,
+        Attack,
+        Source,
+        Armies,
+        Card,
+        Bomb,
+        Blockade,
+        AirliftSource,
+        AirliftTarget,
+        AirliftArmies,
+        Negotiate,
+    };
+
+    Step step = Step::Idle;
+    /** @brief Territories the question offers. */
+    std::vector<Territory*> options;
+    /** @brief Players the question offers. */
+    std::vector<Player*> others;
+    /** @brief Territories chosen to defend or attack, and the one the turn is at. */
+    std::vector<Territory*> chosen;
+    size_t index = 0;
+    Territory* source = nullptr;
+    Territory* target = nullptr;
+    std::optional<Card> card;
+
+    void askDeploy();
+    void askAttack();
+    void askSource();
+    void askCard();
+    /** @brief Ask to pick one of the options, picking it right away when there is only one. */
+    void askOne(Step step);
+    void picked(Territory* territory);
+    void finish();
+};
+
+/**
+ * @brief Name of the strategy held, "Aggressive" for an AggressivePlayer.
+ */
+std::string strategyName(const Strategy& strategy);
+
+/**
+ * @brief Whether issueOrder only reads the board and needs no input.
+ *
+ * Humans wait on the console and cheaters conquer as they issue, every other strategy
+ * can issue its orders at the same time as other players.
+ */
+bool readsBoardOnly(const Strategy& strategy);
+
+/**
+ * @brief Whether the strategy never takes a territory: neutral players only turn aggressive when attacked
+ * and benevolent players only reinforce, so a game where every player is passive cannot change anymore.
+ */
+bool isPassive(const Strategy& strategy);
+
+/**
+ * @brief Strategy named like in the tournament command, `human`, `aggressive`, `benevolent`, `neutral` or `cheater`.
+ *
+ * @return The strategy, not yet in a game, or nothing if the name is not a strategy.
+ */
+std::optional<Strategy> strategyFromName(const std::string& name);
+
+std::ostream& operator<<(std::ostream& out, const Strategy& strategy);
@@ -1,7 +1,16 @@
 #include "PlayerStrategiesDriver.h"
 #include "Cards.fwd.h"
 #include "Player.h"
+#include "MapCache.h"
+#include "Orders.h"
 #include "PlayerStrategies.h"
+#include "Profiler.h"
+#include "QuietConsole.h"
+#include "Tuner.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
 
 void testHumanStrategy() {
     std::ifstream file("./res/map/lp.map");
@@ -9,15 +18,15 @@ void testHumanStrategy() {
     Deck* deck = new Deck();
     std::vector<Player*> players;
 
-    PlayerStrategy* _friendStrategy = new HumanPlayer(map, deck, &players);
+    HumanPlayer _friendStrategy(map, deck, &players);
     Player* _friend = new Player("Willem Dafriend", _friendStrategy);
     players.push_back(_friend);
 
-    PlayerStrategy* strategy = new HumanPlayer(map, deck, &players);
+    HumanPlayer strategy(map, deck, &players);
     Player* player = new Player("John Warzone", strategy);
     players.push_back(player);
 
-    player->getHand()->addCard(new Card(CardType::DIPLOMACY));
+    player->getHand()->addCard(Card(CardType::DIPLOMACY));
 
     player->addTerritory(map->findTerritory("1L"));
     player->addTerritory(map->findTerritory("8LS"));
@@ -39,16 +48,16 @@ void testAggressiveStrategy() {
     Deck* deck = new Deck();
     std::vector<Player*> players;
 
-    PlayerStrategy* aggroStrategy = new AggressivePlayer(map, deck, &players);
+    AggressivePlayer aggroStrategy(map, deck, &players);
     Player* foe = new Player("Willem Dafoe", aggroStrategy);
     players.push_back(foe);
 
-    PlayerStrategy* humanStrategy = new HumanPlayer(map, deck, &players);
+    HumanPlayer humanStrategy(map, deck, &players);
     Player* player = new Player("John Warzone", humanStrategy);
     players.push_back(player);
 
     // May or may not be played given that playing a card is 50/50
-    foe->getHand()->addCard(new Card(CardType::BOMB));
+    foe->getHand()->addCard(Card(CardType::BOMB));
 
     player->addTerritory(map->findTerritory("1L"));
     foe->addTerritory(map->findTerritory("2L"));
@@ -67,17 +76,72 @@ void testAggressiveStrategy() {
     file.close();
 }
 
+void testAttackCandidates() {
+    Map* map = MapCache::instance().load("res/map/King of the Hills.map");
+    Deck* deck = new Deck();
+    std::vector<Player*> players;
+    players.push_back(new Player("Ann", AggressivePlayer(map, deck, &players)));
+    players.push_back(new Player("Bob", BenevolentPlayer(map, deck, &players)));
+    for (size_t i = 0; i < map->getNumberTerritories(); i++) {
+        players[i % 2]->addTerritory(map->findTerritoryByIndex(i));
+        map->findTerritoryByIndex(i)->setArmies(static_cast<int>(i % 11) + 1);
+    }
+
+    // Every enemy neighbor once, weakest first
+    std::vector<Territory*> expected;
+    for (Territory* t : players[0]->getFrontier()) {
+        for (auto a : t->getAdjacent()) {
+            if (a->getOwner() == players[1] && std::find(expected.begin(), expected.end(), a) == expected.end()) {
+                expected.push_back(a);
+            }
+        }
+    }
+    std::vector<Territory*> candidates = players[0]->toAttack();
+    bool sorted = std::is_sorted(candidates.begin(), candidates.end(), [](const Territory* a, const Territory* b) { return a->getArmies() < b->getArmies(); });
+    std::sort(candidates.begin(), candidates.end());
+    std::sort(expected.begin(), expected.end());
+    std::cout << "Candidates are every enemy neighbor once: " << (candidates == expected) << std::endl
+              << "Candidates come weakest first: " << sorted << std::endl;
+
+    // The limit caps the attacks of a turn
+    StrategyParameters parameters;
+    parameters.attackLimit = 3;
+    parameters.cardChance = 0.0;
+    AggressivePlayer limited(map, deck, &players);
+    limited.setParameters(parameters);
+    players[0]->setStrategy(limited);
+    for (Territory* t : players[0]->getOwnedTerritories()) {
+        t->setArmies(100);
+    }
+    players[0]->addReinforcementToPool(10);
+    players[0]->issueOrder();
+    size_t advances = 0;
+    while (Order* order = players[0]->getNextOrder()) {
+        // Only the attacks go to territories of others
+        AdvanceOrder* advance = dynamic_cast<AdvanceOrder*>(order);
+        advances += advance && advance->target->getOwner() != players[0];
+        delete order;
+    }
+    std::cout << "Attacks stop at the limit: " << (advances == 3) << std::endl;
+
+    for (Player* p : players) {
+        delete p;
+    }
+    delete deck;
+    delete map;
+}
+
 void testBenevolentStrategy() {
     std::ifstream file("./res/map/lp.map");
     Map* map = MapLoader(file).parse();
     Deck* deck = new Deck();
     std::vector<Player*> players;
 
-    PlayerStrategy* benStrategy = new BenevolentPlayer(map, deck, &players);
+    BenevolentPlayer benStrategy(map, deck, &players);
     Player* ben = new Player("Willem DaBenevolent", benStrategy);
     players.push_back(ben);
 
-    PlayerStrategy* aggroStrategy = new AggressivePlayer(map, deck, &players);
+    AggressivePlayer aggroStrategy(map, deck, &players);
     Player* foe = new Player("Willem Dafoe", aggroStrategy);
     players.push_back(foe);
 
@@ -108,16 +172,16 @@ void testNeutralStrategy() {
     Deck* deck = new Deck();
     std::vector<Player*> players;
 
-    PlayerStrategy* aggroStrategy = new AggressivePlayer(map, deck, &players);
+    AggressivePlayer aggroStrategy(map, deck, &players);
     Player* foe = new Player("Willem Dafoe", aggroStrategy);
     players.push_back(foe);
 
-    PlayerStrategy* neutralStrategy = new NeutralPlayer(map, deck, &players);
+    NeutralPlayer neutralStrategy(map, deck, &players);
     Player* neutral = new Player("Willem DaAcquaintance", neutralStrategy);
     players.push_back(neutral);
 
     // May or may not be played given that playing a card is 50/50
-    foe->getHand()->addCard(new Card(CardType::BOMB));
+    foe->getHand()->addCard(Card(CardType::BOMB));
 
     neutral->addTerritory(map->findTerritory("1L"));
     foe->addTerritory(map->findTerritory("2L"));
@@ -150,7 +214,7 @@ void testCheaterStrategy() {
     Map* map = MapLoader(file).parse();
     Deck* deck = new Deck();
     std::vector<Player*> players;
-    PlayerStrategy* strategy = new CheaterPlayer(map, deck, &players);
+    CheaterPlayer strategy(map, deck, &players);
     Player* player = new Player("John Warzone", strategy);
     players.push_back(player);
 
@@ -166,3 +230,135 @@ void testCheaterStrategy() {
     delete map;
     file.close();
 }
+
+// The same strategy behind a virtual call, the way Player dispatched before strategies became a variant
+class VirtualStrategy {
+public:
+    virtual ~VirtualStrategy() = default;
+    virtual std::vector<Territory*> toDefend() = 0;
+    virtual std::vector<Territory*> toAttack() = 0;
+    virtual void issueOrder() = 0;
+};
+
+template <typename S>
+class VirtualAdapter : public VirtualStrategy {
+public:
+    VirtualAdapter(const S& strategy)
+        : strategy(strategy) { }
+    std::vector<Territory*> toDefend() override { return strategy.toDefend(); }
+    std::vector<Territory*> toAttack() override { return strategy.toAttack(); }
+    void issueOrder() override { strategy.issueOrder(); }
+
+private:
+    S strategy;
+};
+
+void testStrategyDispatch() {
+    Map* map = MapCache::instance().load("res/map/King of the Hills.map");
+    Deck* deck = new Deck();
+    std::vector<Player*> players;
+    players.push_back(new Player("Ann", AggressivePlayer(map, deck, &players)));
+    players.push_back(new Player("Bob", BenevolentPlayer(map, deck, &players)));
+    players.push_back(new Player("Cid", AggressivePlayer(map, deck, &players)));
+    players.push_back(new Player("Dee", NeutralPlayer(map, deck, &players)));
+    for (size_t i = 0; i < map->getNumberTerritories(); i++) {
+        players[i % players.size()]->addTerritory(map->findTerritoryByIndex(i));
+    }
+
+    // A neutral player turning aggressive swaps its strategy in place
+    Profiler& profiler = Profiler::instance();
+    profiler.enable("strategies", false);
+    players[3]->setStrategy(AggressivePlayer(map, deck, &players));
+    std::uint64_t allocations = profiler.get(Profiler::Counter::Allocations);
+    profiler.disable();
+    profiler.reset();
+    std::cout << "Switching strategy allocates nothing: " << (allocations == 0) << std::endl
+              << "Dee is now " << strategyName(players[3]->getStrategy()) << std::endl;
+
+    std::vector<std::unique_ptr<VirtualStrategy>> virtuals;
+    for (Player* p : players) {
+        virtuals.push_back(std::visit([](const auto& s) -> std::unique_ptr<VirtualStrategy> {
+            return std::make_unique<VirtualAdapter<std::decay_t<decltype(s)>>>(s);
+        },
+            p->getStrategy()));
+    }
+
+    // The orders are thrown away, so every turn starts from the same board
+    auto discardOrders = [](Player* p) {
+        size_t issued = 0;
+        while (Order* order = p->getNextOrder()) {
+            delete order;
+            issued++;
+        }
+        return issued;
+    };
+    for (Player* p : players) {
+        p->addReinforcementToPool(10);
+    }
+
+    // One turn asks every player what it defends and attacks, then has it issue its orders
+    const int turns = 500;
+    size_t variantTotal = 0;
+    size_t virtualTotal = 0;
+    std::chrono::duration<double> variantTime {};
+    std::chrono::duration<double> virtualTime {};
+    {
+        QuietConsole quiet;
+        auto start = std::chrono::steady_clock::now();
+        for (int turn = 0; turn < turns; turn++) {
+            for (Player* p : players) {
+                variantTotal += p->toDefend().size() + p->toAttack().size();
+                p->issueOrder();
+                variantTotal += discardOrders(p);
+            }
+        }
+        variantTime = std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        for (int turn = 0; turn < turns; turn++) {
+            for (size_t i = 0; i < virtuals.size(); i++) {
+                virtualTotal += virtuals[i]->toDefend().size() + virtuals[i]->toAttack().size();
+                virtuals[i]->issueOrder();
+                virtualTotal += discardOrders(players[i]);
+            }
+        }
+        virtualTime = std::chrono::steady_clock::now() - start;
+    }
+
+    std::cout << "Both dispatches play the same turns: " << (variantTotal == virtualTotal) << std::endl
+              << "Turns per second, variant: " << static_cast<long>(turns / variantTime.count())
+              << ", virtual: " << static_cast<long>(turns / virtualTime.count()) << std::endl;
+
+    for (Player* p : players) {
+        delete p;
+    }
+    delete deck;
+    delete map;
+}
+
+void testTuner() {
+    auto [lower, upper] = Tuner::wilson(50, 100);
+    std::cout << "Wilson interval of 50 wins in 100 games is [0.404, 0.596]: "
+              << (std::abs(lower - 0.404) < 0.001 && std::abs(upper - 0.596) < 0.001) << std::endl
+              << "and stays inside [0, 1] without wins: " << (Tuner::wilson(0, 10).first == 0.0) << std::endl;
+
+    Tuner::Options options;
+    options.maps = { "res/map/lp.map", "res/map/Cobra.map" };
+    options.games = 20;
+    options.turns = 30;
+    options.generations = 3;
+    options.offspring = 4;
+    options.processes = 2;
+    Tuner tuner(options);
+
+    // Every candidate plays the same seeds, so the same candidate gets the same score
+    Tuner::Evaluation first = tuner.evaluate(StrategyParameters());
+    Tuner::Evaluation second = tuner.evaluate(StrategyParameters());
+    std::cout << "The same parameters play the same games: "
+              << (first.wins == second.wins && first.draws == second.draws && first.losses == second.losses) << std::endl;
+
+    Tuner::Evaluation best = tuner.tune();
+    std::cout << "Best " << best << std::endl
+              << "The best candidate scores at least as well as the defaults: " << (best.score() >= first.score()) << std::endl
+              << tuner << std::endl;
+}
@@ -2,6 +2,9 @@
 
 void testHumanStrategy();
 void testAggressiveStrategy();
+void testAttackCandidates();
 void testBenevolentStrategy();
 void testNeutralStrategy();
 void testCheaterStrategy();
+void testStrategyDispatch();
+void testTuner();
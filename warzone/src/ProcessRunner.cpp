@@ -0,0 +1,359 @@
+#include "ProcessRunner.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sched.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#define WARZONE_HAS_FORK 1
+#endif
+
+ProcessRunner::ProcessRunner(std::size_t workers, std::string journal)
+    : workers(std::max<std::size_t>(workers, 1))
+    , journal(std::move(journal))
+    , respawns(0)
+    , resumed(0) {
+}
+
+std::size_t ProcessRunner::getRespawns() const {
+    return this->respawns;
+}
+
+std::size_t ProcessRunner::getResumed() const {
+    return this->resumed;
+}
+
+// Results are escaped in the journal, a tab or a newline in one would cut its line
+static std::string escape(const std::string& result) {
+    std::string escaped;
+    escaped.reserve(result.size());
+    for (char c : result) {
+        if (c == '\\') {
+            escaped += "\\\\";
+        } else if (c == '\t') {
+            escaped += "\\t";
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else if (c == '\r') {
+            escaped += "\\r";
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+static std::string unescape(const std::string& escaped) {
+    std::string result;
+    result.reserve(escaped.size());
+    for (std::size_t i = 0; i < escaped.size(); i++) {
+        if (escaped[i] != '\\' || i + 1 == escaped.size()) {
+            result += escaped[i];
+            continue;
+        }
+        char c = escaped[++i];
+        result += c == 't' ? '\t' : c == 'n' ? '\n' : c == 'r' ? '\r' : c;
+    }
+    return result;
+}
+
+static void writeJournal(std::ofstream& journal, std::size_t index, const std::string& result) {
+    if (journal.is_open()) {
+        journal << index << '\t' << escape(result) << std::endl;
+    }
+}
+
+// The journal starts with the signature, then holds one "index<TAB>result" line per finished job
+static void readJournal(const std::string& path, const std::string& signature, std::vector<std::string>& results, std::vector<bool>& done) {
+    std::ifstream in(path);
+    std::string line;
+    if (!std::getline(in, line) || line != signature) {
+        std::ofstream(path, std::ios::trunc) << signature << '\n';
+        return;
+    }
+    while (std::getline(in, line)) {
+        std::size_t tab = line.find('\t');
+        if (tab == std::string::npos) {
+            continue;
+        }
+        std::size_t index = std::stoul(line.substr(0, tab));
+        if (index < results.size()) {
+            results[index] = unescape(line.substr(tab + 1));
+            done[index] = true;
+        }
+    }
+}
+
+#ifdef WARZONE_HAS_FORK
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "the ring buffer needs address-free atomics to be shared between processes");
+
+namespace {
+
+// Job states in shared memory, a running job holds the number of its worker
+constexpr std::uint32_t PENDING = 0;
+constexpr std::uint32_t DONE = 1;
+constexpr std::uint32_t RUNNING = 2;
+
+struct Slot {
+    std::uint32_t job;
+    char result[ProcessRunner::RESULT_SIZE];
+};
+
+// Results of one worker, which pushes while the parent pops. As each worker has its own ring, a worker
+// killed while writing a slot only leaves that slot unpublished, and the parent resets the ring before
+// the next worker takes the seat.
+struct Ring {
+    std::atomic<std::uint64_t> head;
+    std::atomic<std::uint64_t> tail;
+    Slot slots[ProcessRunner::RING_SLOTS];
+
+    void reset() {
+        this->head.store(0);
+        this->tail.store(0);
+    }
+
+    void push(std::uint32_t job, const std::string& result) {
+        std::uint64_t position = this->tail.load(std::memory_order_relaxed);
+        while (position - this->head.load(std::memory_order_acquire) >= ProcessRunner::RING_SLOTS) {
+            // Full, wait for the parent
+            sched_yield();
+        }
+        Slot& slot = this->slots[position % ProcessRunner::RING_SLOTS];
+        slot.job = job;
+        std::size_t length = std::min(result.size(), ProcessRunner::RESULT_SIZE - 1);
+        std::memcpy(slot.result, result.data(), length);
+        slot.result[length] = '\0';
+        this->tail.store(position + 1, std::memory_order_release);
+    }
+
+    bool pop(std::uint32_t& job, std::string& result) {
+        std::uint64_t position = this->head.load(std::memory_order_relaxed);
+        if (position == this->tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        const Slot& slot = this->slots[position % ProcessRunner::RING_SLOTS];
+        job = slot.job;
+        result = slot.result;
+        this->head.store(position + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+// Shared memory holds a ring per worker, then the state of every job
+struct Shared {
+    Ring* rings;
+    std::atomic<std::uint32_t>* states;
+
+    static std::size_t size(std::size_t workers, std::size_t jobs) {
+        return workers * sizeof(Ring) + jobs * sizeof(std::atomic<std::uint32_t>);
+    }
+};
+
+// Claim pending jobs until there are none left, then leave without running the parent's cleanup
+[[noreturn]] void work(const Shared& shared, std::size_t count, std::uint32_t worker, const std::function<std::string(std::size_t)>& job) {
+    for (std::size_t i = 0; i < count; i++) {
+        std::uint32_t expected = PENDING;
+        if (!shared.states[i].compare_exchange_strong(expected, RUNNING + worker)) {
+            continue;
+        }
+        std::string result;
+        try {
+            result = job(i);
+        } catch (std::exception& e) {
+            // The job failed, the worker did not: the parent records the error and does not run it again
+            result = std::string(ProcessRunner::FAILED) + e.what();
+        }
+        shared.rings[worker].push(static_cast<std::uint32_t>(i), result);
+    }
+    std::cout.flush();
+    std::cerr.flush();
+    _exit(0);
+}
+
+}
+
+std::vector<std::string> ProcessRunner::run(const std::string& signature, std::size_t count, const std::function<std::string(std::size_t)>& job) {
+    this->respawns = 0;
+    this->resumed = 0;
+    std::vector<std::string> results(count);
+    std::vector<bool> done(count, false);
+    if (!this->journal.empty()) {
+        readJournal(this->journal, signature, results, done);
+        this->resumed = static_cast<std::size_t>(std::count(done.begin(), done.end(), true));
+    }
+    std::ofstream journal;
+    if (!this->journal.empty()) {
+        journal.open(this->journal, std::ios::app);
+    }
+
+    std::size_t bytes = Shared::size(this->workers, count);
+    void* memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        throw std::runtime_error("Cannot map the shared memory of the workers");
+    }
+    // The children inherit the mapping at the same address, so they share these pointers
+    Shared shared;
+    shared.rings = static_cast<Ring*>(memory);
+    shared.states = reinterpret_cast<std::atomic<std::uint32_t>*>(shared.rings + this->workers);
+    for (std::size_t w = 0; w < this->workers; w++) {
+        new (&shared.rings[w]) Ring;
+        shared.rings[w].reset();
+    }
+    for (std::size_t i = 0; i < count; i++) {
+        new (&shared.states[i]) std::atomic<std::uint32_t>(done[i] ? DONE : PENDING);
+    }
+
+    std::vector<pid_t> pids(this->workers, -1);
+    std::vector<bool> crashed(this->workers, false);
+    std::vector<int> attempts(count, 0);
+    std::size_t remaining = count - this->resumed;
+
+    auto spawn = [&](std::uint32_t worker) {
+        // Buffered output would be written again by the child
+        std::cout.flush();
+        std::cerr.flush();
+        pid_t pid = fork();
+        if (pid < 0) {
+            throw std::runtime_error("Cannot fork a worker");
+        }
+        if (pid == 0) {
+            work(shared, count, worker, job);
+        }
+        pids[worker] = pid;
+    };
+    auto receive = [&](std::uint32_t worker) {
+        std::uint32_t index;
+        std::string result;
+        bool received = false;
+        while (shared.rings[worker].pop(index, result)) {
+            received = true;
+            if (done[index]) {
+                continue;
+            }
+            done[index] = true;
+            results[index] = result;
+            shared.states[index].store(DONE);
+            remaining--;
+            writeJournal(journal, index, result);
+        }
+        return received;
+    };
+
+    try {
+        while (remaining > 0) {
+            // Keep a worker in every free seat while jobs are pending
+            bool pending = false;
+            for (std::size_t i = 0; i < count && !pending; i++) {
+                pending = shared.states[i].load() == PENDING;
+            }
+            for (std::uint32_t w = 0; pending && w < this->workers; w++) {
+                if (pids[w] < 0) {
+                    this->respawns += crashed[w];
+                    crashed[w] = false;
+                    shared.rings[w].reset();
+                    spawn(w);
+                }
+            }
+
+            bool progress = false;
+            for (std::uint32_t w = 0; w < this->workers; w++) {
+                progress = receive(w) || progress;
+            }
+            // Only the workers are waited on, other children of the process are none of the runner's business
+            for (std::uint32_t worker = 0; worker < this->workers; worker++) {
+                int status;
+                if (pids[worker] < 0 || waitpid(pids[worker], &status, WNOHANG) != pids[worker]) {
+                    continue;
+                }
+                pids[worker] = -1;
+                // Results published before the worker died are in its ring, a slot it was still writing is not
+                receive(worker);
+                crashed[worker] = !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+                for (std::size_t i = 0; i < count; i++) {
+                    if (shared.states[i].load() != RUNNING + worker || done[i]) {
+                        continue;
+                    }
+                    crashed[worker] = true;
+                    if (++attempts[i] >= MAX_ATTEMPTS) {
+                        done[i] = true;
+                        results[i] = CRASHED;
+                        shared.states[i].store(DONE);
+                        remaining--;
+                        writeJournal(journal, i, CRASHED);
+                    } else {
+                        shared.states[i].store(PENDING);
+                    }
+                }
+                progress = true;
+            }
+            if (!progress) {
+                usleep(1000);
+            }
+        }
+    } catch (...) {
+        for (pid_t pid : pids) {
+            if (pid > 0) {
+                kill(pid, SIGKILL);
+                waitpid(pid, nullptr, 0);
+            }
+        }
+        munmap(memory, bytes);
+        throw;
+    }
+
+    // Workers leave once no job is pending
+    for (pid_t pid : pids) {
+        if (pid > 0) {
+            waitpid(pid, nullptr, 0);
+        }
+    }
+    munmap(memory, bytes);
+    return results;
+}
+
+#else
+
+// No fork, every job runs here
+std::vector<std::string> ProcessRunner::run(const std::string& signature, std::size_t count, const std::function<std::string(std::size_t)>& job) {
+    this->respawns = 0;
+    this->resumed = 0;
+    std::vector<std::string> results(count);
+    std::vector<bool> done(count, false);
+    if (!this->journal.empty()) {
+        readJournal(this->journal, signature, results, done);
+        this->resumed = static_cast<std::size_t>(std::count(done.begin(), done.end(), true));
+    }
+    std::ofstream journal;
+    if (!this->journal.empty()) {
+        journal.open(this->journal, std::ios::app);
+    }
+    for (std::size_t i = 0; i < count; i++) {
+        if (!done[i]) {
+            try {
+                results[i] = job(i).substr(0, RESULT_SIZE - 1);
+            } catch (std::exception& e) {
+                results[i] = (FAILED + std::string(e.what())).substr(0, RESULT_SIZE - 1);
+            }
+            writeJournal(journal, i, results[i]);
+        }
+    }
+    return results;
+}
+
+#endif
+
+std::ostream& operator<<(std::ostream& out, const ProcessRunner& runner) {
+    return out << "This ProcessRunner has " << runner.workers << " workers"
+               << (runner.journal.empty() ? "" : ", journal " + runner.journal)
+               << ", last run resumed " << runner.resumed << " jobs and respawned " << runner.respawns << " workers.";
+}
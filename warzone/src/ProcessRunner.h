@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/**
+ * @class ProcessRunner
+ *
+ * @brief Runs independent jobs, like the games of a tournament, in forked worker processes.
+ *
+ * Each worker is a copy of the process that claims pending jobs one at a time and sends back
+ * their results through its own ring buffer in shared memory. Code that is not thread safe (`std::rand`,
+ * the game log, the console) runs as it does in a single process, only on every core.
+ *
+ * A worker that crashes takes nothing else down: the job it was running goes back to pending,
+ * up to MAX_ATTEMPTS times, and a new worker takes its place. A job that throws is not a crash,
+ * its result is FAILED followed by the reason. With a journal file, finished jobs
+ * are recorded as they arrive, and running the same jobs again with the same journal only runs
+ * the jobs that did not finish.
+ *
+ * On platforms without `fork` the jobs run one after the other in the calling process.
+ */
+class ProcessRunner {
+public:
+    /** @brief Results of a worker waiting for the parent, the worker waits when its ring is full. */
+    static constexpr std::size_t RING_SLOTS = 64;
+    /** @brief Longest result, longer ones are cut. */
+    static constexpr std::size_t RESULT_SIZE = 56;
+    /** @brief Runs of a job that crash before it is given up. */
+    static constexpr int MAX_ATTEMPTS = 3;
+    /** @brief Result of a job given up after crashing MAX_ATTEMPTS times. */
+    static constexpr const char* CRASHED = "crashed";
+    /** @brief Start of the result of a job that threw, the reason follows. */
+    static constexpr const char* FAILED = "error: ";
+
+    /**
+     * @param workers Number of worker processes, at least one.
+     * @param journal File recording finished jobs, none if empty.
+     */
+    ProcessRunner(std::size_t workers, std::string journal = "");
+    ProcessRunner(const ProcessRunner& other) = delete;
+    ProcessRunner& operator=(const ProcessRunner& other) = delete;
+
+    /**
+     * @brief Run jobs 0 to count - 1 and return their results by index.
+     *
+     * @param signature Identifies the jobs in the journal, a journal written for other jobs is started over.
+     * @param job Runs in a worker and returns the result of the job with the given index.
+     */
+    std::vector<std::string> run(const std::string& signature, std::size_t count, const std::function<std::string(std::size_t)>& job);
+
+    /** @brief Workers started to replace crashed ones during the last run. */
+    std::size_t getRespawns() const;
+    /** @brief Jobs of the last run found finished in the journal. */
+    std::size_t getResumed() const;
+
+    friend std::ostream& operator<<(std::ostream& out, const ProcessRunner& runner);
+
+private:
+    std::size_t workers;
+    std::string journal;
+    std::size_t respawns;
+    std::size_t resumed;
+};
@@ -0,0 +1,253 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <thread>
+
+// Every allocation of the program goes through here, counted only while profiling
+void* operator new(std::size_t size) {
+    Profiler::count(Profiler::Counter::Allocations);
+    if (size == 0) {
+        size = 1;
+    }
+    while (true) {
+        if (void* p = std::malloc(size)) {
+            return p;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+Profiler::Scope::Scope(std::string name)
+    : name(std::move(name)) {
+    if (!this->name.empty()) {
+        this->start = std::chrono::steady_clock::now();
+    }
+}
+
+Profiler::Scope::~Scope() {
+    if (!this->name.empty()) {
+        Profiler::instance().record(this->name, this->start, std::chrono::steady_clock::now());
+    }
+}
+
+Profiler::Profiler()
+    : tracing(false)
+    , origin(std::chrono::steady_clock::now())
+    , droppedEvents(0) {
+}
+
+Profiler& Profiler::instance() {
+    static Profiler profiler;
+    return profiler;
+}
+
+void Profiler::enable(const std::string& basePath, bool trace) {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->basePath = basePath;
+        this->tracing = trace;
+    }
+    reset();
+    enabled.store(true, std::memory_order_relaxed);
+}
+
+void Profiler::disable() {
+    enabled.store(false, std::memory_order_relaxed);
+}
+
+void Profiler::reset() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    for (auto& counter : counters) {
+        counter.store(0, std::memory_order_relaxed);
+    }
+    this->byName.clear();
+    this->events.clear();
+    this->droppedEvents = 0;
+    this->origin = std::chrono::steady_clock::now();
+}
+
+// Small ids for the trace, in the order threads first record something
+static std::uint32_t threadNumber() {
+    static std::atomic<std::uint32_t> next { 0 };
+    thread_local std::uint32_t number = next.fetch_add(1);
+    return number;
+}
+
+void Profiler::record(const std::string& name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+    auto ns = [](std::chrono::steady_clock::duration d) {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+    };
+    std::uint64_t duration = ns(end - start);
+    std::uint32_t thread = threadNumber();
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    Timer& timer = this->byName[name];
+    timer.calls++;
+    timer.totalNs += duration;
+    timer.minNs = std::min(timer.minNs, duration);
+    timer.maxNs = std::max(timer.maxNs, duration);
+    if (this->tracing) {
+        if (this->events.size() < MAX_EVENTS) {
+            this->events.push_back({ name, thread, ns(start - this->origin), duration });
+        } else {
+            this->droppedEvents++;
+        }
+    }
+}
+
+std::uint64_t Profiler::get(Counter counter) const {
+    return counters[static_cast<std::size_t>(counter)].load(std::memory_order_relaxed);
+}
+
+std::unordered_map<std::string, Profiler::Timer> Profiler::timers() const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->byName;
+}
+
+const char* Profiler::name(Counter counter) {
+    switch (counter) {
+    case Counter::Battles:
+        return "battles";
+    case Counter::RandomDraws:
+        return "randomDraws";
+    case Counter::Allocations:
+        return "allocations";
+    case Counter::Notifications:
+        return "notifications";
+    }
+    return "";
+}
+
+// Timers sorted by total time, the most expensive first
+static std::vector<std::pair<std::string, Profiler::Timer>> sorted(const std::unordered_map<std::string, Profiler::Timer>& timers) {
+    std::vector<std::pair<std::string, Profiler::Timer>> result(timers.begin(), timers.end());
+    std::sort(result.begin(), result.end(), [](const auto& a, const auto& b) {
+        return a.second.totalNs > b.second.totalNs;
+    });
+    return result;
+}
+
+static std::string escape(const std::string& s) {
+    std::string escaped;
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+void Profiler::writeJson(std::ostream& out) const {
+    out << "{\n  \"timers\": [";
+    bool first = true;
+    for (const auto& [name, timer] : sorted(timers())) {
+        out << (first ? "\n" : ",\n")
+            << "    {\"name\": \"" << escape(name) << "\""
+            << ", \"calls\": " << timer.calls
+            << ", \"totalUs\": " << timer.totalNs / 1000
+            << ", \"meanUs\": " << timer.totalNs / timer.calls / 1000
+            << ", \"minUs\": " << timer.minNs / 1000
+            << ", \"maxUs\": " << timer.maxNs / 1000 << "}";
+        first = false;
+    }
+    out << "\n  ],\n  \"counters\": {";
+    for (std::size_t i = 0; i < COUNTERS; i++) {
+        Counter counter = static_cast<Counter>(i);
+        out << (i == 0 ? "\n" : ",\n")
+            << "    \"" << name(counter) << "\": " << get(counter);
+    }
+    out << "\n  }\n}\n";
+}
+
+void Profiler::writeCsv(std::ostream& out) const {
+    out << "kind,name,calls,total_us,mean_us,min_us,max_us\n";
+    for (const auto& [name, timer] : sorted(timers())) {
+        out << "timer,\"" << name << "\"," << timer.calls
+            << ',' << timer.totalNs / 1000
+            << ',' << timer.totalNs / timer.calls / 1000
+            << ',' << timer.minNs / 1000
+            << ',' << timer.maxNs / 1000 << '\n';
+    }
+    for (std::size_t i = 0; i < COUNTERS; i++) {
+        Counter counter = static_cast<Counter>(i);
+        out << "counter," << name(counter) << ',' << get(counter) << ",,,,\n";
+    }
+}
+
+// Complete events ("ph": "X"), with times in microseconds
+void Profiler::writeTrace(std::ostream& out) const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    bool first = true;
+    for (const auto& event : this->events) {
+        out << (first ? "\n" : ",\n")
+            << "{\"name\": \"" << escape(event.name) << "\", \"ph\": \"X\", \"pid\": 1"
+            << ", \"tid\": " << event.thread
+            << ", \"ts\": " << std::fixed << std::setprecision(3) << event.startNs / 1000.0
+            << ", \"dur\": " << event.durationNs / 1000.0 << "}";
+        first = false;
+    }
+    out << "\n], \"otherData\": {\"droppedEvents\": " << this->droppedEvents << "}}\n";
+}
+
+void Profiler::report() const {
+    if (!isEnabled()) {
+        return;
+    }
+    std::string basePath;
+    bool trace;
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        basePath = this->basePath;
+        trace = this->tracing;
+    }
+
+    std::ofstream json(basePath + ".json");
+    writeJson(json);
+    std::ofstream csv(basePath + ".csv");
+    writeCsv(csv);
+    if (trace) {
+        std::ofstream events(basePath + ".trace.json");
+        writeTrace(events);
+    }
+    std::cout << "Profile written to " << basePath << ".json" << std::endl;
+}
+
+std::ostream& operator<<(std::ostream& out, const Profiler& profiler) {
+    out << "This Profiler is " << (Profiler::isEnabled() ? "enabled" : "disabled") << ".";
+    for (const auto& [name, timer] : sorted(profiler.timers())) {
+        out << "\n  " << std::left << std::setw(32) << name << std::right
+            << std::setw(8) << timer.calls << " calls "
+            << std::setw(10) << timer.totalNs / 1000 << " us";
+    }
+    for (std::size_t i = 0; i < Profiler::COUNTERS; i++) {
+        Profiler::Counter counter = static_cast<Profiler::Counter>(i);
+        out << "\n  " << std::left << std::setw(32) << Profiler::name(counter) << std::right << std::setw(8) << profiler.get(counter);
+    }
+    return out;
+}
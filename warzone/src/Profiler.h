@@ -0,0 +1,140 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class Profiler
+ *
+ * @brief Process-wide timers and counters for the game loop.
+ *
+ * Timers are named scopes (phases, strategies, order types) aggregated into call count,
+ * total, minimum and maximum time. Counters track battles, random draws, allocations and
+ * observer notifications. When disabled, a scope or a counter costs one relaxed atomic load.
+ *
+ * The results can be written as JSON, CSV, or Chrome trace events (`chrome://tracing`, Perfetto).
+ */
+class Profiler {
+public:
+    /**
+     * @brief Things counted while profiling.
+     */
+    enum class Counter : char {
+        /** @brief Attacks resolved by AdvanceOrder. */
+        Battles,
+        /** @brief Numbers drawn from a random generator. */
+        RandomDraws,
+        /** @brief Calls to the global operator new. */
+        Allocations,
+        /** @brief Events Subject::notify delivered to observers. */
+        Notifications,
+    };
+    static constexpr std::size_t COUNTERS = 4;
+
+    /**
+     * @brief Aggregated time of a named scope.
+     */
+    struct Timer {
+        std::uint64_t calls = 0;
+        std::uint64_t totalNs = 0;
+        std::uint64_t minNs = UINT64_MAX;
+        std::uint64_t maxNs = 0;
+    };
+
+    /**
+     * @class Scope
+     *
+     * @brief Times the enclosing block, use PROFILE_SCOPE rather than constructing it directly.
+     */
+    class Scope {
+    public:
+        /**
+         * @brief Start timing, an empty name does nothing.
+         */
+        Scope(std::string name);
+        Scope(const Scope& other) = delete;
+        Scope& operator=(const Scope& other) = delete;
+        ~Scope();
+
+    private:
+        std::string name;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    static Profiler& instance();
+
+    static bool isEnabled() {
+        return enabled.load(std::memory_order_relaxed);
+    }
+    static void count(Counter counter, std::uint64_t amount = 1) {
+        if (isEnabled()) {
+            counters[static_cast<std::size_t>(counter)].fetch_add(amount, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Start profiling, reports are written to `<basePath>.json`, `<basePath>.csv`
+     * and, with tracing, `<basePath>.trace.json`.
+     */
+    void enable(const std::string& basePath, bool trace);
+    void disable();
+    void reset();
+
+    std::uint64_t get(Counter counter) const;
+    std::unordered_map<std::string, Timer> timers() const;
+
+    void writeJson(std::ostream& out) const;
+    void writeCsv(std::ostream& out) const;
+    void writeTrace(std::ostream& out) const;
+    /**
+     * @brief Write the report files, if profiling is enabled.
+     */
+    void report() const;
+
+    static const char* name(Counter counter);
+
+    friend std::ostream& operator<<(std::ostream& out, const Profiler& profiler);
+
+private:
+    /**
+     * @brief One timed scope for the trace.
+     */
+    struct Event {
+        std::string name;
+        std::uint32_t thread;
+        std::uint64_t startNs;
+        std::uint64_t durationNs;
+    };
+    /** @brief The trace stops growing past this many events. */
+    static constexpr std::size_t MAX_EVENTS = 1 << 20;
+
+    inline static std::atomic<bool> enabled { false };
+    inline static std::atomic<std::uint64_t> counters[COUNTERS] {};
+
+    Profiler();
+
+    mutable std::mutex mutex;
+    std::string basePath;
+    bool tracing;
+    std::chrono::steady_clock::time_point origin;
+    std::unordered_map<std::string, Timer> byName;
+    std::vector<Event> events;
+    std::size_t droppedEvents;
+
+    void record(const std::string& name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+/**
+ * @brief Time the rest of the block under the given name, which is only built when profiling.
+ */
+#define PROFILE_SCOPE(name) \
+    Profiler::Scope PROFILE_CONCAT(profileScope, __LINE__)(Profiler::isEnabled() ? std::string(name) : std::string())
@@ -0,0 +1,30 @@
+#include "QuietConsole.h"
+
+#include <cstddef>
+#include <iostream>
+#include <mutex>
+
+// The console is shared by the whole process, so the holders are counted across threads: the first
+// silences it and the last gives it back its buffer, whichever thread they run on
+static std::mutex mutex;
+static std::size_t holders = 0;
+static std::streambuf* console = nullptr;
+
+QuietConsole::QuietConsole() {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->outermost = holders++ == 0;
+    if (this->outermost) {
+        console = std::cout.rdbuf(nullptr);
+    }
+}
+
+QuietConsole::~QuietConsole() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (--holders == 0) {
+        std::cout.rdbuf(console);
+    }
+}
+
+std::ostream& operator<<(std::ostream& out, const QuietConsole& quiet) {
+    return out << "This QuietConsole keeps the console silent" << (quiet.outermost ? "" : ", which already was") << ".";
+}
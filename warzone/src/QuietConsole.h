@@ -0,0 +1,27 @@
+#pragma once
+
+#include <ostream>
+
+/**
+ * @class QuietConsole
+ *
+ * @brief Silences `std::cout` for as long as it lives, and gives it back its buffer when destroyed.
+ *
+ * Games print as they play, so whatever plays many of them at once, or headless, holds one of these
+ * around the games. The console is restored even if the games throw. Holders may nest and live on
+ * different threads, the console speaks again once the last of them is destroyed.
+ */
+class QuietConsole {
+public:
+    QuietConsole();
+    QuietConsole(const QuietConsole& other) = delete;
+    ~QuietConsole();
+
+    QuietConsole& operator=(const QuietConsole& other) = delete;
+
+    friend std::ostream& operator<<(std::ostream& out, const QuietConsole& quiet);
+
+private:
+    /** @brief Whether this holder silenced the console, rather than one living already. */
+    bool outermost;
+};
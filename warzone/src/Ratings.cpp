@@ -0,0 +1,272 @@
+#include "Ratings.h"
+#include "MapCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+double Ratings::Entry::rating() const {
+    return INITIAL_RATING + this->delta;
+}
+
+std::uint32_t Ratings::Entry::games() const {
+    return this->wins + this->draws + this->losses;
+}
+
+Ratings::Ratings()
+    : games(0)
+    , base(0)
+    , baseGames(0) {
+}
+
+// Score expected by a player rated `rating` against one rated `opponent`
+static double expected(double rating, double opponent) {
+    return 1.0 / (1.0 + std::pow(10.0, (opponent - rating) / 400.0));
+}
+
+void Ratings::record(const std::string& map, const std::vector<std::string>& strategies, std::optional<std::size_t> winner) {
+    // Seats of the same strategy share an entry, which plays once and wins if any of its seats won
+    std::vector<Entry*> players;
+    players.reserve(strategies.size());
+    std::optional<std::size_t> won;
+    for (std::size_t seat = 0; seat < strategies.size(); seat++) {
+        Entry* entry = &this->entries[{ strategies[seat], map }];
+        auto it = std::find(players.begin(), players.end(), entry);
+        if (winner == seat) {
+            won = static_cast<std::size_t>(it - players.begin());
+        }
+        if (it == players.end()) {
+            players.push_back(entry);
+        }
+    }
+
+    // Every pair is rated from the ratings before the game, so the order of the players does not matter
+    std::vector<double> changes(players.size(), 0.0);
+    for (std::size_t i = 0; i < players.size(); i++) {
+        for (std::size_t j = i + 1; j < players.size(); j++) {
+            double score = 0.5;
+            if (won == i) {
+                score = 1.0;
+            } else if (won == j) {
+                score = 0.0;
+            }
+            double change = K * (score - expected(players[i]->rating(), players[j]->rating()));
+            changes[i] += change;
+            changes[j] -= change;
+        }
+    }
+
+    for (std::size_t i = 0; i < players.size(); i++) {
+        players[i]->delta += changes[i];
+        if (!won) {
+            players[i]->draws++;
+        } else if (*won == i) {
+            players[i]->wins++;
+        } else {
+            players[i]->losses++;
+        }
+    }
+    this->games++;
+}
+
+void Ratings::merge(const Ratings& other) {
+    bool shared = this->base != 0 && this->base == other.base;
+    if (!shared && this->base != 0 && other.base != 0) {
+        throw std::runtime_error("Cannot merge ratings that continue different rating files");
+    }
+    // Of runs that continue the same base, only the games played on top of it are added
+    auto played = [shared](const Ratings& ratings, const std::pair<std::string, std::string>& key, Entry entry) {
+        auto base = ratings.baseEntries.find(key);
+        if (shared && base != ratings.baseEntries.end()) {
+            entry.wins -= base->second.wins;
+            entry.draws -= base->second.draws;
+            entry.losses -= base->second.losses;
+        }
+        return entry;
+    };
+    for (const auto& [key, entry] : other.entries) {
+        // Converged runs agree on a rating rather than add up to it, so the runs are averaged by their games
+        Entry& mine = this->entries[key];
+        std::uint32_t mineGames = played(*this, key, mine).games();
+        Entry theirs = played(other, key, entry);
+        std::uint32_t games = mineGames + theirs.games();
+        if (mineGames == 0) {
+            mine.delta = entry.delta;
+        } else if (games > 0) {
+            mine.delta = (mine.delta * mineGames + entry.delta * theirs.games()) / games;
+        }
+        mine.wins += theirs.wins;
+        mine.draws += theirs.draws;
+        mine.losses += theirs.losses;
+    }
+    this->games += other.games - (shared ? other.baseGames : 0);
+    if (this->base == 0 && other.base != 0) {
+        this->base = other.base;
+        this->baseEntries = other.baseEntries;
+        this->baseGames = other.baseGames;
+    }
+}
+
+void Ratings::rebase() {
+    std::uint64_t hash = 0;
+    if (this->games > 0) {
+        std::stringstream bytes;
+        write(bytes);
+        const std::string& file = bytes.str();
+        hash = MapCache::hash(file.data(), file.size());
+    }
+    this->base = hash;
+    this->baseEntries = this->entries;
+    this->baseGames = this->games;
+}
+
+std::uint64_t Ratings::getBase() const {
+    return this->base;
+}
+
+Ratings::Entry Ratings::get(const std::string& strategy, const std::string& map) const {
+    auto it = this->entries.find({ strategy, map });
+    return it == this->entries.end() ? Entry() : it->second;
+}
+
+std::size_t Ratings::size() const {
+    return this->entries.size();
+}
+
+std::uint64_t Ratings::getGames() const {
+    return this->games;
+}
+
+template <typename T>
+static void writeRaw(std::ostream& out, const T* data, std::size_t count) {
+    out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(sizeof(T) * count));
+}
+
+template <typename T>
+static void readRaw(std::istream& in, T* data, std::size_t count) {
+    if (!in.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(sizeof(T) * count))) {
+        throw std::runtime_error("Rating file is truncated");
+    }
+}
+
+// Appends the records of the entries to the string table and the records
+static void writeRecords(const std::map<std::pair<std::string, std::string>, Ratings::Entry>& entries, std::string& strings, std::vector<wzelo::Record>& records) {
+    for (const auto& [key, entry] : entries) {
+        wzelo::Record record {};
+        record.delta = entry.delta;
+        record.strategyOffset = static_cast<std::uint32_t>(strings.size());
+        record.strategyLength = static_cast<std::uint32_t>(key.first.size());
+        strings += key.first;
+        record.mapOffset = static_cast<std::uint32_t>(strings.size());
+        record.mapLength = static_cast<std::uint32_t>(key.second.size());
+        strings += key.second;
+        record.wins = entry.wins;
+        record.draws = entry.draws;
+        record.losses = entry.losses;
+        records.push_back(record);
+    }
+}
+
+static void readRecords(const std::vector<wzelo::Record>& records, const std::string& strings, std::map<std::pair<std::string, std::string>, Ratings::Entry>& entries) {
+    for (const wzelo::Record& record : records) {
+        if (std::uint64_t(record.strategyOffset) + record.strategyLength > strings.size()
+            || std::uint64_t(record.mapOffset) + record.mapLength > strings.size()) {
+            throw std::runtime_error("Rating file has a name out of its string table");
+        }
+        Ratings::Entry& entry = entries[{ strings.substr(record.strategyOffset, record.strategyLength), strings.substr(record.mapOffset, record.mapLength) }];
+        entry.delta = record.delta;
+        entry.wins = record.wins;
+        entry.draws = record.draws;
+        entry.losses = record.losses;
+    }
+}
+
+void Ratings::write(std::ostream& out) const {
+    std::string strings;
+    std::vector<wzelo::Record> records;
+    records.reserve(this->entries.size() + this->baseEntries.size());
+    writeRecords(this->entries, strings, records);
+    writeRecords(this->baseEntries, strings, records);
+
+    wzelo::Header header {};
+    std::memcpy(header.magic, wzelo::MAGIC, sizeof(header.magic));
+    header.byteOrder = wzelo::ENDIAN_MARK;
+    header.version = wzelo::VERSION;
+    header.records = static_cast<std::uint32_t>(this->entries.size());
+    header.stringBytes = static_cast<std::uint32_t>(strings.size());
+    header.baseRecords = static_cast<std::uint32_t>(this->baseEntries.size());
+    header.games = this->games;
+    header.base = this->base;
+    header.baseGames = this->baseGames;
+
+    writeRaw(out, &header, 1);
+    writeRaw(out, records.data(), records.size());
+    out.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+}
+
+void Ratings::read(std::istream& in) {
+    wzelo::Header header;
+    readRaw(in, &header, 1);
+    if (std::memcmp(header.magic, wzelo::MAGIC, sizeof(header.magic)) != 0) {
+        throw std::runtime_error("Not a rating file");
+    }
+    if (header.byteOrder != wzelo::ENDIAN_MARK || header.version != wzelo::VERSION) {
+        throw std::runtime_error("Rating file from another byte order or version");
+    }
+    std::vector<wzelo::Record> records(header.records);
+    readRaw(in, records.data(), records.size());
+    std::vector<wzelo::Record> baseRecords(header.baseRecords);
+    readRaw(in, baseRecords.data(), baseRecords.size());
+    std::string strings(header.stringBytes, '\0');
+    readRaw(in, strings.data(), strings.size());
+
+    Ratings read;
+    readRecords(records, strings, read.entries);
+    readRecords(baseRecords, strings, read.baseEntries);
+    read.games = header.games;
+    read.base = header.base;
+    read.baseGames = header.baseGames;
+    merge(read);
+}
+
+void Ratings::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (in.is_open()) {
+        read(in);
+    }
+}
+
+void Ratings::save(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        throw std::runtime_error("Cannot open " + path + " for writing");
+    }
+    write(out);
+}
+
+std::string Ratings::mapName(const std::string& path) {
+    std::size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+std::ostream& operator<<(std::ostream& out, const Ratings& ratings) {
+    out << "These Ratings hold " << ratings.size() << " strategies on maps over " << ratings.getGames() << " games.";
+
+    std::vector<std::pair<std::pair<std::string, std::string>, Ratings::Entry>> ladder(ratings.entries.begin(), ratings.entries.end());
+    std::stable_sort(ladder.begin(), ladder.end(), [](const auto& a, const auto& b) {
+        if (a.first.second != b.first.second) {
+            return a.first.second < b.first.second;
+        }
+        return a.second.delta > b.second.delta;
+    });
+    for (const auto& [key, entry] : ladder) {
+        out << "\n  " << std::left << std::setw(24) << key.second << std::setw(12) << key.first << std::right
+            << std::fixed << std::setprecision(1) << std::setw(8) << entry.rating() << std::defaultfloat
+            << std::setw(8) << entry.wins << " won" << std::setw(8) << entry.draws << " drawn" << std::setw(8) << entry.losses << " lost";
+    }
+    return out;
+}
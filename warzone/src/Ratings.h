@@ -0,0 +1,162 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Layout of a `.wzelo` rating file.
+ *
+ * Integers are 32 bits in native byte order, but for the totals of games and the base, and the
+ * rating updates are doubles: header, one record per strategy and map, the records of the base,
+ * then the string table holding every name back to back.
+ *
+ * The base is the file a run started from, identified by the hash of its bytes, 0 for none. Its
+ * records are kept so runs that started from the same file merge without counting it twice.
+ */
+namespace wzelo {
+/** @brief Magic bytes at the start of every rating file. */
+constexpr char MAGIC[4] = { 'W', 'Z', 'E', 'L' };
+/** @brief Written as-is so files from another byte order are rejected. */
+constexpr std::uint32_t ENDIAN_MARK = 0x01020304;
+constexpr std::uint32_t VERSION = 2;
+
+struct Header {
+    char magic[4];
+    std::uint32_t byteOrder;
+    std::uint32_t version;
+    std::uint32_t records;
+    std::uint32_t stringBytes;
+    std::uint32_t baseRecords;
+    std::uint64_t games;
+    std::uint64_t base;
+    std::uint64_t baseGames;
+};
+
+struct Record {
+    double delta;
+    std::uint32_t strategyOffset;
+    std::uint32_t strategyLength;
+    std::uint32_t mapOffset;
+    std::uint32_t mapLength;
+    std::uint32_t wins;
+    std::uint32_t draws;
+    std::uint32_t losses;
+    std::uint32_t reserved;
+};
+}
+
+/**
+ * @class Ratings
+ *
+ * @brief Elo ratings of the strategies on each map, updated one game at a time.
+ *
+ * A game updates the ratings of its players in O(players²), whatever the number of games
+ * recorded before, and each player is rated per map since a strategy can be strong on one
+ * map and weak on another. A game with more than two players counts as a match between every
+ * pair: the winner beats everyone else, and a draw is a draw between everyone.
+ *
+ * Each entry holds its rating and its games, so the stores of runs played in parallel merge
+ * entry by entry: the counts add up and the ratings are averaged, weighted by games. Each run
+ * only saw its own games, so the merge is an estimate, close to a single run once each run has
+ * played enough games for its ratings to settle; nothing is ever recomputed from the games.
+ *
+ * Runs that continue the same rating file all hold its games. Each remembers that file as its
+ * base, and merging runs of the same base only adds what each run played on top of it.
+ */
+class Ratings {
+public:
+    /** @brief Rating of a strategy before its first game on a map. */
+    static constexpr double INITIAL_RATING = 1500;
+    /** @brief Largest change of a rating in one game against one opponent. */
+    static constexpr double K = 24;
+
+    /**
+     * @brief Rating and record of a strategy on a map.
+     */
+    struct Entry {
+        /** @brief Distance of the rating from INITIAL_RATING. */
+        double delta = 0;
+        std::uint32_t wins = 0;
+        std::uint32_t draws = 0;
+        std::uint32_t losses = 0;
+
+        double rating() const;
+        std::uint32_t games() const;
+    };
+
+    Ratings();
+
+    /**
+     * @brief Update the ratings with the result of one game.
+     *
+     * @param map Name of the map, like `lp.map`.
+     * @param strategies Strategy of each player, players with the same strategy count as one player that wins if either does.
+     * @param winner Index of the winner in strategies, nothing for a draw.
+     */
+    void record(const std::string& map, const std::vector<std::string>& strategies, std::optional<std::size_t> winner);
+
+    /**
+     * @brief Add the games of another store and average the ratings of both, weighted by games.
+     *
+     * When both stores continue the same base, its games are counted once and the ratings are
+     * weighted by the games played on top of it.
+     * @throws std::runtime_error if the stores continue different bases.
+     */
+    void merge(const Ratings& other);
+
+    /**
+     * @brief Make the current ratings the base of the games recorded from now on, see merge.
+     */
+    void rebase();
+    /** @brief Hash of the rating file the games were recorded on top of, 0 for none. */
+    std::uint64_t getBase() const;
+
+    /**
+     * @brief Rating and record of a strategy on a map, a fresh entry if it never played there.
+     */
+    Entry get(const std::string& strategy, const std::string& map) const;
+    /** @brief Number of strategy and map pairs rated. */
+    std::size_t size() const;
+    /** @brief Games recorded, each counted once however many players it had. */
+    std::uint64_t getGames() const;
+
+    /**
+     * @brief Write the ratings in the `.wzelo` format.
+     */
+    void write(std::ostream& out) const;
+    /**
+     * @brief Read ratings written by write, adding them to this store.
+     *
+     * @throws std::runtime_error if the file is not a valid rating file.
+     */
+    void read(std::istream& in);
+    /**
+     * @brief Read a rating file if it exists, or keep the store empty.
+     */
+    void load(const std::string& path);
+    void save(const std::string& path) const;
+
+    /**
+     * @brief Name of the map of a path, `lp.map` for `res/map/lp.map`, the same wherever the maps are.
+     */
+    static std::string mapName(const std::string& path);
+
+    /**
+     * @brief Prints the ladder: every strategy on every map, best rated first.
+     */
+    friend std::ostream& operator<<(std::ostream& out, const Ratings& ratings);
+
+private:
+    /** @brief Entries by strategy and map, in order so files are written the same way each time. */
+    std::map<std::pair<std::string, std::string>, Entry> entries;
+    std::uint64_t games;
+    std::uint64_t base;
+    /** @brief Entries and games of the base. */
+    std::map<std::pair<std::string, std::string>, Entry> baseEntries;
+    std::uint64_t baseGames;
+};
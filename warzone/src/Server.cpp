@@ -0,0 +1,420 @@
+#include "Server.h"
+#include "GameEngine.h"
+#include "QuietConsole.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define WARZONE_HAS_EPOLL 1
+#endif
+
+void Server::Latency::add(std::uint64_t ns) {
+    this->commands++;
+    this->totalNs += ns;
+    this->maxNs = std::max(this->maxNs, ns);
+}
+
+void Server::Latency::add(const Latency& other) {
+    this->commands += other.commands;
+    this->totalNs += other.totalNs;
+    this->maxNs = std::max(this->maxNs, other.maxNs);
+}
+
+double Server::Latency::meanUs() const {
+    return this->commands == 0 ? 0.0 : this->totalNs / 1000.0 / this->commands;
+}
+
+static std::string describe(const Server::Latency& latency) {
+    std::stringstream out;
+    out << latency.commands << " commands, mean " << static_cast<long>(latency.meanUs())
+        << " us, max " << latency.maxNs / 1000 << " us";
+    return out.str();
+}
+
+#ifdef WARZONE_HAS_EPOLL
+
+static void nonBlocking(int fd) {
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+Server::Server(std::string path, std::size_t threads)
+    : path(std::move(path))
+    , listener(-1)
+    , epoll(-1)
+    , wakeup(-1)
+    , done(-1)
+    , running(false)
+    , hosted(0)
+    , pool(std::max<std::size_t>(1, threads)) {
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+    if (this->path.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Socket path too long: " + this->path);
+    }
+    std::strncpy(address.sun_path, this->path.c_str(), sizeof(address.sun_path) - 1);
+
+    this->listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    this->epoll = ::epoll_create1(0);
+    this->wakeup = ::eventfd(0, EFD_NONBLOCK);
+    this->done = ::eventfd(0, EFD_NONBLOCK);
+    if (this->listener < 0 || this->epoll < 0 || this->wakeup < 0 || this->done < 0) {
+        release();
+        throw std::runtime_error("Cannot create the server sockets");
+    }
+    ::unlink(this->path.c_str());
+    if (::bind(this->listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+        || ::listen(this->listener, BACKLOG) != 0) {
+        std::string error = std::strerror(errno);
+        release();
+        throw std::runtime_error("Cannot listen on " + this->path + ": " + error);
+    }
+    nonBlocking(this->listener);
+
+    epoll_event event {};
+    event.events = EPOLLIN;
+    event.data.fd = this->listener;
+    ::epoll_ctl(this->epoll, EPOLL_CTL_ADD, this->listener, &event);
+    event.data.fd = this->wakeup;
+    ::epoll_ctl(this->epoll, EPOLL_CTL_ADD, this->wakeup, &event);
+    event.data.fd = this->done;
+    ::epoll_ctl(this->epoll, EPOLL_CTL_ADD, this->done, &event);
+}
+
+Server::~Server() {
+    {
+        // Games still being played end here, they print as they go
+        QuietConsole quiet;
+        this->pool.wait();
+        this->connections.clear();
+    }
+    release();
+}
+
+void Server::release() {
+    for (auto& [fd, connection] : this->connections) {
+        ::close(fd);
+    }
+    for (int fd : { this->listener, this->epoll, this->wakeup, this->done }) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+    if (this->listener >= 0) {
+        ::unlink(this->path.c_str());
+    }
+    this->listener = this->epoll = this->wakeup = this->done = -1;
+}
+
+void Server::run() {
+    // Every game plays on the workers, none of them speaks to this console
+    QuietConsole quiet;
+    this->running = true;
+    while (this->running) {
+        poll(-1);
+    }
+    this->pool.wait();
+    collect();
+}
+
+std::size_t Server::poll(int timeoutMs) {
+    epoll_event events[64];
+    int ready = ::epoll_wait(this->epoll, events, 64, timeoutMs);
+    if (ready < 0) {
+        return 0;
+    }
+    for (int i = 0; i < ready; i++) {
+        int fd = events[i].data.fd;
+        if (fd == this->listener) {
+            accept();
+            continue;
+        }
+        if (fd == this->wakeup) {
+            std::uint64_t count;
+            while (::read(this->wakeup, &count, sizeof(count)) > 0) {
+            }
+            this->running = false;
+            continue;
+        }
+        if (fd == this->done) {
+            collect();
+            continue;
+        }
+        auto it = this->connections.find(fd);
+        if (it == this->connections.end()) {
+            continue;
+        }
+        Connection& connection = *it->second;
+        if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+            // Closed both ways, the answers cannot be read any more and the hangup would be reported again and again
+            connection.open = false;
+            connection.pending.clear();
+            connection.output.clear();
+            ::epoll_ctl(this->epoll, EPOLL_CTL_DEL, fd, nullptr);
+            connection.events = 0;
+        } else if (events[i].events & EPOLLIN && connection.open && !receive(connection)) {
+            // Nothing more to read, send stops watching for input and keeps watching to write the last answers
+            connection.open = false;
+        }
+        settle(connection);
+    }
+    return static_cast<std::size_t>(ready);
+}
+
+void Server::stop() {
+    std::uint64_t one = 1;
+    [[maybe_unused]] ssize_t written = ::write(this->wakeup, &one, sizeof(one));
+}
+
+void Server::accept() {
+    while (true) {
+        int fd = ::accept(this->listener, nullptr, nullptr);
+        if (fd < 0) {
+            return;
+        }
+        nonBlocking(fd);
+        epoll_event event {};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        ::epoll_ctl(this->epoll, EPOLL_CTL_ADD, fd, &event);
+
+        auto connection = std::make_unique<Connection>();
+        connection->fd = fd;
+        connection->game = std::make_unique<Game>();
+        connection->events = EPOLLIN;
+        connection->busy = false;
+        connection->open = true;
+        this->connections[fd] = std::move(connection);
+        this->hosted++;
+    }
+}
+
+bool Server::receive(Connection& connection) {
+    // A client may send its last commands and close its side at once, they are still answered
+    char buffer[READ_SIZE];
+    bool open = true;
+    while (open) {
+        ssize_t count = ::read(connection.fd, buffer, sizeof(buffer));
+        if (count == 0) {
+            open = false;
+            break;
+        }
+        if (count < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            open = false;
+            break;
+        }
+        connection.input.append(buffer, static_cast<std::size_t>(count));
+    }
+
+    std::size_t start = 0;
+    std::size_t end;
+    while ((end = connection.input.find('\n', start)) != std::string::npos) {
+        std::string line = connection.input.substr(start, end - start);
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        connection.pending.push_back(std::move(line));
+        start = end + 1;
+    }
+    connection.input.erase(0, start);
+    return open && connection.input.size() <= MAX_LINE;
+}
+
+void Server::dispatch(Connection& connection) {
+    if (connection.busy || connection.pending.empty()) {
+        return;
+    }
+    // One worker at a time per game, so its commands apply in order and the game needs no lock
+    connection.busy = true;
+    std::deque<std::string> lines;
+    lines.swap(connection.pending);
+    this->pool.submit([this, &connection, lines = std::move(lines)]() {
+        for (const std::string& line : lines) {
+            connection.answers += apply(connection, line);
+            connection.answers += '\n';
+        }
+        {
+            std::lock_guard<std::mutex> lock(this->finishedMutex);
+            this->finished.push_back(connection.fd);
+        }
+        std::uint64_t one = 1;
+        [[maybe_unused]] ssize_t written = ::write(this->done, &one, sizeof(one));
+    });
+}
+
+void Server::collect() {
+    std::uint64_t count;
+    while (::read(this->done, &count, sizeof(count)) > 0) {
+    }
+    std::vector<int> fds;
+    {
+        std::lock_guard<std::mutex> lock(this->finishedMutex);
+        fds.swap(this->finished);
+    }
+    for (int fd : fds) {
+        auto it = this->connections.find(fd);
+        if (it == this->connections.end()) {
+            continue;
+        }
+        Connection& connection = *it->second;
+        connection.busy = false;
+        connection.output += connection.answers;
+        connection.answers.clear();
+        settle(connection);
+    }
+}
+
+void Server::settle(Connection& connection) {
+    dispatch(connection);
+    if (!send(connection)) {
+        connection.open = false;
+        connection.pending.clear();
+    }
+    // The game is only deleted once no worker plays it, and the socket closed once its answers are written
+    if (!connection.open && !connection.busy && connection.pending.empty() && connection.output.empty()) {
+        close(connection.fd);
+    }
+}
+
+std::string Server::apply(Connection& connection, const std::string& line) {
+    if (line == "stats") {
+        return describe(connection.latency);
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::string effect = connection.game->applyCommand(line);
+    connection.latency.add(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()));
+    // One line per command, the lines of a question are kept on it
+    std::size_t newline = 0;
+    while ((newline = effect.find('\n', newline)) != std::string::npos) {
+        effect.replace(newline, 1, " | ");
+    }
+    return effect;
+}
+
+bool Server::send(Connection& connection) {
+    while (!connection.output.empty()) {
+        ssize_t count = ::send(connection.fd, connection.output.data(), connection.output.size(), MSG_NOSIGNAL);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                connection.output.clear();
+                return false;
+            }
+            break;
+        }
+        connection.output.erase(0, static_cast<std::size_t>(count));
+    }
+
+    // Wait for lines while the client may send them, and for the socket to be writable while there is something left to write
+    std::uint32_t events = (connection.open ? static_cast<std::uint32_t>(EPOLLIN) : 0u)
+        | (connection.output.empty() ? 0u : static_cast<std::uint32_t>(EPOLLOUT));
+    if (events != connection.events) {
+        epoll_event event {};
+        event.events = events;
+        event.data.fd = connection.fd;
+        ::epoll_ctl(this->epoll, EPOLL_CTL_MOD, connection.fd, &event);
+        connection.events = events;
+    }
+    return true;
+}
+
+void Server::close(int fd) {
+    auto it = this->connections.find(fd);
+    if (it == this->connections.end()) {
+        return;
+    }
+    this->closed.add(it->second->latency);
+    ::epoll_ctl(this->epoll, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    // Games print as they are deleted, into the console run silenced
+    this->connections.erase(it);
+}
+
+#else
+
+Server::Server(std::string path, std::size_t threads)
+    : path(std::move(path))
+    , listener(-1)
+    , epoll(-1)
+    , wakeup(-1)
+    , done(-1)
+    , running(false)
+    , hosted(0)
+    , pool(std::max<std::size_t>(1, threads)) {
+    throw std::runtime_error("The server needs epoll, which this platform does not have");
+}
+
+Server::~Server() { }
+
+void Server::release() { }
+
+void Server::run() { }
+
+std::size_t Server::poll(int) {
+    return 0;
+}
+
+void Server::stop() { }
+
+void Server::accept() { }
+
+bool Server::receive(Connection&) {
+    return false;
+}
+
+void Server::dispatch(Connection&) { }
+
+void Server::collect() { }
+
+void Server::settle(Connection&) { }
+
+std::string Server::apply(Connection&, const std::string&) {
+    return "";
+}
+
+bool Server::send(Connection&) {
+    return false;
+}
+
+void Server::close(int) { }
+
+#endif
+
+std::size_t Server::getGames() const {
+    return this->connections.size();
+}
+
+std::size_t Server::getGamesHosted() const {
+    return this->hosted;
+}
+
+Server::Latency Server::getLatency() const {
+    Latency latency = this->closed;
+    for (const auto& [fd, connection] : this->connections) {
+        latency.add(connection->latency);
+    }
+    return latency;
+}
+
+std::ostream& operator<<(std::ostream& out, const Server& server) {
+    return out << "This Server on " << server.path << " hosts " << server.getGames() << " games, "
+               << server.getGamesHosted() << " since it started, and served " << describe(server.getLatency()) << ".";
+}
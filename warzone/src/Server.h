@@ -0,0 +1,153 @@
+#pragma once
+
+#include "ThreadPool.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Game;
+
+/**
+ * @class Server
+ *
+ * @brief Hosts many independent games in one process, each driven by commands sent over a Unix domain socket.
+ *
+ * Every connection is one game. The client sends the commands it would type in the console, one per
+ * line (`loadmap`, `validatemap`, `addplayer <name> <strategy>`, `gamestart`, `play <turns>`), and reads one line back
+ * per command with its effect, see Game::applyCommand. Effects spanning lines, like the questions
+ * asked to human players, are joined with ` | `, and the lines after a question answer it.
+ * `stats` answers with the latency of the commands of that game so far. Closing the connection
+ * ends the game.
+ *
+ * A single thread serves every connection from an epoll loop and hands the commands to a small
+ * thread pool, one game at a time on one worker, so games never wait on each other's clients or
+ * turns. A game waiting for a human holds no thread, only its state. The games all load their
+ * maps from the same MapCache, and print nothing while run is serving.
+ *
+ * Only available where epoll is, Linux; elsewhere the constructor throws.
+ */
+class Server {
+public:
+    /** @brief Bytes read from a socket at once. */
+    static constexpr std::size_t READ_SIZE = 4096;
+    /** @brief Longest command line, a client sending a longer one is disconnected. */
+    static constexpr std::size_t MAX_LINE = 4096;
+    /** @brief Connections waiting to be accepted. */
+    static constexpr int BACKLOG = 512;
+
+    /**
+     * @brief Time spent applying the commands of a game.
+     */
+    struct Latency {
+        std::uint64_t commands = 0;
+        std::uint64_t totalNs = 0;
+        std::uint64_t maxNs = 0;
+
+        void add(std::uint64_t ns);
+        void add(const Latency& other);
+        double meanUs() const;
+    };
+
+    /**
+     * @brief Listen on the socket file at path, replacing a stale one, and play the games on that many threads.
+     *
+     * @throws std::runtime_error if the socket cannot be created, or epoll is not available.
+     */
+    Server(std::string path, std::size_t threads = ThreadPool::defaultSize());
+    Server(const Server& other) = delete;
+    Server& operator=(const Server& other) = delete;
+    /**
+     * @brief Close every connection, ending their games, and remove the socket file.
+     */
+    ~Server();
+
+    /**
+     * @brief Serve until stop is called.
+     */
+    void run();
+    /**
+     * @brief Wait up to timeoutMs for clients and serve whatever they sent.
+     *
+     * The commands received are applied by the workers, their answers are sent by a later poll.
+     * @return The number of events handled.
+     */
+    std::size_t poll(int timeoutMs);
+    /**
+     * @brief Make run return after the current events, safe to call from another thread.
+     */
+    void stop();
+
+    /** @brief Games currently hosted. */
+    std::size_t getGames() const;
+    /** @brief Games hosted since the start, finished or not. */
+    std::size_t getGamesHosted() const;
+    /** @brief Latency of every command served so far. */
+    Latency getLatency() const;
+
+    friend std::ostream& operator<<(std::ostream& out, const Server& server);
+
+private:
+    /**
+     * @brief A client and its game.
+     */
+    struct Connection {
+        int fd;
+        std::unique_ptr<Game> game;
+        /** @brief Bytes received after the last complete line. */
+        std::string input;
+        /** @brief Complete lines not yet handed to a worker. */
+        std::deque<std::string> pending;
+        /** @brief Responses not yet written to the socket. */
+        std::string output;
+        /** @brief Responses of the lines a worker applied, only touched by that worker while busy. */
+        std::string answers;
+        /** @brief Events the socket is waited on for, EPOLLIN while open and EPOLLOUT while output is left. */
+        std::uint32_t events;
+        /** @brief Whether a worker is applying lines to the game. */
+        bool busy;
+        /** @brief Whether the client may still send lines, the connection closes once they are answered and written. */
+        bool open;
+        Latency latency;
+    };
+
+    std::string path;
+    int listener;
+    int epoll;
+    /** @brief Written to by stop to wake up the loop. */
+    int wakeup;
+    /** @brief Written to by the workers when they applied lines. */
+    int done;
+    bool running;
+    std::unordered_map<int, std::unique_ptr<Connection>> connections;
+    std::size_t hosted;
+    /** @brief Latency of the commands of closed connections. */
+    Latency closed;
+    /** @brief Connections whose lines were applied, by socket. */
+    std::vector<int> finished;
+    std::mutex finishedMutex;
+    ThreadPool pool;
+
+    /** @brief Close the connections and the sockets. */
+    void release();
+    void accept();
+    /** @brief Read the commands received, return false if the client is gone. */
+    bool receive(Connection& connection);
+    /** @brief Hand the pending lines to a worker, unless one has them already. */
+    void dispatch(Connection& connection);
+    /** @brief Collect the answers of the workers. */
+    void collect();
+    /** @brief Dispatch, send and close the connection as far as it can go now. */
+    void settle(Connection& connection);
+    /** @brief Write what can be written and watch the socket for what is left, return false if the client is gone. */
+    bool send(Connection& connection);
+    std::string apply(Connection& connection, const std::string& line);
+    void close(int fd);
+};
@@ -0,0 +1,69 @@
+#include "ThreadPool.h"
+
+#include <ostream>
+
+ThreadPool::ThreadPool(std::size_t threads)
+    : pending(0)
+    , stopping(false) {
+    if (threads == 0) {
+        threads = 1;
+    }
+    this->workers.reserve(threads);
+    for (std::size_t i = 0; i < threads; i++) {
+        this->workers.emplace_back(&ThreadPool::work, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->available.notify_all();
+    for (auto& worker : this->workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::work() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->available.wait(lock, [this]() { return this->stopping || !this->tasks.empty(); });
+            if (this->tasks.empty()) {
+                return;
+            }
+            task = std::move(this->tasks.front());
+            this->tasks.pop();
+            this->pending++;
+        }
+        // Exceptions are stored in the task's future
+        task();
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->pending--;
+            if (this->pending == 0 && this->tasks.empty()) {
+                this->idle.notify_all();
+            }
+        }
+    }
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->idle.wait(lock, [this]() { return this->pending == 0 && this->tasks.empty(); });
+}
+
+std::size_t ThreadPool::size() const {
+    return this->workers.size();
+}
+
+std::size_t ThreadPool::defaultSize() {
+    std::size_t cores = std::thread::hardware_concurrency();
+    return cores == 0 ? 1 : cores;
+}
+
+std::ostream& operator<<(std::ostream& out, const ThreadPool& pool) {
+    return out << "This ThreadPool runs tasks on " << pool.size() << " threads.";
+}
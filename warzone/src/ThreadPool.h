@@ -0,0 +1,77 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @class ThreadPool
+ *
+ * @brief Fixed set of worker threads running submitted tasks in order.
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief Start the given number of workers, one per core by default.
+     */
+    ThreadPool(std::size_t threads = defaultSize());
+    ThreadPool(const ThreadPool& other) = delete;
+    /**
+     * @brief Run every queued task, then join the workers.
+     */
+    ~ThreadPool();
+
+    ThreadPool& operator=(const ThreadPool& other) = delete;
+
+    /**
+     * @brief Queue a task.
+     *
+     * @return Future holding the result of the task, or the exception it threw.
+     */
+    template <class F>
+    std::future<std::invoke_result_t<F>> submit(F&& task) {
+        using Result = std::invoke_result_t<F>;
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+        std::future<Result> future = packaged->get_future();
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->tasks.emplace([packaged]() { (*packaged)(); });
+        }
+        this->available.notify_one();
+        return future;
+    }
+
+    /**
+     * @brief Block until every queued task has finished.
+     */
+    void wait();
+
+    std::size_t size() const;
+
+    /**
+     * @brief Number of cores, at least 1.
+     */
+    static std::size_t defaultSize();
+
+    friend std::ostream& operator<<(std::ostream& out, const ThreadPool& pool);
+
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    /** @brief Tasks that are currently running. */
+    std::size_t pending;
+    bool stopping;
+    std::mutex mutex;
+    std::condition_variable available;
+    std::condition_variable idle;
+
+    void work();
+};
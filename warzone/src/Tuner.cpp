@@ -0,0 +1,200 @@
+#include "Tuner.h"
+#include "GameEngine.h"
+#include "MapCache.h"
+#include "Player.h"
+#include "ProcessRunner.h"
+#include "QuietConsole.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+// Range searched for each parameter
+struct Range {
+    double StrategyParameters::*parameter;
+    double min;
+    double max;
+};
+static const Range RANGES[] = {
+    { &StrategyParameters::cardChance, 0.0, 1.0 },
+    { &StrategyParameters::attackConfidence, 0.05, 0.99 },
+    { &StrategyParameters::deployShare, 0.05, 1.0 },
+    { &StrategyParameters::advanceShare, 0.0, 1.0 },
+};
+
+// One fifth of the offspring beating their parent keeps the step as it is
+static const double SUCCESS_RATE = 0.2;
+static const double WIDER = 1.22;
+static const double NARROWER = 0.82;
+
+std::size_t Tuner::Evaluation::games() const {
+    return this->wins + this->draws + this->losses;
+}
+
+double Tuner::Evaluation::score() const {
+    return games() == 0 ? 0.0 : (this->wins + this->draws / 2.0) / games();
+}
+
+std::pair<double, double> Tuner::Evaluation::interval() const {
+    return wilson(this->wins + this->draws / 2.0, games());
+}
+
+std::ostream& operator<<(std::ostream& out, const Tuner::Evaluation& evaluation) {
+    auto [lower, upper] = evaluation.interval();
+    return out << std::fixed << std::setprecision(3)
+               << "score " << evaluation.score() << " [" << lower << ", " << upper << "] over "
+               << evaluation.games() << " games (" << evaluation.wins << " won, " << evaluation.draws << " drawn, "
+               << evaluation.losses << " lost) with " << evaluation.parameters
+               << std::defaultfloat;
+}
+
+Tuner::Tuner(const Options& options)
+    : options(options)
+    , random(options.seed)
+    , played(0)
+    , seconds(0) {
+    if (this->options.maps.empty()) {
+        throw std::invalid_argument("Tuning needs at least one map");
+    }
+    if (this->options.processes == 0) {
+        this->options.processes = std::max(1u, std::thread::hardware_concurrency());
+    }
+    MapCache::instance().preload(this->options.maps);
+    for (const std::string& path : this->options.maps) {
+        this->maps.push_back(MapCache::instance().get(path));
+        if (!this->maps.back()->validate()) {
+            throw std::invalid_argument("Invalid map " + path);
+        }
+    }
+}
+
+std::pair<double, double> Tuner::wilson(double successes, std::size_t trials, double z) {
+    if (trials == 0) {
+        return { 0.0, 1.0 };
+    }
+    double n = static_cast<double>(trials);
+    double p = successes / n;
+    double z2 = z * z;
+    double center = (p + z2 / (2 * n)) / (1 + z2 / n);
+    double margin = z / (1 + z2 / n) * std::sqrt(p * (1 - p) / n + z2 / (4 * n * n));
+    return { std::max(0.0, center - margin), std::min(1.0, center + margin) };
+}
+
+std::string Tuner::playGame(const StrategyParameters& candidate, std::size_t game) const {
+    AggressivePlayer tuned;
+    tuned.setParameters(candidate);
+    Player* players[] = { new Player("candidate", tuned), new Player("baseline", AggressivePlayer()) };
+    if (game % 2) {
+        std::swap(players[0], players[1]);
+    }
+
+    Game* g = new Game(new Map(*this->maps[game % this->maps.size()]));
+    g->setSeed(this->options.seed + static_cast<std::uint32_t>(game));
+    g->setParallelOrders(false);
+    for (Player* p : players) {
+        g->addplayer(p);
+    }
+    g->gamestart();
+    g->transition(Game::GameState::FirstReinforcements);
+    Player* winner = g->mainGameLoop(this->options.turns);
+    std::string result = "draw";
+    if (winner) {
+        result = winner->getName() == "candidate" ? "win" : "loss";
+    }
+    delete g;
+    return result;
+}
+
+std::vector<Tuner::Evaluation> Tuner::evaluate(const std::vector<StrategyParameters>& candidates) {
+    std::size_t games = this->options.games;
+    auto start = std::chrono::steady_clock::now();
+    ProcessRunner runner(this->options.processes);
+    std::stringstream signature;
+    signature << "tune " << candidates.size() << " candidates seed " << this->options.seed;
+    std::vector<std::string> results = runner.run(signature.str(), candidates.size() * games, [&](std::size_t index) {
+        // Headless: the games print nothing, which is also much faster
+        QuietConsole quiet;
+        return playGame(candidates[index / games], index % games);
+    });
+    this->seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<Evaluation> evaluations(candidates.size());
+    for (std::size_t i = 0; i < candidates.size(); i++) {
+        evaluations[i].parameters = candidates[i];
+        for (std::size_t j = i * games; j < (i + 1) * games; j++) {
+            // A game whose worker kept crashing counts for nothing
+            if (results[j] == "win") {
+                evaluations[i].wins++;
+            } else if (results[j] == "draw") {
+                evaluations[i].draws++;
+            } else if (results[j] == "loss") {
+                evaluations[i].losses++;
+            }
+        }
+        this->played += evaluations[i].games();
+    }
+    return evaluations;
+}
+
+Tuner::Evaluation Tuner::evaluate(const StrategyParameters& candidate) {
+    return evaluate(std::vector<StrategyParameters> { candidate })[0];
+}
+
+StrategyParameters Tuner::mutate(const StrategyParameters& parent, double step) {
+    StrategyParameters child = parent;
+    std::normal_distribution<double> normal(0.0, step);
+    for (const Range& range : RANGES) {
+        double value = child.*range.parameter + normal(this->random) * (range.max - range.min);
+        child.*range.parameter = std::clamp(value, range.min, range.max);
+    }
+    return child;
+}
+
+Tuner::Evaluation Tuner::tune() {
+    Evaluation parent = evaluate(StrategyParameters());
+    std::cout << "Defaults: " << parent << std::endl;
+
+    double step = this->options.step;
+    for (std::size_t generation = 1; generation <= this->options.generations; generation++) {
+        std::vector<StrategyParameters> candidates;
+        for (std::size_t i = 0; i < this->options.offspring; i++) {
+            candidates.push_back(mutate(parent.parameters, step));
+        }
+        std::vector<Evaluation> offspring = evaluate(candidates);
+
+        std::size_t successes = 0;
+        const Evaluation* best = &offspring[0];
+        for (const Evaluation& child : offspring) {
+            successes += child.score() > parent.score();
+            if (child.score() > best->score()) {
+                best = &child;
+            }
+        }
+        if (best->score() > parent.score()) {
+            parent = *best;
+        }
+        step *= static_cast<double>(successes) / offspring.size() > SUCCESS_RATE ? WIDER : NARROWER;
+
+        std::cout << "Generation " << generation << ": " << parent << ", step " << step
+                  << ", " << static_cast<long>(gamesPerSecond()) << " games/s" << std::endl;
+    }
+    return parent;
+}
+
+std::size_t Tuner::getGames() const {
+    return this->played;
+}
+
+double Tuner::gamesPerSecond() const {
+    return this->seconds > 0 ? this->played / this->seconds : 0.0;
+}
+
+std::ostream& operator<<(std::ostream& out, const Tuner& tuner) {
+    return out << "This Tuner played " << tuner.getGames() << " games on " << tuner.maps.size() << " maps in "
+               << tuner.options.processes << " processes, " << static_cast<long>(tuner.gamesPerSecond()) << " games per second.";
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "PlayerStrategies.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @class Tuner
+ *
+ * @brief Self-play search for better StrategyParameters of the aggressive strategy.
+ *
+ * A candidate plays headless games against an aggressive player with the default parameters,
+ * half of them from each seat, in worker processes. Every candidate of a run plays the same
+ * seeds, so two candidates are compared on the same games rather than on their luck.
+ *
+ * The search is a (1+λ) evolution strategy: each generation mutates the best parameters so far
+ * into λ offspring, keeps the best offspring if it scores better, and widens the mutations when
+ * more than a fifth of the offspring beat their parent, narrows them otherwise.
+ *
+ * The search is only as good as the number of games it can afford, so the tuner counts the games
+ * it plays and reports them per second along with every result.
+ */
+class Tuner {
+public:
+    /**
+     * @brief Options of a tuning run.
+     */
+    struct Options {
+        /** @brief Maps the games are played on, in turn. */
+        std::vector<std::string> maps;
+        /** @brief Games played by each candidate. */
+        std::size_t games = 200;
+        /** @brief Turn limit of each game. */
+        std::size_t turns = 100;
+        /** @brief Number of generations of the search. */
+        std::size_t generations = 10;
+        /** @brief Candidates mutated from the parent each generation, the λ of the search. */
+        std::size_t offspring = 8;
+        /** @brief Initial standard deviation of the mutations, as a share of the range of each parameter. */
+        double step = 0.2;
+        /** @brief Seed of the games and of the mutations, the same seed gives the same search. */
+        std::uint32_t seed = 1;
+        /** @brief Worker processes playing the games, one per core if 0. */
+        std::size_t processes = 0;
+    };
+
+    /**
+     * @brief Games of one candidate against the defaults.
+     */
+    struct Evaluation {
+        StrategyParameters parameters;
+        std::size_t wins = 0;
+        std::size_t draws = 0;
+        std::size_t losses = 0;
+
+        std::size_t games() const;
+        /** @brief Share of the games won, draws counting as half a win. */
+        double score() const;
+        /** @brief 95% Wilson confidence interval of the score. */
+        std::pair<double, double> interval() const;
+
+        friend std::ostream& operator<<(std::ostream& out, const Evaluation& evaluation);
+    };
+
+    /**
+     * @brief Load and validate the maps.
+     *
+     * @throws std::invalid_argument if there is no map, or a map is invalid.
+     */
+    Tuner(const Options& options);
+    Tuner(const Tuner& other) = delete;
+    Tuner& operator=(const Tuner& other) = delete;
+
+    /**
+     * @brief Play the games of a candidate.
+     */
+    Evaluation evaluate(const StrategyParameters& candidate);
+
+    /**
+     * @brief Run the search from the default parameters, printing each generation, and return the best candidate.
+     */
+    Evaluation tune();
+
+    /** @brief Games played so far. */
+    std::size_t getGames() const;
+    /** @brief Games played per second of evaluation so far. */
+    double gamesPerSecond() const;
+
+    /**
+     * @brief Wilson score interval of a proportion, which stays inside [0, 1] and is meaningful near 0 and 1.
+     *
+     * @param successes Number of successes, half successes allowed.
+     * @param trials Number of trials.
+     * @param z Quantile of the normal distribution, 1.96 for 95%.
+     */
+    static std::pair<double, double> wilson(double successes, std::size_t trials, double z = 1.96);
+
+    friend std::ostream& operator<<(std::ostream& out, const Tuner& tuner);
+
+private:
+    Options options;
+    std::vector<std::shared_ptr<const Map>> maps;
+    std::mt19937 random;
+    std::size_t played;
+    double seconds;
+
+    /**
+     * @brief Play the games of several candidates at once, so the workers always have games to play.
+     */
+    std::vector<Evaluation> evaluate(const std::vector<StrategyParameters>& candidates);
+    /**
+     * @brief Play one game and return "win", "draw" or "loss" for the candidate.
+     */
+    std::string playGame(const StrategyParameters& candidate, std::size_t game) const;
+    StrategyParameters mutate(const StrategyParameters& parent, double step);
+};
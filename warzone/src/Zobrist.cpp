@@ -0,0 +1,31 @@
+#include "Zobrist.h"
+
+#include <atomic>
+
+std::uint64_t Zobrist::mix(std::uint64_t x) {
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+std::uint64_t Zobrist::key(Feature feature, std::uint64_t a, std::uint64_t b) {
+    return mix(mix((static_cast<std::uint64_t>(feature) << 56) ^ a) ^ b);
+}
+
+std::uint32_t Zobrist::armyBucket(int armies) {
+    if (armies < 16) {
+        return armies < 0 ? 0 : static_cast<std::uint32_t>(armies);
+    }
+    std::uint32_t bucket = 12;
+    while (armies > 1) {
+        armies >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+std::uint64_t Zobrist::nextPlayerKey() {
+    static std::atomic<std::uint64_t> next { 0 };
+    return mix(next.fetch_add(1, std::memory_order_relaxed));
+}
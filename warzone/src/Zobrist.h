@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @class Zobrist
+ *
+ * @brief Keys of the 64-bit Zobrist hash of a game position.
+ *
+ * The hash of a position is the XOR of one key per feature: the owner and the army bucket of
+ * every territory, the pool and the cards of every player, and the parity of the turn. Changing
+ * a feature XORs its old key out and its new key in, so the hash follows every move in constant
+ * time and equal positions get equal hashes, whatever moves led to them.
+ *
+ * Keys are derived from the feature by a mixing function instead of being drawn into tables,
+ * so they exist for maps and games of any size and are the same in every run.
+ */
+class Zobrist {
+public:
+    enum class Feature : std::uint8_t {
+        /** @brief A territory (by index) held by a player (by key). */
+        Owner,
+        /** @brief A territory (by index) with armies in a bucket. */
+        Armies,
+        /** @brief A player (by key) with armies in the pool. */
+        Pool,
+        /** @brief A player (by key) with a hand (by its hash). */
+        Cards,
+        /** @brief Number of cards of a type in a hand. */
+        Card,
+        /** @brief A player by its seat in the game. */
+        Player,
+        /** @brief Odd turns. */
+        Turn,
+    };
+
+    /**
+     * @brief Key of a feature with its two values.
+     */
+    static std::uint64_t key(Feature feature, std::uint64_t a, std::uint64_t b = 0);
+
+    /**
+     * @brief Bucket of an army count, exact up to 15 then one bucket per power of two.
+     *
+     * Large stacks that only differ by a few armies count as the same position.
+     */
+    static std::uint32_t armyBucket(int armies);
+
+    /**
+     * @brief A new key identifying a player outside of a game, a game gives its players keys by seat.
+     */
+    static std::uint64_t nextPlayerKey();
+
+    /**
+     * @brief The splitmix64 finalizer, a bijection that spreads every input bit over the output.
+     */
+    static std::uint64_t mix(std::uint64_t x);
+};